@@ -203,6 +203,19 @@ fun AppSettingsScreen(
                                         }
                                     )
                                 },
+                                {
+                                    ExpressiveDropdownItem(
+                                        icon = Icons.Rounded.NetworkCheck,
+                                        title = "Low Latency Network",
+                                        summary = "Prioritize game traffic and keep Wi-Fi awake",
+                                        items = booleanModes,
+                                        selectedIndex = getBoolIndex(displayConfig.net_latency),
+                                        onItemSelected = { index ->
+                                            val value = listOf("default", "true", "false")[index]
+                                            packageName?.let { viewModel.updateSetting(it, "net_latency", value) }
+                                        }
+                                    )
+                                },
                                 {
                                     ExpressiveDropdownItem(
                                         icon = Icons.Rounded.Refresh,
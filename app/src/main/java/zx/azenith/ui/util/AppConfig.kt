@@ -9,5 +9,8 @@ data class AppConfig(
     val app_priority: String = "default",
     val game_preload: String = "default",
     val refresh_rate: String = "default",
-    val renderer: String = "default"
+    val renderer: String = "default",
+    val net_latency: String = "default",
+    val game_process: String = "default",
+    val helper_processes: String = "default"
 )
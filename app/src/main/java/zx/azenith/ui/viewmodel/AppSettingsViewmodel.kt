@@ -96,6 +96,7 @@ class AppSettingsViewModel : ViewModel() {
             "game_preload" -> currentAppConfig.copy(game_preload = value)
             "refresh_rate" -> currentAppConfig.copy(refresh_rate = value)
             "renderer" -> currentAppConfig.copy(renderer = value)
+            "net_latency" -> currentAppConfig.copy(net_latency = value)
             else -> currentAppConfig
         }
         
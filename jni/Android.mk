@@ -13,7 +13,32 @@ LOCAL_SRC_FILES := \
     src/game_preload.c \
     src/dumpsys.c \
     src/CLI.c \
-    src/mlbb_handler.c
+    src/game_procs.c \
+    src/cpu_topology.c \
+    src/thermal_governor.c \
+    src/event_loop.c \
+    src/bypass_charge.c \
+    src/daemon_stats.c \
+    src/freq_enforcer.c \
+    src/display_control.c \
+    src/profile_state.c \
+    src/profile_sim.c \
+    src/load_sampler.c \
+    src/input_boost.c \
+    src/gpu_controller.c \
+    src/cgroup_boost.c \
+    src/cpuset.c \
+    src/irq_steer.c \
+    src/vm_tune.c \
+    src/freezer.c \
+    src/blk_tune.c \
+    src/residency_guard.c \
+    src/session_rec.c \
+    src/boot_init.c \
+    src/state_tracker.c \
+    src/net_tune.c \
+    src/timer_wheel.c \
+    src/footprint.c
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/include
 
@@ -4,6 +4,7 @@
 #include <ctype.h>
 #include <dirent.h>
 #include <ftw.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,6 +26,131 @@
 #define MAX_PATH_LENGTH 256
 #define MAX_LINE 512
 #define MAX_PACKAGE 128
+#define MAX_CPUS 64
+#define MAX_CLUSTERS 8
+#define MAX_CLUSTER_FREQS 64
+#define MAX_THERMAL_ZONES 16
+#define MAX_EVENT_SOURCES 8
+
+#define THERMAL_TRIP_MC 46000
+#define THERMAL_HYST_MC 3000
+#define THERMAL_MAX_LEVEL 6
+#define THERMAL_STEP_PCT 6
+#define THERMAL_STEP_HOLD 3
+#define THERMAL_RELEASE_HOLD 6
+
+#define STATS_FLUSH_MS 10000
+
+#define TIMER_TICK_MS 100
+#define TIMER_LEVELS 4
+#define TIMER_SCREEN_OFF_MULT 4
+
+#define CMD_TIMEOUT_MS 15000
+#define CMD_LONG_TIMEOUT_MS 120000
+#define CMD_KILL_GRACE_MS 2000
+#define CMD_MAX_CONCURRENT 4
+#ifndef CMD_SHELL
+#define CMD_SHELL "/system/bin/sh" // the host tests build with /bin/sh
+#endif
+
+#define LOAD_WINDOW 8
+#define LOAD_HEAVY_ENTER 80
+#define LOAD_HEAVY_EXIT 60
+#define LOAD_IDLE_ENTER 10
+#define LOAD_IDLE_EXIT 20
+#define LOAD_GPU_HEAVY_ENTER 75
+#define LOAD_GPU_HEAVY_EXIT 55
+#define LOAD_GPU_IDLE_ENTER 10
+#define LOAD_GPU_IDLE_EXIT 20
+#define LOAD_HEAVY_HOLD 4
+#define LOAD_IDLE_HOLD 15
+#define LOAD_INTERACTIVE_HOLD 3
+
+#define INPUT_BOOST_FREQ_PCT 70
+#define INPUT_BOOST_UCLAMP 40
+#define INPUT_BOOST_STEPS 4
+#define INPUT_BOOST_STEP_MS 250
+#define INPUT_BOOST_RATE_MS 200
+
+#define MAX_GPU_FREQS 32
+#define GPU_TARGET_PCT 70
+#define GPU_UP_PCT 85
+#define GPU_DOWN_PCT 45
+#define GPU_UP_HOLD 2
+#define GPU_DOWN_HOLD 6
+
+#define CGROUP_BOOST_GROUP "azenith"
+#define MAX_CGROUP_SAVED 16
+
+#define NR_CPUSET_GROUPS 4
+
+#define MAX_IRQS 32
+
+#define MAX_FROZEN 128
+#define FREEZER_GROUP "azenith"
+#define FREEZER_MIN_ADJ 700 // PREVIOUS_APP_ADJ, cached and background services rank above
+#define FREEZER_SCREEN_OFF_MS (5 * 60 * 1000)
+#define FREEZER_RESCAN_MS 30000
+
+#define SESSION_MAGIC 0x53455a41 // "AZES"
+#define SESSION_VERSION 1
+#define SESSION_MAX_CLUSTERS 4
+#define SESSION_TOP_THREADS 4
+#define SESSION_CHARGING 0x01
+#define MAX_SESSION_THREADS 256
+#define SESSION_SAMPLE_MS 10000
+#define SESSION_MIN_POWER_MS 60000
+#define SESSION_MAX_RECORDS 64
+
+#define MAX_GUARD_FILES 64
+#define RESIDENCY_CHUNK_PAGES 64
+#define RESIDENCY_INTERVAL_MS 10000
+#define RESIDENCY_REWARM_KB 16384
+#define RESIDENCY_LOCK_AFTER 3
+
+#define MAX_BLK_DEVS 16
+#define MAX_BLK_SAVED 64
+#define BLK_LOAD_IDLE_KBPS 2048
+#define BLK_LOAD_IDLE_HOLD 5
+#define BLK_LOAD_MAX_MS 120000
+
+#define MAX_VM_SAVED 8
+#define VM_PSI_HIGH 1000 // 10.00% of time stalled
+#define VM_PSI_LOW 200
+#define VM_MAX_LEVEL 7
+#define VM_WMARK_STEP 10
+#define VM_STEP_HOLD 3
+#define VM_RELEASE_HOLD 10
+
+#define MAX_PROFILE_ACTIONS 4
+#define MAX_SIM_PROCS 32
+#define MAX_SIM_PROPS 16
+
+#define BYPASS_CURRENT_MA 10
+#define BYPASS_VERIFY_SAMPLES 3
+#define BYPASS_VERIFY_MS 5000
+#define BYPASS_MAX_ATTEMPTS 3
+#define BYPASS_MAX_SUPPLIES 8
+
+#define DISPLAY_HELPER "/system/bin/sh"
+#define DISPLAY_HELPER_TIMEOUT_MS 3000
+#define DISPLAY_CACHE_MS 10000
+
+#define MAX_SCREEN_NODES 4
+#define STATE_SCREEN_MS 200
+#define STATE_VERIFY_MS (5 * 60 * 1000)
+#define STATE_LOW_POWER_TTL_MS 60000
+
+#define MAX_GAME_HELPERS 16
+#define MAX_HELPER_PATTERNS 256
+#define GAME_PROCS_RESCAN_MS 5000
+
+#define MAX_NET_SAVED 64
+#define NET_CHAIN "azenith_net"
+#define NET_CHAIN_MARKER "/dev/.azenith_net_chain" // tmpfs, gone on reboot like the chain
+
+#define FOOTPRINT_GROUP "azenith_daemon"
+#define FOOTPRINT_DATA_MB 128
 
 #define NOTIFY_TITLE "AZenith"
 #define LOG_TAG "AZenith"
@@ -34,8 +160,14 @@
 #define LOG_FILE_PRELOAD "/data/adb/.config/AZenith/preload/AZenithPR.log"
 #define PROFILE_MODE "/data/adb/.config/AZenith/API/current_profile"
 #define GAME_INFO "/data/adb/.config/AZenith/API/gameinfo"
+#define DAEMON_STATS "/data/adb/.config/AZenith/API/daemon_stats"
+#define SESSION_DIR "/data/adb/.config/AZenith/sessions"
 #define GAMELIST "/data/adb/.config/AZenith/gamelist/azenithApplist.json"
 #define MODULE_PROP "/data/adb/modules/AZenith/module.prop"
+#define CPUFREQ_PATH "/sys/devices/system/cpu/cpufreq"
+#define THERMAL_PATH "/sys/class/thermal"
+#define PPM_MAX_FREQ "/proc/ppm/policy/hard_userlimit_max_cpu_freq"
+#define PPM_MIN_FREQ "/proc/ppm/policy/hard_userlimit_min_cpu_freq"
 #define MODULE_UPDATE "/data/adb/modules/AZenith/update"
 #define MODULE_VERSION ".placeholder"
 #define IS_TRUE(v)    ((v) && strcmp((v), "true") == 0)
@@ -45,10 +177,6 @@
     "PATH=/system/bin:/system/xbin:/data/adb/ap/bin:/data/adb/ksu/bin:/data/adb/magisk:/debug_ramdisk:/sbin:/sbin/su:/su/bin:/su/" \
     "xbin:/data/data/com.termux/files/usr/bin"
 
-#define IS_MLBB(gamestart)                                                                               \
-    (strcmp(gamestart, "com.mobile.legends") == 0 || strcmp(gamestart, "com.mobilelegends.hwag") == 0 || \
-     strcmp(gamestart, "com.mobiin.gp") == 0 || strcmp(gamestart, "com.mobilechess.gp") == 0)
-
 #define IS_AWAKE(state) (strcmp(state, "Awake") == 0 || strcmp(state, "true") == 0)
 #define IS_LOW_POWER(state) (strcmp(state, "true") == 0 || strcmp(state, "1") == 0)
 
@@ -60,6 +188,9 @@ typedef struct {
     char game_preload[16];
     char refresh_rate[16];
     char renderer[16];
+    char net_latency[16];
+    char game_process[MAX_PACKAGE]; // pattern of the process that renders, ':' prefix appends to the package
+    char helper_processes[MAX_HELPER_PATTERNS]; // comma separated patterns boosted along with it
 } GameOptions;
 
 typedef enum : char {
@@ -78,10 +209,205 @@ typedef enum : char {
 } ProfileMode;
 
 typedef enum : char {
-    MLBB_NOT_RUNNING,
-    MLBB_RUN_BG,
-    MLBB_RUNNING
-} MLBBState;
+    GAME_NOT_TRACKED,
+    GAME_RUN_BG,
+    GAME_RUNNING
+} GameProcState;
+
+// Processes of the running game, helpers stay in discovery order
+typedef struct {
+    char package[MAX_PACKAGE];
+    pid_t main;
+    int nr_helpers;
+    pid_t helpers[MAX_GAME_HELPERS];
+} GameProcs;
+
+typedef enum : char {
+    BYPASS_IDLE,
+    BYPASS_VERIFYING,
+    BYPASS_ENGAGED,
+    BYPASS_FAILED
+} BypassState;
+
+typedef enum : char {
+    ACTION_GAME_EXITED,
+    ACTION_PID_LOST,
+    ACTION_AI_TOGGLED,
+    ACTION_INITIALIZED,
+    ACTION_APPLY_PERFORMANCE,
+    ACTION_APPLY_ECO,
+    ACTION_APPLY_BALANCED,
+    ACTION_LOAD_PERFORMANCE,
+    ACTION_LOAD_ECO
+} ProfileAction;
+
+typedef enum : char {
+    LOAD_IDLE,
+    LOAD_INTERACTIVE,
+    LOAD_HEAVY
+} LoadClass;
+
+typedef enum : char {
+    CPUSET_TOP_APP,
+    CPUSET_FOREGROUND,
+    CPUSET_BACKGROUND,
+    CPUSET_SYSTEM_BACKGROUND
+} CpusetGroup;
+
+typedef enum : char {
+    IRQ_OTHER,
+    IRQ_TOUCH,
+    IRQ_GPU,
+    IRQ_STORAGE
+} IrqClass;
+
+typedef void (*EventHandler)(int fd);
+typedef void (*TimerFn)(void);
+
+// Owned by the caller, the wheel only links it in while armed
+typedef struct Timer {
+    const char* name;
+    TimerFn fn;
+    int period_ms; // 0 for one-shot
+    int slack_ms; // may run this much later to share a wakeup
+    bool stretch; // longer period and slack while the screen is off
+    bool active;
+    bool in_flight; // taken off the wheel to run in the current dispatch
+    int64_t soft_ms;
+    uint64_t expires; // tick of soft_ms + slack_ms
+    uint8_t level;
+    uint8_t slot;
+    struct Timer* next;
+    struct Timer* pull;
+    struct Timer* batch; // due list of the current dispatch
+} Timer;
+
+typedef struct {
+    int policy;
+    uint64_t cpu_mask;
+    int cpuinfo_min;
+    int cpuinfo_max;
+    int nr_freqs;
+    int freqs[MAX_CLUSTER_FREQS];
+} CpuCluster;
+
+typedef struct {
+    int trip_mc;
+    int level;
+    int hold;
+} ThermalCtl;
+
+typedef struct {
+    uint64_t freq_enforce_writes;
+    uint64_t freq_enforce_conflicts;
+    uint64_t load_samples;
+    uint64_t load_sampler_cpu_us;
+    uint64_t input_boosts;
+    uint64_t input_boost_suppressed;
+    uint64_t gpu_floor_changes;
+    uint64_t mem_stall_some_us; // reported in ms, per-tick deltas are often below 1ms
+    uint64_t mem_stall_full_us;
+    uint64_t session_stall_some_us; // current or last game session
+    uint64_t session_stall_full_us;
+    uint64_t vm_adjustments;
+    uint64_t procs_frozen;
+    uint64_t blk_loads;
+    uint64_t blk_load_read_kbps; // last game load
+    uint64_t blk_load_read_lat_us;
+    uint64_t sessions_recorded;
+    uint64_t init_ms;
+    uint64_t boot_to_profile_ms;
+    uint64_t cmd_runs;
+    uint64_t cmd_timeouts;
+    uint64_t cmd_hangs; // ignored SIGTERM, needed SIGKILL
+    uint64_t wakeups;
+    uint64_t wakeups_per_min; // over the last flush interval
+    uint64_t timer_fires;
+    uint64_t forks; // besides cmd_runs
+    uint64_t self_rss_kb;
+    uint64_t self_cpu_ms;
+    uint64_t child_cpu_ms; // reaped children only
+} DaemonStats;
+
+// One game session as appended to SESSION_DIR/<package>.bin
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t flags;
+    uint8_t nr_clusters;
+    int64_t start; // unix time
+    uint32_t duration_ms;
+    uint32_t features; // toggles enabled at session start
+    uint32_t game_cpu_ms;
+    uint32_t throttle_ms; // any cluster capped below cpuinfo_max_freq
+    uint32_t psi_some_ms[3]; // cpu, memory, io
+    uint32_t read_kb;
+    uint32_t write_kb;
+    int32_t avg_power_mw; // 0 when unknown
+    int32_t temp_start_mc;
+    int32_t temp_peak_mc;
+    int32_t temp_end_mc;
+    uint32_t avg_khz[SESSION_MAX_CLUSTERS];
+    uint8_t top_pct[SESSION_MAX_CLUSTERS]; // share of time at the highest frequency
+    uint32_t thread_ms[SESSION_TOP_THREADS];
+    char thread_name[SESSION_TOP_THREADS][16];
+} SessionRecord;
+
+typedef struct {
+    int level;
+    int hold;
+} VmCtl;
+
+typedef struct {
+    int floor_idx;
+    int up_hold;
+    int down_hold;
+} GpuCtl;
+
+typedef struct {
+    uint64_t mask[NR_CPUSET_GROUPS];
+} CpusetPlan;
+
+typedef struct {
+    int irq;
+    IrqClass cls;
+    char path[MAX_PATH_LENGTH + 48]; // root prefix + /proc/irq/N/smp_affinity_list
+    char saved[64]; // smp_affinity_list before steering
+} IrqEntry;
+
+typedef struct {
+    LoadClass cur;
+    LoadClass pending;
+    int hold;
+} LoadClassifier;
+
+// Everything the profile state machine asks the outside world
+typedef struct {
+    char* (*get_gamestart)(GameOptions* options);
+    pid_t (*pidof)(const char* name);
+    bool (*pid_alive)(pid_t pid);
+    GameProcState (*game_state)(const char* gamestart, const GameOptions* opts, pid_t* pid);
+    bool (*screen_on)(void);
+    bool (*low_power)(void);
+    int (*getprop)(const char* name, char* value);
+    int64_t (*clock_ms)(void);
+    LoadClass (*load_class)(void);
+} ProfileEnv;
+
+typedef struct {
+    ProfileMode cur_mode;
+    bool need_profile_checkup;
+    bool initialized;
+    bool load_boosted; // performance picked by load, not by a game
+    char prev_ai_state[PROP_VALUE_MAX];
+    char* gamestart;
+    pid_t game_pid;
+    GameOptions opts;
+    char last_game[MAX_PACKAGE];
+    int64_t mode_since;
+    ProfileAction actions[MAX_PROFILE_ACTIONS];
+    int nr_actions;
+} ProfileState;
 
 extern char* gamestart;
 extern char* custom_log_tag;
@@ -99,28 +425,38 @@ int require_daemon_running(void);
 int handle_profile(int argc, char** argv);
 int handle_log(int argc, char** argv);
 int handle_verboselog(int argc, char** argv);
+int handle_stats(void);
+int handle_simulate(int argc, char** argv);
+int handle_bench_load(int argc, char** argv);
+int handle_cpuset_check(int argc, char** argv);
+int handle_sessions(int argc, char** argv);
+int handle_net_bench(int argc, char** argv);
 
 // Misc Utilities
 extern void GamePreload(const char* package);
 void sighandler(const int signal);
+bool sighandler_init(EventHandler handler);
+int sighandler_take(int fd);
 char* trim_newline(char* string);
 void notify(const char* title, const char* fmt, const char* chrono, int timeout_ms, ...);
 void toast(const char* message);
-void is_kanged(void);
+bool is_kanged(void);
 void checkstate(void);
 char* timern(void);
 void setspid(void);
 bool return_true(void);
 bool return_false(void);
 void runthermalcore(void);
-void check_module_version(void);
+bool check_module_version(void);
 void runtask(void);
-int get_current_refresh_rate(void);
 
 // Shell and Command execution
 char* execute_command(const char* format, ...);
 char* execute_direct(const char* path, const char* arg0, ...);
 int systemv(const char* format, ...);
+int systemv_deadline(int timeout_ms, const char* format, ...);
+int systemv_idle(int timeout_ms, const char* format, ...);
+FILE* popen_deadline(int timeout_ms, const char* format, ...);
 
 // Utilities
 int check_running_state(void);
@@ -141,9 +477,170 @@ int uidof(pid_t pid);
 // Dumpsys
 char* get_visible_package(void);
 
-// Handler
-extern pid_t mlbb_pid;
-MLBBState handle_mlbb(const char* gamestart);
+// Game Processes
+extern GameProcs game_procs;
+void game_procs_init(const char* root);
+const char* game_proc_pattern(const char* pkg, const GameOptions* opts);
+bool game_proc_match(const char* pkg, const char* pattern, const char* name);
+GameProcState game_procs_track(const char* pkg, const GameOptions* opts);
+int game_procs_tick(void);
+
+// CPU Topology
+extern CpuCluster clusters[MAX_CLUSTERS];
+extern int nr_clusters;
+int cpu_topology_init(void);
+int read_int_file(const char* path, int fallback);
+uint64_t parse_cpu_list(const char* list);
+int cluster_floor_freq(const CpuCluster* c, int target);
+int cluster_nearest_freq(const CpuCluster* c, int target);
+
+// Thermal Governor
+bool thermal_governor_init(void);
+void thermal_governor_tick(void);
+void thermal_governor_reset(void);
+void thermal_governor_restore(void);
+bool thermal_zone_relevant(const char* type);
+void thermal_ctl_reset(ThermalCtl* c);
+int thermal_ctl_update(ThermalCtl* c, int hottest_mc);
+int thermal_ctl_cap(const CpuCluster* c, int level);
+
+// Event Loop
+int64_t now_ms(void);
+int event_loop_add(int fd, EventHandler handler);
+void event_loop_remove(int fd);
+void event_loop_once(int timeout_ms);
+
+// Timer Wheel
+bool timer_wheel_init(void);
+void timer_start(Timer* t, int delay_ms);
+void timer_stop(Timer* t);
+void timer_wheel_set_screen(bool on);
+
+// Bypass Charging
+bool bypass_charge_init(const char* root);
+void bypass_charge_tick(void);
+void bypass_feed_current(int ma);
+void bypass_handle_uevent(const char* buf, size_t len);
+BypassState bypass_charge_state(void);
+void bypass_charge_stop(void);
+
+// Daemon Stats
+extern DaemonStats stats;
+void stats_flush(bool force);
+
+// Frequency Enforcer
+bool freq_enforcer_init(void);
+void freq_enforcer_tick(ProfileMode mode);
+
+// Load Sampler
+bool load_sampler_init(void);
+LoadClass load_sampler_tick(void);
+LoadClass load_sampler_class(void);
+void load_classifier_reset(LoadClassifier* c);
+LoadClass load_classifier_update(LoadClassifier* c, int top, int gpu);
+
+// Input Boost
+bool input_boost_init(const char* root, const char* device);
+void input_boost_set_enabled(bool on);
+bool input_boost_active(void);
+
+// GPU Controller
+bool gpu_controller_init(const char* root);
+void gpu_controller_tick(void);
+void gpu_controller_stop(void);
+void gpu_ctl_reset(GpuCtl* c);
+int gpu_ctl_update(GpuCtl* c, const long* table, int count, int util, long cur_freq);
+
+// Cgroup Boost
+bool cgroup_boost_init(const char* root);
+void cgroup_boost_apply(ProfileMode mode, pid_t pid);
+void cgroup_boost_add(pid_t pid);
+void cgroup_boost_restore(void);
+
+// Cpuset Planner
+bool cpuset_init(const char* root);
+uint64_t cpuset_online_mask(void);
+char* cpu_mask_to_list(uint64_t mask, char* buf, size_t size);
+bool cpuset_plan(ProfileMode mode, uint64_t online, CpusetPlan* plan);
+const char* cpuset_validate(const CpusetPlan* plan, uint64_t online);
+bool cpuset_apply(ProfileMode mode);
+void cpuset_restore(void);
+
+// IRQ Steering
+int irq_steer_init(const char* root);
+IrqClass irq_classify(const char* desc);
+uint64_t irq_render_cpus(pid_t pid);
+void irq_steer_apply(ProfileMode mode, pid_t pid);
+void irq_steer_restore(void);
+
+// VM Tuning
+bool vm_tune_init(const char* root);
+void vm_tune_apply(ProfileMode mode);
+void vm_tune_tick(void);
+void vm_tune_restore(void);
+void vm_ctl_reset(VmCtl* c);
+int vm_ctl_update(VmCtl* c, int some_avg10);
+
+// Background Freezer
+bool freezer_init(const char* root);
+bool freezer_whitelisted(const char* process);
+int freezer_freeze(pid_t keep_pid);
+void freezer_thaw_all(void);
+void freezer_tick(bool gaming, bool screen_on, pid_t keep_pid);
+
+// Boot Init
+void boot_wait_completed(void);
+bool boot_init_run(void);
+void boot_report_first_profile(void);
+
+// Session Recorder
+bool session_rec_init(const char* root);
+void session_rec_begin(const char* game, pid_t game_pid);
+void session_rec_tick(void);
+void session_rec_end(void);
+
+// Residency Guard
+int residency_guard_start(const char* dir);
+void residency_guard_stop(void);
+void residency_guard_tick(void);
+
+// Block Tuning
+int blk_tune_init(const char* root);
+void blk_tune_apply(ProfileMode mode);
+void blk_tune_restore(void);
+void blk_tune_tick(void);
+void blk_load_begin(void);
+void blk_load_cancel(void);
+
+// Network Tuning
+void net_tune_init(const char* root, bool loopback);
+void net_tune_apply(int uid, pid_t pid);
+void net_tune_restore(void);
+
+// Daemon Footprint
+bool footprint_init(const char* root);
+void footprint_child_reset(void);
+void footprint_idle_child(void);
+void footprint_sample(void);
+
+// Profile State Machine
+extern const ProfileEnv profile_env_default;
+void profile_state_init(ProfileState* s, const ProfileEnv* env);
+void profile_state_step(ProfileState* s, const ProfileEnv* env);
+
+// Display Control
+bool display_helper_start(const char* path);
+void display_helper_stop(void);
+int display_get_refresh_rate(void);
+bool display_set_refresh_rate(int rate);
+void display_save_refresh_rate(void);
+void display_restore_refresh_rate(void);
+void display_set_renderer(const char* renderer);
+
+// State Tracker
+int state_tracker_init(const char* root);
+bool state_screen_on(void);
+bool state_low_power(void);
 
 // Profiler
 extern bool (*get_screenstate)(void);
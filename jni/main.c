@@ -18,10 +18,387 @@
 #include <libgen.h>
 char* gamestart = NULL;
 pid_t game_pid = 0;
-GameOptions opts;
+static bool dnd_enabled = false;
+static bool game_prioritized = false;
+
+// Helpers are only known when game_procs tracked the same process as game_pid
+static void prioritize_helpers(int first) {
+    if (game_pid <= 0 || game_procs.main != game_pid)
+        return;
+
+    for (int i = first; i < game_procs.nr_helpers; i++)
+        set_priority(game_procs.helpers[i]);
+}
+
+/***********************************************************************************
+ * Function Name      : restore_session
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Undoes per-game settings when leaving the performance profile.
+ ***********************************************************************************/
+static void restore_session(void) {
+    char renderer[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.renderer", renderer);
+    if (strcmp(renderer, "vulkan") == 0) {
+        display_set_renderer("skiavk");
+    } else {
+        display_set_renderer("skiagl");
+    }
+    display_restore_refresh_rate();
+    if (dnd_enabled) {
+        systemv("sys.azenith-utilityconf disableDND");
+        dnd_enabled = false;
+    }
+    game_prioritized = false;
+    net_tune_restore();
+}
+
+/***********************************************************************************
+ * Function Name      : apply_performance
+ * Inputs             : opts (const GameOptions *) - per-game options of gamestart
+ * Returns            : None
+ * Description        : Applies per-game settings and the performance profile.
+ ***********************************************************************************/
+static void apply_performance(const GameOptions* opts) {
+    log_zenith(LOG_INFO, "Applying performance profile for %s", gamestart);
+    toast("Applying Performance Profile");
+
+    if (IS_TRUE(opts->perf_lite_mode)) {
+        systemv("setprop persist.sys.azenithconf.litemode 1");
+    } else if (IS_FALSE(opts->perf_lite_mode)) {
+        systemv("setprop persist.sys.azenithconf.litemode 0");
+    } else {
+        char lite_prop[PROP_VALUE_MAX] = {0};
+        __system_property_get("persist.sys.azenithconf.cpulimit", lite_prop);
+        if (strcmp(lite_prop, "1") == 0) {
+            systemv("setprop persist.sys.azenithconf.litemode 1");
+        } else {
+            systemv("setprop persist.sys.azenithconf.litemode 0");
+        }
+    }
+
+    if (strcmp(opts->renderer, "vulkan") == 0) {
+        display_set_renderer("skiavk");
+    } else if (strcmp(opts->renderer, "skiagl") == 0) {
+        display_set_renderer("skiagl");
+    }
+
+    game_prioritized = IS_TRUE(opts->app_priority);
+    if (!game_prioritized && !IS_FALSE(opts->app_priority)) {
+        char val[PROP_VALUE_MAX] = {0};
+        game_prioritized = __system_property_get("persist.sys.azenithconf.iosched", val) > 0 && val[0] == '1';
+    }
+    if (game_prioritized) {
+        set_priority(game_pid);
+        prioritize_helpers(0);
+    }
+
+    if (IS_TRUE(opts->dnd_on_gaming)) {
+        systemv("sys.azenith-utilityconf enableDND");
+        dnd_enabled = true;
+    } else if (!IS_FALSE(opts->dnd_on_gaming)) {
+        char dnd_state[PROP_VALUE_MAX] = {0};
+        __system_property_get("persist.sys.azenithconf.dnd", dnd_state);
+        if (strcmp(dnd_state, "1") == 0) {
+            systemv("sys.azenith-utilityconf enableDND");
+            dnd_enabled = true;
+        }
+    }
+
+    if (!IS_DEFAULT(opts->refresh_rate)) {
+        int rr = atoi(opts->refresh_rate);
+        if (rr >= 60 && rr <= 144) {
+            display_save_refresh_rate();
+            display_set_refresh_rate(rr);
+        }
+    }
+
+    // Measure the game load, and let blktune pick the loading queue settings
+    blk_load_begin();
+    run_profiler(PERFORMANCE_PROFILE);
+    thermal_governor_reset();
+    session_rec_begin(gamestart, game_pid);
+
+    bool net_latency = IS_TRUE(opts->net_latency);
+    if (!net_latency && !IS_FALSE(opts->net_latency)) {
+        char val[PROP_VALUE_MAX] = {0};
+        net_latency = __system_property_get("persist.sys.azenithconf.netlatency", val) > 0 && val[0] == '1';
+    }
+    if (net_latency)
+        net_tune_apply(uidof(game_pid), game_pid);
+
+    notify("Performance Profile", "Running at : %s", "false", 0, gamestart);
+
+    if (IS_TRUE(opts->game_preload)) {
+        GamePreload(gamestart);
+    } else if (!IS_FALSE(opts->game_preload)) {
+        char preload_active[PROP_VALUE_MAX] = {0};
+        __system_property_get("persist.sys.azenithconf.APreload", preload_active);
+        if (strcmp(preload_active, "1") == 0) {
+            notify("AZenith Preload", "Preloading Complete at : %s", "true", 10000, gamestart);
+            GamePreload(gamestart);
+        }
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : run_action
+ * Inputs             : ps (ProfileState *) - state machine after the step
+ *                      action (ProfileAction) - action to perform
+ * Returns            : None
+ * Description        : Performs the side effects the profile state machine asked for.
+ ***********************************************************************************/
+static void run_action(ProfileState* ps, ProfileAction action) {
+    switch (action) {
+    case ACTION_GAME_EXITED:
+        log_zenith(LOG_INFO, "Game %s exited, resetting profile...", ps->last_game);
+        break;
+    case ACTION_PID_LOST:
+        log_zenith(LOG_ERROR, "Unable to fetch PID of %s", ps->last_game);
+        break;
+    case ACTION_AI_TOGGLED:
+        log_zenith(LOG_INFO, "Dynamic profile is %s, Reapplying Balanced Profiles",
+                   strcmp(ps->prev_ai_state, "1") == 0 ? "enabled" : "disabled");
+        toast("Applying Balanced Profile");
+        run_profiler(BALANCED_PROFILE);
+        notify("Balanced Profile", "System is now at Optimal state", "false", 0);
+        break;
+    case ACTION_INITIALIZED:
+        notify("Daemon Info", "AZenith is running successfully", "false", 60000);
+        break;
+    case ACTION_APPLY_PERFORMANCE:
+        apply_performance(&ps->opts);
+        break;
+    case ACTION_APPLY_ECO:
+        log_zenith(LOG_INFO, "Applying ECO Mode");
+        toast("Applying Eco Mode");
+        restore_session();
+        run_profiler(ECO_MODE);
+        notify("ECO Mode", "System is now at Endurance state", "false", 0);
+        break;
+    case ACTION_LOAD_PERFORMANCE:
+        log_zenith(LOG_INFO, "Sustained heavy load, applying performance profile");
+        restore_session();
+        run_profiler(PERFORMANCE_PROFILE);
+        thermal_governor_reset();
+        break;
+    case ACTION_LOAD_ECO:
+        log_zenith(LOG_INFO, "System idle, applying ECO Mode");
+        restore_session();
+        run_profiler(ECO_MODE);
+        break;
+    case ACTION_APPLY_BALANCED:
+        log_zenith(LOG_INFO, "Applying Balanced profile");
+        toast("Applying Balanced profile");
+        restore_session();
+        run_profiler(BALANCED_PROFILE);
+        notify("Balanced Profile", "System is now at Optimal state", "false", 0);
+        break;
+    }
+}
+
+typedef enum : char {
+    TIMER_PROFILE,
+    TIMER_THERMAL,
+    TIMER_GPU,
+    TIMER_PRESSURE,
+    TIMER_SESSION,
+    TIMER_FREQ,
+    TIMER_FREEZER,
+    TIMER_BYPASS,
+    TIMER_STATE,
+    TIMER_INTEGRITY,
+    TIMER_STATS,
+    TIMER_MAINTENANCE,
+    NR_TIMERS
+} TimerId;
+
+static ProfileState ps;
+static bool use_thermalgov = false;
+static bool running = true;
+static Timer timers[NR_TIMERS];
+
+static bool prop_enabled(const char* name) {
+    char val[PROP_VALUE_MAX] = {0};
+    __system_property_get(name, val);
+    return strcmp(val, "1") == 0;
+}
+
+/***********************************************************************************
+ * Function Name      : mode_changed
+ * Inputs             : prev (ProfileMode) - mode before the last step
+ * Returns            : None
+ * Description        : Session timers only run in the performance profile, which
+ *                      also polls for profile changes faster. Maintenance starts
+ *                      with the first real profile.
+ ***********************************************************************************/
+static void mode_changed(ProfileMode prev) {
+    bool perf = ps.cur_mode == PERFORMANCE_PROFILE;
+
+    if (perf) {
+        if (use_thermalgov)
+            timer_start(&timers[TIMER_THERMAL], LOOP_INTERVAL_MS);
+        timer_start(&timers[TIMER_GPU], LOOP_INTERVAL_MS);
+        timer_start(&timers[TIMER_PRESSURE], LOOP_INTERVAL_MS);
+        timer_start(&timers[TIMER_SESSION], timers[TIMER_SESSION].period_ms);
+    } else {
+        timer_stop(&timers[TIMER_THERMAL]);
+        timer_stop(&timers[TIMER_GPU]);
+        timer_stop(&timers[TIMER_PRESSURE]);
+        timer_stop(&timers[TIMER_SESSION]);
+    }
+    timers[TIMER_PROFILE].period_ms = perf ? LOOP_INTERVAL_MS : LOOP_INTERVAL_SEC * 1000;
+    timer_start(&timers[TIMER_PROFILE], timers[TIMER_PROFILE].period_ms);
+
+    // FSTrim and dexopt wait until the first profile is in place
+    if (prev == PERFCOMMON) {
+        timer_start(&timers[TIMER_MAINTENANCE], 0);
+        boot_report_first_profile();
+    }
+}
+
+static void tick_profile(void) {
+    ProfileMode prev = ps.cur_mode;
+    timer_wheel_set_screen(get_screenstate());
+
+    if (prop_enabled("persist.sys.azenithconf.loadaware"))
+        load_sampler_tick();
+
+    profile_state_step(&ps, &profile_env_default);
+    gamestart = ps.gamestart;
+    game_pid = ps.game_pid;
+
+    for (int i = 0; i < ps.nr_actions; i++)
+        run_action(&ps, ps.actions[i]);
+
+    // After the applies, which release any boost, so it only runs on balanced
+    input_boost_set_enabled(ps.cur_mode == BALANCED_PROFILE && prop_enabled("persist.sys.azenithconf.touchboost"));
+
+    if (ps.cur_mode != prev)
+        mode_changed(prev);
+}
+
+static void tick_thermal(void) {
+    thermal_governor_tick();
+}
+
+static void tick_gpu(void) {
+    if (prop_enabled("persist.sys.azenithconf.gpuctl"))
+        gpu_controller_tick();
+}
+
+static void tick_pressure(void) {
+    vm_tune_tick();
+    blk_tune_tick();
+}
+
+// These only sample during a session started by a performance apply
+static void tick_session(void) {
+    // Helpers started after the apply join the session here
+    int first = game_procs_tick();
+    for (int i = first; i < game_procs.nr_helpers && game_procs.main == game_pid; i++)
+        cgroup_boost_add(game_procs.helpers[i]);
+    if (game_prioritized)
+        prioritize_helpers(first);
+
+    residency_guard_tick();
+    session_rec_tick();
+}
+
+static void tick_freq(void) {
+    if ((ps.cur_mode == BALANCED_PROFILE || ps.cur_mode == ECO_MODE) && !input_boost_active() && get_screenstate())
+        freq_enforcer_tick(ps.cur_mode);
+}
+
+static void tick_freezer(void) {
+    if (prop_enabled("persist.sys.azenithconf.freezer")) {
+        bool gaming = ps.cur_mode == PERFORMANCE_PROFILE && game_pid > 0;
+        freezer_tick(gaming, get_screenstate(), game_pid);
+    } else {
+        freezer_thaw_all();
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : restore_on_exit
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Runs once the loop stopped, for a signal or a module
+ *                      update. Nothing the daemon changed may outlive it.
+ ***********************************************************************************/
+static void restore_on_exit(void) {
+    // Record a running session while its game is still tuned
+    session_rec_end();
+
+    // Reverse of run_profiler(), then what the loop holds on its own
+    blk_tune_restore();
+    vm_tune_restore();
+    irq_steer_restore();
+    cpuset_restore();
+    cgroup_boost_restore();
+    net_tune_restore();
+    freezer_thaw_all();
+    input_boost_set_enabled(false);
+    thermal_governor_restore();
+    gpu_controller_stop();
+    bypass_charge_stop();
+    display_restore_refresh_rate();
+}
+
+static void on_exit_signal(int fd) {
+    int signal = sighandler_take(fd);
+    if (signal == 0)
+        return;
+    log_zenith(LOG_INFO, "Received %s, exiting.", signal == SIGINT ? "SIGINT" : "SIGTERM");
+    running = false;
+}
+
+static void tick_state(void) {
+    // Handle case when module gets updated
+    if (access(MODULE_UPDATE, F_OK) == 0) [[clang::unlikely]] {
+        log_zenith(LOG_INFO, "Module update detected, exiting.");
+        notify("Module Update", "Please reboot your device to complete module update.", "false", 0);
+        systemv("setprop persist.sys.azenith.service \"\"");
+        systemv("setprop persist.sys.azenith.state stopped");
+        running = false;
+        return;
+    }
+
+    checkstate();
+}
+
+static void tick_integrity(void) {
+    if (is_kanged() || !check_module_version()) [[clang::unlikely]]
+        exit(EXIT_FAILURE);
+}
+
+static void tick_stats(void) {
+    stats_flush(true);
+}
+
+// Screen-off stretching applies to whatever only matters while someone looks
+static Timer timers[NR_TIMERS] = {
+    [TIMER_PROFILE] = {"profile", tick_profile, LOOP_INTERVAL_SEC * 1000, 0, true},
+    [TIMER_THERMAL] = {"thermal", tick_thermal, LOOP_INTERVAL_MS, 0, false},
+    [TIMER_GPU] = {"gpu", tick_gpu, LOOP_INTERVAL_MS, 0, false},
+    [TIMER_PRESSURE] = {"pressure", tick_pressure, LOOP_INTERVAL_MS, 0, false},
+    [TIMER_SESSION] = {"session", tick_session, 2000, 1000, false},
+    [TIMER_FREQ] = {"freq", tick_freq, 2000, 1000, true},
+    [TIMER_FREEZER] = {"freezer", tick_freezer, 2000, 1000, true},
+    [TIMER_BYPASS] = {"bypass", bypass_charge_tick, 2000, 1000, true},
+    [TIMER_STATE] = {"state", tick_state, 5000, 2000, true},
+    [TIMER_INTEGRITY] = {"integrity", tick_integrity, 60000, 15000, true},
+    [TIMER_STATS] = {"stats", tick_stats, STATS_FLUSH_MS, 5000, true},
+    [TIMER_MAINTENANCE] = {"maintenance", runtask, TASK_INTERVAL_SEC * 1000, 30 * 60 * 1000, false},
+};
 
 int main(int argc, char* argv[]) {
 
+    // Replays a recorded trace, touches nothing on the device
+    if (argc > 1 && !strcmp(argv[1], "--simulate")) {
+        return handle_simulate(argc, argv);
+    }
+
     if (getuid() != 0) {
         fprintf(stderr, "\033[31mERROR:\033[0m Please run this program as root\n");
         return 1;
@@ -46,13 +423,10 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        systemv("rm -f /data/adb/.config/AZenith/debug/AZenith.log");
-        systemv("rm -f /data/adb/.config/AZenith/debug/AZenithVerbose.log");
-        systemv("rm -f /data/adb/.config/AZenith/preload/AZenithPR.log");        
-        systemv("su -c \"/system/bin/am start --user 0 -n zx.azenith/.MainActivity -e clearall true >/dev/null 2>&1\"");
-
+        unlink(LOG_FILE);
+        unlink(LOG_VFILE);
+        unlink(LOG_FILE_PRELOAD);
 
-               
         // Sanity check for dumpsys
         if (access("/system/bin/dumpsys", F_OK) != 0) {
             fprintf(stderr, "\033[31mFATAL ERROR:\033[0m /system/bin/dumpsys: inaccessible or not found\n");
@@ -76,290 +450,68 @@ int main(int argc, char* argv[]) {
             exit(EXIT_FAILURE);
         }
 
-        // Check Module Integrity
-        is_kanged();
-        check_module_version();
-
         if (daemon(0, 0)) {
             log_zenith(LOG_FATAL, "Unable to daemonize service");
             systemv("setprop persist.sys.azenith.service \"\"");
             systemv("setprop persist.sys.azenith.state stopped");
             return 1;
         }
-                        
-        signal(SIGINT,  sighandler);
-        signal(SIGTERM, sighandler);
-
-        bool need_profile_checkup = false;
-        MLBBState mlbb_is_running = MLBB_NOT_RUNNING;
-        static bool is_initialize_complete = false;
-        ProfileMode cur_mode = PERFCOMMON;
-        static bool dnd_enabled = false;
-        static int saved_refresh_rate = -1;
-        
+
         log_zenith(LOG_INFO, "Daemon started as PID %d", getpid());
         setspid();
 
+        // service.sh starts us right away, nothing below is useful before boot completes
+        boot_wait_completed();
+
         systemv("setprop persist.sys.rianixia.learning_enabled true");
         systemv("setprop persist.sys.azenith.state running");
         notify("Initializing...", "Starting AZenith service...", "false", 0);
 
         systemv("setprop persist.sys.rianixia.thermalcore-bigdata.path /data/adb/.config/AZenith/debug");
-        runthermalcore();
-        run_profiler(PERFCOMMON);
-
-        char prev_ai_state[PROP_VALUE_MAX] = "0";
-        __system_property_get("persist.sys.azenithconf.AIenabled", prev_ai_state);
-
-        while (1) {
-            runtask();
-            // Check Module Integrity
-            is_kanged();
-            check_module_version();
-            if (cur_mode == PERFORMANCE_PROFILE) {
-                usleep(LOOP_INTERVAL_MS * 1000);
-            } else {
-                sleep(LOOP_INTERVAL_SEC);
-            }
-    
-            // Handle case when module gets updated
-            if (access(MODULE_UPDATE, F_OK) == 0) [[clang::unlikely]] {
-                log_zenith(LOG_INFO, "Module update detected, exiting.");
-                notify("Module Update", "Please reboot your device to complete module update.", "false", 0);
-                systemv("setprop persist.sys.azenith.service \"\"");
-                systemv("setprop persist.sys.azenith.state stopped");
-                break;
-            }
-    
-            // Check module state
-            checkstate();
-    
-            char freqoffset[PROP_VALUE_MAX] = {0};
-            __system_property_get("persist.sys.azenithconf.freqoffset", freqoffset);
-            if (strstr(freqoffset, "Disabled") == NULL) {
-                if (get_screenstate()) {
-                    if (cur_mode == PERFORMANCE_PROFILE) {
-                        // No exec
-                    } else if (cur_mode == BALANCED_PROFILE) {
-                        systemv("sys.azenith-profilesettings applyfreqbalance");
-                    } else if (cur_mode == ECO_MODE) {
-                        systemv("sys.azenith-profilesettings applyfreqbalance");
-                    }
-                } else {
-                    // Screen Off
-                }
-            }
-    
-            // Update state
-            char ai_state[PROP_VALUE_MAX] = {0};
-            __system_property_get("persist.sys.azenithconf.AIenabled", ai_state);
-            if (is_initialize_complete) {
-                if (strcmp(prev_ai_state, "1") == 0 && strcmp(ai_state, "0") == 0) {
-                    log_zenith(LOG_INFO, "Dynamic profile is disabled, Reapplying Balanced Profiles");
-                    toast("Applying Balanced Profile");
-                    cur_mode = BALANCED_PROFILE;
-                    run_profiler(BALANCED_PROFILE);
-                    notify("Balanced Profile", "System is now at Optimal state", "false", 0);
-                }
-    
-                if (strcmp(prev_ai_state, "0") == 0 && strcmp(ai_state, "1") == 0) {
-                    log_zenith(LOG_INFO, "Dynamic profile is enabled, Reapplying Balanced Profiles");
-                    toast("Applying Balanced Profile");
-                    cur_mode = BALANCED_PROFILE;
-                    run_profiler(BALANCED_PROFILE);
-                    notify("Balanced Profile", "System is now at Optimal state", "false", 0);
-                }
-                strcpy(prev_ai_state, ai_state);
-                // Skip applying if enabled
-                if (strcmp(ai_state, "0") == 0) {
-                    continue;
-                }
-            }
-    
-            // Only fetch gamestart when user not in-game
-            // prevent overhead from dumpsys commands.
-            if (!gamestart) {                
-                gamestart = get_gamestart(&opts);                
-            } else if (game_pid != 0 && kill(game_pid, 0) == -1) [[clang::unlikely]] {
-                log_zenith(LOG_INFO, "Game %s exited, resetting profile...", gamestart);
-                game_pid = 0;
-                free(gamestart);
-                gamestart = get_gamestart(&opts);
-                // Force profile recheck to make sure new game session get boosted
-                need_profile_checkup = true;
-            }
-
-            if (gamestart)
-                mlbb_is_running = handle_mlbb(gamestart);
-    
-            if (is_initialize_complete && gamestart && get_screenstate() && mlbb_is_running != MLBB_RUN_BG) {
-                // Bail out if we already on performance profile
-                if (!need_profile_checkup && cur_mode == PERFORMANCE_PROFILE)
-                    continue;
-    
-                // Get PID and check if the game is "real" running program
-                // Handle weird behavior of MLBB
-                game_pid = (mlbb_is_running == MLBB_RUNNING) ? mlbb_pid : pidof(gamestart);
-                if (game_pid == 0) [[clang::unlikely]] {
-                    log_zenith(LOG_ERROR, "Unable to fetch PID of %s", gamestart);
-                    free(gamestart);
-                    gamestart = NULL;
-                    continue;
-                }
-                
-                cur_mode = PERFORMANCE_PROFILE;
-                need_profile_checkup = false;
-                log_zenith(LOG_INFO, "Applying performance profile for %s", gamestart);
-                toast("Applying Performance Profile");                                
-
-                if (IS_TRUE(opts.perf_lite_mode)) {
-                    systemv("setprop persist.sys.azenithconf.litemode 1");
-                } else if (IS_FALSE(opts.perf_lite_mode)) {
-                    systemv("setprop persist.sys.azenithconf.litemode 0");
-                } else {
-                    char lite_prop[PROP_VALUE_MAX] = {0};
-                    __system_property_get("persist.sys.azenithconf.cpulimit", lite_prop);
-                    if (strcmp(lite_prop, "1") == 0) {
-                        systemv("setprop persist.sys.azenithconf.litemode 1");                 
-                    } else {
-                        systemv("setprop persist.sys.azenithconf.litemode 0");
-                    }
-                }
-                
-                if (strcmp(opts.renderer, "vulkan") == 0) {
-                    systemv("sys.azenith-utilityconf setrender skiavk");
-                } else if (strcmp(opts.renderer, "skiagl") == 0) {
-                    systemv("sys.azenith-utilityconf setrender skiagl");
-                } else {
-                    // Do Nothing
-                }               
-                
-                if (IS_TRUE(opts.app_priority)) {
-                    set_priority(game_pid);
-                } else if (IS_FALSE(opts.app_priority)) {
-                    // do nothing
-                } else {
-                    char val[PROP_VALUE_MAX] = {0};
-                    if (__system_property_get("persist.sys.azenithconf.iosched", val) > 0) {
-                        if (val[0] == '1') {
-                        set_priority(game_pid);
-                        }
-                    }
-                }
-                                                
-                if (IS_TRUE(opts.dnd_on_gaming)) {                   
-                    systemv("sys.azenith-utilityconf enableDND");
-                    dnd_enabled = true;
-                } else if (IS_FALSE(opts.dnd_on_gaming)) {
-                    // do nothing
-                } else {
-                    char dnd_state[PROP_VALUE_MAX] = {0};
-                    __system_property_get("persist.sys.azenithconf.dnd", dnd_state);
-                    if (strcmp(dnd_state, "1") == 0) {
-                        systemv("sys.azenith-utilityconf enableDND");
-                        dnd_enabled = true;
-                    }
-                }
-                                
-                if (!IS_DEFAULT(opts.refresh_rate)) {
-                    int rr = atoi(opts.refresh_rate);
-                
-                    if (rr >= 60 && rr <= 144) {
-                
-                        if (saved_refresh_rate < 0) {
-                            saved_refresh_rate = get_current_refresh_rate();
-                            log_zenith(LOG_INFO, "Saved refresh rate: %d", saved_refresh_rate);
-                        }
-                
-                        systemv("sys.azenith-utilityconf setrefreshrates %d", rr);
-                    }
-                
-                } else {
-                    // do nothing
-                }
-                                                
-                run_profiler(PERFORMANCE_PROFILE);
-                notify("Performance Profile", "Running at : %s", "false", 0, gamestart);
-                      
-                if (IS_TRUE(opts.game_preload)) {
-                    GamePreload(gamestart);
-                } else if (IS_FALSE(opts.game_preload)) {
-                    // do nothing
-                } else {
-                    char preload_active[PROP_VALUE_MAX] = {0};
-                    __system_property_get("persist.sys.azenithconf.APreload", preload_active);
-                    if (strcmp(preload_active, "1") == 0) {
-                        notify("AZenith Preload", "Preloading Complete at : %s", "true", 10000, gamestart);
-                        GamePreload(gamestart);
-                    }
-                }
-            } else if (is_initialize_complete && get_low_power_state()) {
-                // Bail out if we already on powersave profile
-                if (cur_mode == ECO_MODE)
-                    continue;
-    
-                cur_mode = ECO_MODE;                
-                need_profile_checkup = false;
-                log_zenith(LOG_INFO, "Applying ECO Mode");
-                toast("Applying Eco Mode");
-                char renderer[PROP_VALUE_MAX] = {0};
-                __system_property_get("persist.sys.azenithconf.renderer", renderer);                
-                if (strcmp(renderer, "vulkan") == 0) {
-                    systemv("sys.azenith-utilityconf setrender skiavk");
-                    
-                } else {
-                    systemv("sys.azenith-utilityconf setrender skiagl");
-                    
-                }           
-                if (saved_refresh_rate > 0) {
-                    systemv("sys.azenith-utilityconf setrefreshrates %d", saved_refresh_rate);
-                    saved_refresh_rate = -1;
-                }   
-                if (dnd_enabled) {
-                    systemv("sys.azenith-utilityconf disableDND");
-                    dnd_enabled = false;
-                }
-                run_profiler(ECO_MODE);
-                notify("ECO Mode", "System is now at Endurance state", "false", 0);
-            } else {
-                // Bail out if we already on normal profile
-                if (cur_mode == BALANCED_PROFILE)
-                    continue;
-    
-                cur_mode = BALANCED_PROFILE;               
-                need_profile_checkup = false;
-                log_zenith(LOG_INFO, "Applying Balanced profile");
-                toast("Applying Balanced profile");  
-                char renderer[PROP_VALUE_MAX] = {0};
-                __system_property_get("persist.sys.azenithconf.renderer", renderer);                
-                if (strcmp(renderer, "vulkan") == 0) {
-                    systemv("sys.azenith-utilityconf setrender skiavk");
-                    
-                } else {
-                    systemv("sys.azenith-utilityconf setrender skiagl");
-                    
-                }              
-                if (saved_refresh_rate > 0) {
-                    systemv("sys.azenith-utilityconf setrefreshrates %d", saved_refresh_rate);
-                    saved_refresh_rate = -1;
-                }
-                if (dnd_enabled) {
-                    systemv("sys.azenith-utilityconf disableDND");
-                    dnd_enabled = false;
-                }
-                if (!is_initialize_complete) {
-                    notify("Daemon Info", "AZenith is running successfully", "false", 60000);
-                    is_initialize_complete = true;
-                }
-                run_profiler(BALANCED_PROFILE);
-                notify("Balanced Profile", "System is now at Optimal state", "false", 0);
-    
-            }
+
+        // Nothing needed restoring so far, the default action was fine until here
+        sighandler_init(on_exit_signal);
+        use_thermalgov = boot_init_run();
+        // After init, its fork storm finishes sooner on all cores
+        footprint_init(NULL);
+
+        profile_state_init(&ps, &profile_env_default);
+        if (!timer_wheel_init()) {
+            log_zenith(LOG_FATAL, "Unable to create the daemon timer");
+            systemv("setprop persist.sys.azenith.service \"\"");
+            systemv("setprop persist.sys.azenith.state stopped");
+            return 1;
+        }
+
+        // Maintenance and the perf-only timers are started on mode changes
+        for (int i = 0; i < NR_TIMERS; i++) {
+            if (i == TIMER_PROFILE || (i >= TIMER_FREQ && i != TIMER_MAINTENANCE))
+                timer_start(&timers[i], timers[i].period_ms);
         }
 
+        while (running)
+            event_loop_once(-1);
+
+        restore_on_exit();
         return 0;
     }    
 
+    if (!strcmp(argv[1], "--bench-load")) {
+        return handle_bench_load(argc, argv);
+    }
+
+    if (!strcmp(argv[1], "--cpuset-check")) {
+        return handle_cpuset_check(argc, argv);
+    }
+
+    if (!strcmp(argv[1], "--sessions")) {
+        return handle_sessions(argc, argv);
+    }
+
+    if (!strcmp(argv[1], "--net-bench")) {
+        return handle_net_bench(argc, argv);
+    }
+
     if (!require_daemon_running()) {
         return 1;
     }
@@ -376,6 +528,10 @@ int main(int argc, char* argv[]) {
         return handle_verboselog(argc, argv);
     }
     
+    if (!strcmp(argv[1], "--stats") || !strcmp(argv[1], "-s")) {
+        return handle_stats();
+    }
+
     if (!strcmp(argv[1], "--version") || !strcmp(argv[1], "-V")) {
         printversion();
         return 0;
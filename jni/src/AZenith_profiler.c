@@ -29,16 +29,74 @@ bool (*get_low_power_state)(void) = get_low_power_state_normal;
  * Description        : Switch to specified performance profile.
  ***********************************************************************************/
 void run_profiler(const int profile) {
-    is_kanged();
+    // Also runs on a boot stage thread, checkstate() ends the daemon later
+    if (is_kanged()) [[clang::unlikely]]
+        return;
+
+    // Hand GPU min_freq back before profilesettings writes its own
+    gpu_controller_stop();
+
+    // A touch boost restores what it saved, that must happen before this profile
+    input_boost_set_enabled(false);
 
     if (profile == 1) {
-        write2file(GAME_INFO, false, false, "%s %d %d\n", gamestart, game_pid, uidof(game_pid));
+        write2file(GAME_INFO, false, false, "%s %d %d\n", gamestart ? gamestart : "NULL", game_pid, uidof(game_pid));
     } else {
         write2file(GAME_INFO, false, false, "NULL 0 0\n");
     }
 
     write2file(PROFILE_MODE, false, false, "%d\n", profile);
-    (void)systemv("sys.azenith-profilesettings %d", profile);
+    (void)systemv_deadline(CMD_LONG_TIMEOUT_MS, "sys.azenith-profilesettings %d", profile);
+
+    char cgroup_boost[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.cgroupboost", cgroup_boost);
+    if (strcmp(cgroup_boost, "1") == 0) {
+        cgroup_boost_apply(profile, profile == PERFORMANCE_PROFILE ? game_pid : 0);
+        if (profile == PERFORMANCE_PROFILE && game_pid > 0 && game_procs.main == game_pid) {
+            for (int i = 0; i < game_procs.nr_helpers; i++)
+                cgroup_boost_add(game_procs.helpers[i]);
+        }
+    } else {
+        cgroup_boost_restore();
+    }
+
+    char cpuset[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.cpuset", cpuset);
+    if (strcmp(cpuset, "1") == 0) {
+        cpuset_apply(profile);
+    } else {
+        cpuset_restore();
+    }
+
+    char irq_steer[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.irqsteer", irq_steer);
+    if (strcmp(irq_steer, "1") == 0) {
+        irq_steer_apply(profile, profile == PERFORMANCE_PROFILE ? game_pid : 0);
+    } else {
+        irq_steer_restore();
+    }
+
+    char vm_tune[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.vmtune", vm_tune);
+    if (strcmp(vm_tune, "1") == 0) {
+        vm_tune_apply(profile);
+    } else {
+        vm_tune_restore();
+    }
+
+    if (profile != PERFORMANCE_PROFILE) {
+        blk_load_cancel();
+        residency_guard_stop();
+        session_rec_end();
+    }
+
+    char blk_tune[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.blktune", blk_tune);
+    if (strcmp(blk_tune, "1") == 0) {
+        blk_tune_apply(profile);
+    } else {
+        blk_tune_restore();
+    }
 }
 
 /***********************************************************************************
@@ -119,6 +177,21 @@ char* get_gamestart(GameOptions* options) {
 
         p = strstr(entry, "\"renderer\":");
         extract_string_value(options->renderer, p, sizeof(options->renderer));
+
+        // Older entries lack these, a match past the closing brace belongs to the next game
+        char* entry_end = strchr(entry, '}');
+
+        p = strstr(entry, "\"net_latency\":");
+        extract_string_value(options->net_latency, p && (!entry_end || p < entry_end) ? p : NULL,
+                             sizeof(options->net_latency));
+
+        p = strstr(entry, "\"game_process\":");
+        extract_string_value(options->game_process, p && (!entry_end || p < entry_end) ? p : NULL,
+                             sizeof(options->game_process));
+
+        p = strstr(entry, "\"helper_processes\":");
+        extract_string_value(options->helper_processes, p && (!entry_end || p < entry_end) ? p : NULL,
+                             sizeof(options->helper_processes));
     }
 
     free(buf);
@@ -140,7 +213,7 @@ char* get_gamestart(GameOptions* options) {
 bool get_screenstate_normal(void) {
     static char fetch_failed = 0;
 
-    FILE* fp = popen("dumpsys power", "r");
+    FILE* fp = popen_deadline(CMD_TIMEOUT_MS, "dumpsys power");
     if (!fp) {
         log_zenith(LOG_ERROR, "Failed to run dumpsys power");
         goto fetch_fail;
@@ -163,7 +236,7 @@ bool get_screenstate_normal(void) {
         }
     }
 
-    pclose(fp);
+    fclose(fp);
 
     if (found) {
         fetch_failed = 0;
@@ -195,7 +268,7 @@ fetch_fail:
 bool get_low_power_state_normal(void) {
     static char fetch_failed = 0;
 
-    FILE* fp = popen("/system/bin/settings get global low_power", "r");
+    FILE* fp = popen_deadline(CMD_TIMEOUT_MS, "/system/bin/settings get global low_power");
     if (fp) {
         char line[128];
         if (fgets(line, sizeof(line), fp)) {
@@ -205,13 +278,13 @@ bool get_low_power_state_normal(void) {
             for (int i = strlen(p) - 1; i >= 0 && (p[i] == '\n' || p[i] == '\r'); i--)
                 p[i] = 0;
 
-            pclose(fp);
+            fclose(fp);
             fetch_failed = 0;
             return IS_LOW_POWER(p);
         }
-        pclose(fp);
+        fclose(fp);
     }
-    fp = popen("dumpsys power", "r");
+    fp = popen_deadline(CMD_TIMEOUT_MS, "dumpsys power");
     if (fp) {
         char line[512];
         while (fgets(line, sizeof(line), fp)) {
@@ -223,12 +296,12 @@ bool get_low_power_state_normal(void) {
                 if (newline)
                     *newline = 0;
 
-                pclose(fp);
+                fclose(fp);
                 fetch_failed = 0;
                 return IS_LOW_POWER(p);
             }
         }
-        pclose(fp);
+        fclose(fp);
     }
 
     fetch_failed++;
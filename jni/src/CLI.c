@@ -52,6 +52,28 @@ void print_help() {
         "     -vl, --verboselog <TAG> <LEVEL> <MSG>\n"
         "                    Write a verbose log message via AZenith logging service\n"
         "\n"
+        "     -s, --stats    Show daemon counters\n"
+        "\n"
+        "     --bench-load [N]\n"
+        "                    Measure CPU cost of N load sampler runs\n"
+        "\n"
+        "     --cpuset-check [ROOT]\n"
+        "                    Print and validate the per-profile cpuset masks\n"
+        "                    without applying them\n"
+        "\n"
+        "     --sessions [PACKAGE]\n"
+        "                    Summarise recorded game sessions per game and\n"
+        "                    per enabled toggles\n"
+        "\n"
+        "     --net-bench [N] [tuned]\n"
+        "                    Measure loopback RTT and jitter of N pings under\n"
+        "                    bulk traffic, tuned applies the network latency\n"
+        "                    settings first. Run inside unshare -n\n"
+        "\n"
+        "     --simulate <TRACE>\n"
+        "                    Replay a recorded trace through the profile logic\n"
+        "                    and report transitions and loop cost\n"
+        "\n"
         "     -V, --version  Show AZenith current version\n"
         "\n"
         "     -h, --help     Display this help message and exit\n"
@@ -238,6 +260,27 @@ int handle_verboselog(int argc, char** argv) {
     return 0;
 }
 
+/***********************************************************************************
+ * Function Name      : handle_stats
+ * Inputs             : None
+ * Returns            : int - 0 on success, non-zero on failure
+ * Description        : Prints the counters last published by the daemon.
+ ***********************************************************************************/
+int handle_stats(void) {
+    FILE* fp = fopen(DAEMON_STATS, "r");
+    if (!fp) {
+        fprintf(stderr, "ERROR: No daemon stats published yet.\n");
+        return 1;
+    }
+
+    char line[MAX_LINE];
+    while (fgets(line, sizeof(line), fp))
+        fputs(line, stdout);
+
+    fclose(fp);
+    return 0;
+}
+
 /***********************************************************************************
  * Function Name      : printversion
  * Inputs             : None
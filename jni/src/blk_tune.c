@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+typedef struct {
+    const char* attr;
+    const char* loading; // performance while the game loads
+    const char* perf;
+    const char* eco;
+} BlkKnob;
+
+typedef struct {
+    char name[32];
+    bool is_dm;
+    int stat_fd; // physical devices only, dm would count reads twice
+} BlkDev;
+
+typedef struct {
+    char path[MAX_PATH_LENGTH * 2];
+    char value[32];
+} SavedBlkKnob;
+
+typedef struct {
+    uint64_t reads;
+    uint64_t sectors;
+    uint64_t ticks_ms;
+} BlkSample;
+
+// iostats stays on while loading, the loading report depends on it
+static const BlkKnob blk_knobs[] = {
+    {"read_ahead_kb", "2048", "512", "128"},
+    {"nr_requests", "256", "256", "64"},
+    {"iostats", "1", "0", "0"},
+    {"add_random", "0", "0", "0"},
+    {"rq_affinity", "2", "2", "1"},
+    {"nomerges", "0", "0", "0"},
+};
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static BlkDev devs[MAX_BLK_DEVS];
+static int nr_devs = 0;
+static SavedBlkKnob saved[MAX_BLK_SAVED];
+static int nr_saved = 0;
+static bool tuned_perf = false;
+static bool loading = false;
+static int64_t load_start = 0;
+static int64_t last_busy = 0;
+static int64_t last_sample = 0;
+static int idle_samples = 0;
+static BlkSample load_first;
+static BlkSample load_last;
+static BlkSample load_busy;
+
+static bool read_line(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    bool ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        trim_newline(buf);
+    return ok;
+}
+
+static bool write_str(const char* path, const char* value) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    bool ok = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+    return ok;
+}
+
+static void save_and_write(const char* path, const char* value) {
+    char old[32] = {0};
+    if (!read_line(path, old, sizeof(old)) || strcmp(old, value) == 0)
+        return;
+
+    bool known = false;
+    for (int i = 0; i < nr_saved; i++)
+        known |= strcmp(saved[i].path, path) == 0;
+
+    if (!known && nr_saved < MAX_BLK_SAVED) {
+        snprintf(saved[nr_saved].path, sizeof(saved[nr_saved].path), "%s", path);
+        snprintf(saved[nr_saved].value, sizeof(saved[nr_saved].value), "%s", old);
+        nr_saved++;
+    }
+
+    // blk-mq rejects nr_requests above the tag depth, dm queues most attributes
+    if (!write_str(path, value))
+        log_zenith(LOG_DEBUG, "Block tune: %s refused %s", path, value);
+}
+
+/***********************************************************************************
+ * Function Name      : is_storage_dev
+ * Inputs             : name (const char *) - /sys/block entry
+ *                      is_dm (bool *) - set for device-mapper devices
+ * Returns            : bool - true for UFS/eMMC disks and dm devices on them
+ * Description        : Skips loop, ram, zram and the eMMC boot/rpmb areas. A dm
+ *                      device counts if anything but a loop device backs it.
+ ***********************************************************************************/
+static bool is_storage_dev(const char* name, bool* is_dm) {
+    *is_dm = strncmp(name, "dm-", 3) == 0;
+    if (strncmp(name, "sd", 2) == 0)
+        return true;
+    if (strncmp(name, "mmcblk", 6) == 0)
+        return !strstr(name, "boot") && !strstr(name, "rpmb");
+    if (!*is_dm)
+        return false;
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/sys/block/%s/slaves", root_dir, name);
+    DIR* dir = opendir(path);
+    if (!dir)
+        return false;
+
+    bool backed = false;
+    struct dirent* entry;
+    while (!backed && (entry = readdir(dir)) != NULL)
+        backed = entry->d_name[0] != '.' && strncmp(entry->d_name, "loop", 4) != 0;
+    closedir(dir);
+    return backed;
+}
+
+/***********************************************************************************
+ * Function Name      : blk_tune_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : int - number of block devices found
+ * Description        : Enumerates /sys/block for storage devices and keeps the
+ *                      stat node of the physical ones open for sampling.
+ ***********************************************************************************/
+int blk_tune_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/sys/block", root_dir);
+    DIR* dir = opendir(path);
+    if (!dir) {
+        log_zenith(LOG_INFO, "Block tune: unable to open %s", path);
+        return 0;
+    }
+
+    struct dirent* entry;
+    while (nr_devs < MAX_BLK_DEVS && (entry = readdir(dir)) != NULL) {
+        bool is_dm;
+        if (entry->d_name[0] == '.' || !is_storage_dev(entry->d_name, &is_dm))
+            continue;
+
+        BlkDev* d = &devs[nr_devs];
+        snprintf(d->name, sizeof(d->name), "%s", entry->d_name);
+        d->is_dm = is_dm;
+        d->stat_fd = -1;
+        if (!is_dm) {
+            snprintf(path, sizeof(path), "%s/sys/block/%s/stat", root_dir, d->name);
+            d->stat_fd = open(path, O_RDONLY | O_CLOEXEC);
+        }
+        nr_devs++;
+    }
+    closedir(dir);
+
+    log_zenith(LOG_INFO, "Block tune: %d block devices", nr_devs);
+    return nr_devs;
+}
+
+static void write_table(int column) {
+    char path[MAX_PATH_LENGTH * 2];
+    for (int d = 0; d < nr_devs; d++) {
+        for (size_t k = 0; k < sizeof(blk_knobs) / sizeof(blk_knobs[0]); k++) {
+            const char* values[] = {blk_knobs[k].loading, blk_knobs[k].perf, blk_knobs[k].eco};
+            // Only readahead means anything on a bio based dm queue
+            if (devs[d].is_dm && k != 0)
+                continue;
+
+            snprintf(path, sizeof(path), "%s/sys/block/%s/queue/%s", root_dir, devs[d].name, blk_knobs[k].attr);
+            save_and_write(path, values[column]);
+        }
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : blk_tune_restore
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Writes every saved queue attribute back in reverse order.
+ ***********************************************************************************/
+void blk_tune_restore(void) {
+    for (int i = nr_saved - 1; i >= 0; i--)
+        write_str(saved[i].path, saved[i].value);
+    nr_saved = 0;
+    tuned_perf = false;
+}
+
+/***********************************************************************************
+ * Function Name      : blk_tune_apply
+ * Inputs             : mode (ProfileMode) - profile being applied
+ * Returns            : None
+ * Description        : Restores the previous profile's queue settings, then
+ *                      writes the new table. Performance uses the loading table,
+ *                      large readahead and iostats on, while a game load is
+ *                      being measured. Balanced keeps the system values.
+ ***********************************************************************************/
+void blk_tune_apply(ProfileMode mode) {
+    blk_tune_restore();
+
+    if (mode == PERFORMANCE_PROFILE) {
+        write_table(loading ? 0 : 1);
+        tuned_perf = true;
+    } else if (mode == ECO_MODE) {
+        write_table(2);
+    }
+}
+
+static bool blk_sample(BlkSample* s) {
+    memset(s, 0, sizeof(*s));
+    bool any = false;
+
+    for (int d = 0; d < nr_devs; d++) {
+        char buf[256] = {0};
+        if (devs[d].stat_fd == -1 || pread(devs[d].stat_fd, buf, sizeof(buf) - 1, 0) <= 0)
+            continue;
+
+        // reads merges sectors ticks, writes ...
+        unsigned long long reads, merges, sectors, ticks;
+        if (sscanf(buf, "%llu %llu %llu %llu", &reads, &merges, &sectors, &ticks) != 4)
+            continue;
+        s->reads += reads;
+        s->sectors += sectors;
+        s->ticks_ms += ticks;
+        any = true;
+    }
+    return any;
+}
+
+/***********************************************************************************
+ * Function Name      : blk_load_begin
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Starts measuring a game load. Call before the
+ *                      performance profile is applied so the loading table is
+ *                      the one written.
+ ***********************************************************************************/
+void blk_load_begin(void) {
+    if (!blk_sample(&load_first))
+        return;
+
+    load_last = load_first;
+    load_busy = load_first;
+    load_start = now_ms();
+    last_busy = load_start;
+    last_sample = load_start;
+    idle_samples = 0;
+    loading = true;
+}
+
+static void blk_load_end(bool report) {
+    loading = false;
+    if (!report)
+        return;
+
+    uint64_t reads = load_busy.reads - load_first.reads;
+    uint64_t kb = (load_busy.sectors - load_first.sectors) / 2;
+    int64_t ms = last_busy - load_start;
+    uint64_t kbps = ms > 0 ? kb * 1000 / (uint64_t)ms : 0;
+    uint64_t lat_us = reads > 0 ? (load_busy.ticks_ms - load_first.ticks_ms) * 1000 / reads : 0;
+
+    stats.blk_loads++;
+    stats.blk_load_read_kbps = kbps;
+    stats.blk_load_read_lat_us = lat_us;
+    log_zenith(LOG_INFO, "Block tune: game load read %llu KB in %lldms, %llu KB/s, %lluus per read (queue %s)",
+               (unsigned long long)kb, (long long)ms, (unsigned long long)kbps, (unsigned long long)lat_us,
+               tuned_perf ? "tuned" : "stock");
+}
+
+/***********************************************************************************
+ * Function Name      : blk_tune_tick
+ * Inputs             : None
+ * Returns            : None
+ * Description        : One sample of the game load. The load is over once reads
+ *                      stay under BLK_LOAD_IDLE_KBPS for BLK_LOAD_IDLE_HOLD
+ *                      samples, or after BLK_LOAD_MAX_MS. Throughput and read
+ *                      latency up to the last busy sample are reported either
+ *                      way, so stock and tuned queues can be compared. A tuned
+ *                      queue then drops to the steady performance table.
+ ***********************************************************************************/
+void blk_tune_tick(void) {
+    if (!loading)
+        return;
+
+    BlkSample s;
+    int64_t now = now_ms();
+    if (!blk_sample(&s)) {
+        blk_load_end(false);
+        return;
+    }
+
+    int64_t dt = now - last_sample;
+    uint64_t kb = s.sectors >= load_last.sectors ? (s.sectors - load_last.sectors) / 2 : 0;
+    load_last = s;
+    last_sample = now;
+
+    if (dt > 0 && kb * 1000 / (uint64_t)dt >= BLK_LOAD_IDLE_KBPS) {
+        load_busy = s;
+        last_busy = now;
+        idle_samples = 0;
+    } else {
+        idle_samples++;
+    }
+
+    if (idle_samples < BLK_LOAD_IDLE_HOLD && now - load_start < BLK_LOAD_MAX_MS)
+        return;
+
+    blk_load_end(true);
+    if (tuned_perf)
+        write_table(1);
+}
+
+/***********************************************************************************
+ * Function Name      : blk_load_cancel
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Drops an unfinished measurement when the game session
+ *                      ends before loading does.
+ ***********************************************************************************/
+void blk_load_cancel(void) {
+    loading = false;
+}
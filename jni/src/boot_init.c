@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <pthread.h>
+#include <sys/system_properties.h>
+#include <time.h>
+
+typedef enum : char {
+    STAGE_TOPOLOGY,
+    STAGE_PERFCOMMON,
+    STAGE_THERMAL,
+    STAGE_MODULES,
+    STAGE_APP,
+    STAGE_INTEGRITY,
+    NR_INIT_STAGES
+} InitStageId;
+
+typedef struct {
+    const char* name;
+    bool (*run)(void); // false stops the daemon once every stage is joined
+    uint32_t deps; // bits of InitStageId that must finish first
+    int64_t ms;
+    pthread_t thread;
+    bool threaded;
+    bool failed;
+} InitStage;
+
+static pthread_mutex_t stage_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stage_done = PTHREAD_COND_INITIALIZER;
+static uint32_t done_mask = 0;
+static bool use_thermalgov = false;
+static int64_t init_ms = 0;
+static bool first_profile_reported = false;
+
+static int64_t boottime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool stage_topology(void) {
+    cpu_topology_init();
+    return true;
+}
+
+static bool stage_perfcommon(void) {
+    run_profiler(PERFCOMMON);
+    return true;
+}
+
+// Native thermal governor replaces thermalcore when enabled
+static bool stage_thermal(void) {
+    char thermalgov[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.thermalgov", thermalgov);
+    use_thermalgov = strcmp(thermalgov, "1") == 0 && thermal_governor_init();
+    if (!use_thermalgov)
+        runthermalcore();
+    return true;
+}
+
+// Snapshots of vendor values are taken after profilesettings 0 ran, like before
+static bool stage_modules(void) {
+    bypass_charge_init(NULL);
+    freq_enforcer_init();
+    load_sampler_init();
+    input_boost_init(NULL, NULL);
+    gpu_controller_init(NULL);
+    cgroup_boost_init(NULL);
+    cpuset_init(NULL);
+    irq_steer_init(NULL);
+    vm_tune_init(NULL);
+    freezer_init(NULL);
+    blk_tune_init(NULL);
+    session_rec_init(NULL);
+    state_tracker_init(NULL);
+    game_procs_init(NULL);
+    net_tune_init(NULL, false);
+    return true;
+}
+
+static bool stage_app(void) {
+    systemv("/system/bin/am start --user 0 -n zx.azenith/.MainActivity -e clearall true >/dev/null 2>&1");
+    display_helper_start(NULL);
+    return true;
+}
+
+// Exiting here would tear the process down under stages still writing
+static bool stage_integrity(void) {
+    return !is_kanged() && check_module_version();
+}
+
+static InitStage stages[NR_INIT_STAGES] = {
+    [STAGE_TOPOLOGY] = {"topology", stage_topology, 0},
+    [STAGE_PERFCOMMON] = {"perfcommon", stage_perfcommon, 0},
+    [STAGE_THERMAL] = {"thermal", stage_thermal, 1U << STAGE_TOPOLOGY},
+    [STAGE_MODULES] = {"modules", stage_modules, 1U << STAGE_TOPOLOGY | 1U << STAGE_PERFCOMMON},
+    [STAGE_APP] = {"app", stage_app, 0},
+    [STAGE_INTEGRITY] = {"integrity", stage_integrity, 0},
+};
+
+static void* stage_thread(void* arg) {
+    InitStage* s = arg;
+    uint32_t bit = 1U << (s - stages);
+
+    pthread_mutex_lock(&stage_lock);
+    while ((done_mask & s->deps) != s->deps)
+        pthread_cond_wait(&stage_done, &stage_lock);
+    pthread_mutex_unlock(&stage_lock);
+
+    int64_t start = now_ms();
+    s->failed = !s->run();
+    s->ms = now_ms() - start;
+
+    pthread_mutex_lock(&stage_lock);
+    done_mask |= bit;
+    pthread_cond_broadcast(&stage_done);
+    pthread_mutex_unlock(&stage_lock);
+    return NULL;
+}
+
+/***********************************************************************************
+ * Function Name      : boot_wait_completed
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Sleeps until sys.boot_completed is 1. Waits on the
+ *                      property serial instead of polling. The property does not
+ *                      exist before init sets it, until then the wait is on the
+ *                      global serial; starting that one at 0 only costs one
+ *                      extra pass, the first wait returns the current serial.
+ ***********************************************************************************/
+void boot_wait_completed(void) {
+    uint32_t global_serial = 0;
+
+    while (true) {
+        const prop_info* pi = __system_property_find("sys.boot_completed");
+        if (!pi) {
+            __system_property_wait(NULL, global_serial, &global_serial, NULL);
+            continue;
+        }
+
+        uint32_t serial = __system_property_serial(pi);
+        char value[PROP_VALUE_MAX] = {0};
+        __system_property_get("sys.boot_completed", value);
+        if (strcmp(value, "1") == 0)
+            return;
+
+        __system_property_wait(pi, serial, &serial, NULL);
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : boot_init_run
+ * Inputs             : None
+ * Returns            : bool - true if the native thermal governor is in charge
+ * Description        : Runs the daemon init stages, each on its own thread once
+ *                      the stages it depends on are done. profilesettings 0 is
+ *                      the long pole, topology, thermal, the app and the
+ *                      integrity checks overlap it. A stage whose thread cannot
+ *                      be created runs inline, in table order, which still
+ *                      satisfies every dependency. Exits if a stage failed,
+ *                      only after all of them are joined.
+ ***********************************************************************************/
+bool boot_init_run(void) {
+    int64_t start = now_ms();
+
+    for (int i = 0; i < NR_INIT_STAGES; i++)
+        stages[i].threaded = pthread_create(&stages[i].thread, NULL, stage_thread, &stages[i]) == 0;
+
+    for (int i = 0; i < NR_INIT_STAGES; i++) {
+        if (stages[i].threaded)
+            pthread_join(stages[i].thread, NULL);
+        else
+            stage_thread(&stages[i]);
+    }
+
+    for (int i = 0; i < NR_INIT_STAGES; i++) {
+        if (stages[i].failed) [[clang::unlikely]] {
+            log_zenith(LOG_FATAL, "Init stage %s failed", stages[i].name);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    init_ms = now_ms() - start;
+    stats.init_ms = (uint64_t)init_ms;
+    for (int i = 0; i < NR_INIT_STAGES; i++)
+        log_zenith(LOG_DEBUG, "Init stage %s took %lld ms", stages[i].name, (long long)stages[i].ms);
+    log_zenith(LOG_INFO, "Daemon init took %lld ms", (long long)init_ms);
+    return use_thermalgov;
+}
+
+/***********************************************************************************
+ * Function Name      : boot_report_first_profile
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Logs and publishes the time from kernel boot to the first
+ *                      profile the daemon applied. Later calls do nothing.
+ ***********************************************************************************/
+void boot_report_first_profile(void) {
+    if (first_profile_reported)
+        return;
+    first_profile_reported = true;
+
+    int64_t boot_ms = boottime_ms();
+    stats.boot_to_profile_ms = (uint64_t)boot_ms;
+    log_zenith(LOG_INFO, "First profile applied %lld ms after boot (init %lld ms)", (long long)boot_ms,
+               (long long)init_ms);
+}
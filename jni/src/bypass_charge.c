@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+
+typedef struct {
+    const char* name;
+    const char* path;
+    const char* on;
+    const char* off;
+} BypassPath;
+
+// Keep in sync with eval_env() in sys_azenith_utilityconf.rs
+static const BypassPath bypass_paths[] = {
+    {"MTK_BYPASS_CHARGER", "/sys/devices/platform/charger/bypass_charger", "1", "0"},
+    {"MTK_CURRENT_CMD", "/proc/mtk_battery_cmd/current_cmd", "0 1", "0 0"},
+    {"TRAN_AICHG", "/sys/devices/platform/charger/tran_aichg_disable_charger", "1", "0"},
+    {"MTK_DISABLE_CHARGER", "/sys/devices/platform/mt-battery/disable_charger", "1", "0"},
+};
+
+static const char* const current_nodes[] = {
+    "/sys/class/power_supply/battery/current_now",
+    "/sys/class/power_supply/battery/BatteryAverageCurrent",
+    "/sys/class/power_supply/battery/input_current_now",
+    "/sys/class/power_supply/usb/current_now",
+};
+
+// Chargers seen in uevents or at init, usb and ac can be online at the same time
+typedef struct {
+    char name[32];
+    bool online;
+} PowerSupply;
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static char node_path[MAX_PATH_LENGTH * 2] = "";
+static PowerSupply supplies[BYPASS_MAX_SUPPLIES];
+static int nr_supplies = 0;
+static bool battery_charging = false;
+static const BypassPath* active_path = NULL;
+static BypassState state = BYPASS_IDLE;
+static int uevent_fd = -1;
+static int current_fd = -1;
+static int profile_fd = -1;
+static bool charger_online = false;
+static bool session_active = false;
+static int good_samples = 0;
+static int attempts = 0;
+static int64_t verify_deadline = 0;
+
+/***********************************************************************************
+ * Function Name      : current_to_ma
+ * Inputs             : raw (long) - value of a current_now style node
+ * Returns            : int - absolute current in mA
+ * Description        : Same normalisation as read_current_ma() in utilityconf,
+ *                      drivers report either uA or mA.
+ ***********************************************************************************/
+static int current_to_ma(long raw) {
+    if (raw < 0)
+        raw = -raw;
+    return raw > 1000 ? (int)(raw / 1000) : (int)raw;
+}
+
+static void bypass_write(const char* value) {
+    write2file(node_path, false, false, "%s", value);
+}
+
+static int open_rooted(const char* path) {
+    char full[MAX_PATH_LENGTH * 2];
+    snprintf(full, sizeof(full), "%s%s", root_dir, path);
+    return open(full, O_RDONLY | O_CLOEXEC);
+}
+
+/***********************************************************************************
+ * Function Name      : set_supply_online
+ * Inputs             : name (const char *) - power_supply name, e.g. usb or ac
+ *                      online (bool) - its ONLINE value
+ * Returns            : None
+ * Description        : Records one charger and recomputes charger_online, which
+ *                      holds while any charger is online. Devices that only
+ *                      report through the battery fall back to its status.
+ ***********************************************************************************/
+static void set_supply_online(const char* name, bool online) {
+    int i = 0;
+    while (i < nr_supplies && strcmp(supplies[i].name, name) != 0)
+        i++;
+    if (i == nr_supplies) {
+        if (nr_supplies == BYPASS_MAX_SUPPLIES)
+            return;
+        snprintf(supplies[i].name, sizeof(supplies[i].name), "%s", name);
+        nr_supplies++;
+    }
+    supplies[i].online = online;
+}
+
+static bool any_charger_online(void) {
+    if (nr_supplies == 0)
+        return battery_charging;
+
+    for (int i = 0; i < nr_supplies; i++) {
+        if (supplies[i].online)
+            return true;
+    }
+    return false;
+}
+
+static void bypass_engage(void) {
+    attempts++;
+    good_samples = 0;
+    verify_deadline = now_ms() + BYPASS_VERIFY_MS;
+    state = BYPASS_VERIFYING;
+    bypass_write(active_path->on);
+}
+
+static void bypass_release(void) {
+    if (state == BYPASS_VERIFYING || state == BYPASS_ENGAGED) {
+        bypass_write(active_path->off);
+        log_zenith(LOG_INFO, "Bypass charge disabled");
+    }
+    state = BYPASS_IDLE;
+    attempts = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : bypass_charge_stop
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Turns bypass off for good when the daemon exits, nobody
+ *                      would be left to re-enable charging otherwise.
+ ***********************************************************************************/
+void bypass_charge_stop(void) {
+    if (active_path)
+        bypass_release();
+}
+
+/***********************************************************************************
+ * Function Name      : bypass_feed_current
+ * Inputs             : ma (int) - absolute charging current in mA
+ * Returns            : None
+ * Description        : Streams one current sample into the verifier. Bypass is
+ *                      considered active after BYPASS_VERIFY_SAMPLES consecutive
+ *                      samples at or below BYPASS_CURRENT_MA.
+ ***********************************************************************************/
+void bypass_feed_current(int ma) {
+    if (state != BYPASS_VERIFYING)
+        return;
+
+    if (ma > BYPASS_CURRENT_MA) {
+        good_samples = 0;
+        return;
+    }
+
+    if (++good_samples >= BYPASS_VERIFY_SAMPLES) {
+        state = BYPASS_ENGAGED;
+        log_zenith(LOG_INFO, "Bypass active via %s, current %dmA", active_path->name, ma);
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : bypass_handle_uevent
+ * Inputs             : buf (const char *) - raw kobject uevent message
+ *                      len (size_t) - message length
+ * Returns            : None
+ * Description        : Parses a power_supply uevent ("ACTION@DEVPATH" followed by
+ *                      NUL separated KEY=VALUE pairs) and updates charger and
+ *                      current state. Has no dependency on the socket, so
+ *                      recorded uevent streams can be replayed through it.
+ ***********************************************************************************/
+void bypass_handle_uevent(const char* buf, size_t len) {
+    bool is_power_supply = false;
+    bool is_battery = false;
+    const char* name = NULL;
+    const char* online = NULL;
+    const char* status = NULL;
+    const char* current = NULL;
+
+    // The header is "ACTION@DEVPATH", older kernels send no POWER_SUPPLY_NAME
+    const char* devpath = strchr(buf, '@');
+    if (devpath && strrchr(devpath, '/'))
+        name = strrchr(devpath, '/') + 1;
+
+    for (size_t i = 0; i < len; i += strlen(buf + i) + 1) {
+        const char* kv = buf + i;
+        if (strcmp(kv, "SUBSYSTEM=power_supply") == 0)
+            is_power_supply = true;
+        else if (strcmp(kv, "POWER_SUPPLY_TYPE=Battery") == 0)
+            is_battery = true;
+        else if (strncmp(kv, "POWER_SUPPLY_NAME=", 18) == 0)
+            name = kv + 18;
+        else if (strncmp(kv, "POWER_SUPPLY_ONLINE=", 20) == 0)
+            online = kv + 20;
+        else if (strncmp(kv, "POWER_SUPPLY_STATUS=", 20) == 0)
+            status = kv + 20;
+        else if (strncmp(kv, "POWER_SUPPLY_CURRENT_NOW=", 25) == 0)
+            current = kv + 25;
+    }
+
+    if (!is_power_supply)
+        return;
+
+    bool was_online = charger_online;
+    if (!is_battery && online && name)
+        set_supply_online(name, atoi(online) == 1);
+    else if (is_battery && status && (strcmp(status, "Charging") == 0 || strcmp(status, "Full") == 0))
+        battery_charging = true;
+    else if (is_battery && status && strcmp(status, "Discharging") == 0)
+        battery_charging = false; // "Not charging" is what bypass itself looks like
+    charger_online = any_charger_online();
+
+    // Unplugged, the node must not stay set until the next plug-in
+    if (was_online && !charger_online)
+        bypass_release();
+
+    if (is_battery && current)
+        bypass_feed_current(current_to_ma(atol(current)));
+}
+
+static void uevent_handler(int fd) {
+    char buf[4096];
+    ssize_t len;
+    while ((len = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT)) > 0) {
+        buf[len] = '\0';
+        bypass_handle_uevent(buf, (size_t)len);
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : read_supplies
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Seeds the charger table from sysfs, uevents only report
+ *                      changes made after the daemon started.
+ ***********************************************************************************/
+static void read_supplies(void) {
+    char path[MAX_PATH_LENGTH * 2];
+    char value[32];
+    snprintf(path, sizeof(path), "%s/sys/class/power_supply", root_dir);
+    DIR* dir = opendir(path);
+    struct dirent* entry;
+
+    while (dir && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/class/power_supply/%s/online", entry->d_name);
+        int fd = open_rooted(path);
+        if (fd == -1)
+            continue;
+        memset(value, 0, sizeof(value));
+        if (read(fd, value, sizeof(value) - 1) > 0 && strcmp(entry->d_name, "battery") != 0)
+            set_supply_online(entry->d_name, atoi(value) == 1);
+        close(fd);
+    }
+    if (dir)
+        closedir(dir);
+
+    int fd = open_rooted("/sys/class/power_supply/battery/status");
+    memset(value, 0, sizeof(value));
+    if (fd != -1 && read(fd, value, sizeof(value) - 1) > 0)
+        battery_charging = strncmp(value, "Charging", 8) == 0 || strncmp(value, "Full", 4) == 0;
+    if (fd != -1)
+        close(fd);
+
+    charger_online = any_charger_online();
+}
+
+/***********************************************************************************
+ * Function Name      : bypass_charge_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : bool - true if the device has a usable bypass path
+ * Description        : Resolves the bypass path probed by checkBypass and
+ *                      subscribes to power_supply uevents over netlink. The
+ *                      root prefix lets a mocked sysfs stand in.
+ ***********************************************************************************/
+bool bypass_charge_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+
+    char name[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.bypasspath", name);
+    for (size_t i = 0; i < sizeof(bypass_paths) / sizeof(bypass_paths[0]); i++) {
+        if (strcmp(name, bypass_paths[i].name) == 0)
+            active_path = &bypass_paths[i];
+    }
+
+    if (!active_path) {
+        log_zenith(LOG_INFO, "Bypass charge unsupported (%s)", name[0] ? name : "unprobed");
+        return false;
+    }
+    snprintf(node_path, sizeof(node_path), "%s%s", root_dir, active_path->path);
+
+    for (size_t i = 0; i < sizeof(current_nodes) / sizeof(current_nodes[0]) && current_fd == -1; i++)
+        current_fd = open_rooted(current_nodes[i]);
+
+    profile_fd = open_rooted(PROFILE_MODE);
+
+    uevent_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (uevent_fd != -1) {
+        struct sockaddr_nl addr = {0};
+        addr.nl_family = AF_NETLINK;
+        addr.nl_pid = 0;
+        addr.nl_groups = 1;
+        if (bind(uevent_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+            close(uevent_fd);
+            uevent_fd = -1;
+        }
+    }
+
+    if (uevent_fd == -1) {
+        log_zenith(LOG_WARN, "Bypass charge: uevent socket unavailable, polling only");
+    } else {
+        event_loop_add(uevent_fd, uevent_handler);
+    }
+
+    read_supplies();
+    log_zenith(LOG_INFO, "Bypass charge controller ready via %s", active_path->name);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : bypass_charge_tick
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Follows the active profile (written by run_profiler, also
+ *                      for manual CLI switches), engages bypass while the
+ *                      performance profile runs on charger and checks the effect
+ *                      from streamed current samples. Never sleeps.
+ ***********************************************************************************/
+void bypass_charge_tick(void) {
+    if (!active_path)
+        return;
+
+    char enabled[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.bypasschg", enabled);
+
+    char buf[24] = {0};
+    if (profile_fd == -1)
+        profile_fd = open_rooted(PROFILE_MODE);
+    if (profile_fd != -1 && pread(profile_fd, buf, sizeof(buf) - 1, 0) > 0)
+        session_active = atoi(buf) == PERFORMANCE_PROFILE;
+
+    if (strcmp(enabled, "1") != 0 || !session_active || !charger_online) {
+        bypass_release();
+        return;
+    }
+
+    if (state == BYPASS_IDLE && attempts == 0)
+        bypass_engage();
+
+    if (state != BYPASS_VERIFYING)
+        return;
+
+    memset(buf, 0, sizeof(buf));
+    if (current_fd != -1 && pread(current_fd, buf, sizeof(buf) - 1, 0) > 0)
+        bypass_feed_current(current_to_ma(atol(buf)));
+
+    if (state == BYPASS_VERIFYING && now_ms() >= verify_deadline) {
+        if (attempts < BYPASS_MAX_ATTEMPTS) {
+            bypass_engage();
+        } else {
+            log_zenith(LOG_WARN, "Bypass failed after %d attempts", attempts);
+            bypass_write(active_path->off);
+            state = BYPASS_FAILED;
+        }
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : bypass_charge_state
+ * Inputs             : None
+ * Returns            : BypassState - where the controller currently is
+ * Description        : For replays and tests.
+ ***********************************************************************************/
+BypassState bypass_charge_state(void) {
+    return state;
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+typedef struct {
+    const char* group;
+    const char* uclamp_min;
+    const char* latency_sensitive;
+    int shares; // cgroup v1 cpu.shares, scaled to cpu.weight on v2
+} CgroupKnobs;
+
+typedef struct {
+    char path[MAX_PATH_LENGTH];
+    char value[32];
+} SavedKnob;
+
+static const CgroupKnobs perf_knobs[] = {
+    {"top-app", "30", "1", 2048},
+    {"foreground", "10", "0", 1024},
+    {CGROUP_BOOST_GROUP, "50", "1", 4096},
+};
+
+static const CgroupKnobs eco_knobs[] = {
+    {"top-app", "0", "0", 1024},
+    {"foreground", "0", "0", 1024},
+};
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static char cpu_dir[MAX_PATH_LENGTH] = "";
+static bool is_v2 = false;
+static SavedKnob saved[MAX_CGROUP_SAVED];
+static int nr_saved = 0;
+static pid_t boosted_pid = 0;
+static char game_group[MAX_PATH_LENGTH] = "";
+
+static bool read_line(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    bool ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        trim_newline(buf);
+    return ok;
+}
+
+static bool write_str(const char* path, const char* value) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    bool ok = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+    return ok;
+}
+
+/***********************************************************************************
+ * Function Name      : save_and_write
+ * Inputs             : path (const char *) - cgroup attribute
+ *                      value (const char *) - value to write
+ * Returns            : None
+ * Description        : Remembers the current value before the first write to an
+ *                      attribute, so restore puts back exactly what was there.
+ ***********************************************************************************/
+static void save_and_write(const char* path, const char* value) {
+    char old[32] = {0};
+    if (!read_line(path, old, sizeof(old)))
+        return;
+
+    bool known = false;
+    for (int i = 0; i < nr_saved; i++)
+        known |= strcmp(saved[i].path, path) == 0;
+
+    if (!known && nr_saved < MAX_CGROUP_SAVED) {
+        snprintf(saved[nr_saved].path, sizeof(saved[nr_saved].path), "%s", path);
+        snprintf(saved[nr_saved].value, sizeof(saved[nr_saved].value), "%s", old);
+        nr_saved++;
+    }
+
+    if (!write_str(path, value))
+        log_zenith(LOG_DEBUG, "cgroup boost: unable to write %s", path);
+}
+
+static void apply_knobs(const CgroupKnobs* knobs, size_t count) {
+    char path[MAX_PATH_LENGTH * 2];
+    char value[16];
+
+    for (size_t i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/%s/cpu.uclamp.min", cpu_dir, knobs[i].group);
+        save_and_write(path, knobs[i].uclamp_min);
+        snprintf(path, sizeof(path), "%s/%s/cpu.uclamp.latency_sensitive", cpu_dir, knobs[i].group);
+        save_and_write(path, knobs[i].latency_sensitive);
+
+        if (is_v2) {
+            // v1 default 1024 maps to v2 default 100
+            snprintf(path, sizeof(path), "%s/%s/cpu.weight", cpu_dir, knobs[i].group);
+            snprintf(value, sizeof(value), "%d", knobs[i].shares * 100 / 1024);
+        } else {
+            snprintf(path, sizeof(path), "%s/%s/cpu.shares", cpu_dir, knobs[i].group);
+            snprintf(value, sizeof(value), "%d", knobs[i].shares);
+        }
+        save_and_write(path, value);
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : move_tasks
+ * Inputs             : pid (pid_t) - process to move
+ * Returns            : None
+ * Description        : Moves a process into the AZenith boost group. v1 cpuctl
+ *                      moves every thread through tasks, v2 moves the process
+ *                      through cgroup.procs.
+ ***********************************************************************************/
+static void move_tasks(pid_t pid) {
+    char path[MAX_PATH_LENGTH * 2];
+    char line[32];
+
+    if (is_v2) {
+        snprintf(path, sizeof(path), "%s/%s/cgroup.procs", cpu_dir, CGROUP_BOOST_GROUP);
+        snprintf(line, sizeof(line), "%d", pid);
+        write_str(path, line);
+    } else {
+        char task_dir[MAX_PATH_LENGTH];
+        snprintf(task_dir, sizeof(task_dir), "%s/proc/%d/task", root_dir, pid);
+        snprintf(path, sizeof(path), "%s/%s/tasks", cpu_dir, CGROUP_BOOST_GROUP);
+        DIR* dir = opendir(task_dir);
+        struct dirent* entry;
+        while (dir && (entry = readdir(dir)) != NULL) {
+            if (isdigit((unsigned char)entry->d_name[0]))
+                write_str(path, entry->d_name);
+        }
+        if (dir)
+            closedir(dir);
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : move_game_tasks
+ * Inputs             : pid (pid_t) - game process
+ * Returns            : None
+ * Description        : Remembers the cpu cgroup of the game and moves it into
+ *                      the AZenith boost group.
+ ***********************************************************************************/
+static void move_game_tasks(pid_t pid) {
+    char path[MAX_PATH_LENGTH * 2];
+    char line[MAX_LINE];
+
+    // Find the current cpu controller group, "N:cpu:/top-app" or "0::/top-app"
+    snprintf(path, sizeof(path), "%s/proc/%d/cgroup", root_dir, pid);
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return;
+
+    game_group[0] = '\0';
+    while (fgets(line, sizeof(line), fp)) {
+        trim_newline(line);
+        char* controllers = strchr(line, ':');
+        char* group = controllers ? strchr(controllers + 1, ':') : NULL;
+        if (!group)
+            continue;
+        *group++ = '\0';
+        controllers++;
+        if ((is_v2 && controllers[0] == '\0') || (!is_v2 && strstr(controllers, "cpu") && !strstr(controllers, "cpuset"))) {
+            snprintf(game_group, sizeof(game_group), "%s", group[0] == '/' ? group + 1 : group);
+            break;
+        }
+    }
+    fclose(fp);
+
+    move_tasks(pid);
+    boosted_pid = pid;
+    log_zenith(LOG_DEBUG, "cgroup boost: moved %d from /%s", pid, game_group);
+}
+
+/***********************************************************************************
+ * Function Name      : release_game_tasks
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Moves whatever is still in the boost group back to the
+ *                      group the game came from. Tasks the framework already
+ *                      moved elsewhere are left alone.
+ ***********************************************************************************/
+static void release_game_tasks(void) {
+    if (boosted_pid == 0)
+        return;
+
+    char src[MAX_PATH_LENGTH * 2];
+    char dst[MAX_PATH_LENGTH * 2];
+    const char* file = is_v2 ? "cgroup.procs" : "tasks";
+    snprintf(src, sizeof(src), "%s/%s/%s", cpu_dir, CGROUP_BOOST_GROUP, file);
+    if (game_group[0])
+        snprintf(dst, sizeof(dst), "%s/%s/%s", cpu_dir, game_group, file);
+    else
+        snprintf(dst, sizeof(dst), "%s/%s", cpu_dir, file);
+
+    FILE* fp = fopen(src, "r");
+    char line[32];
+    while (fp && fgets(line, sizeof(line), fp)) {
+        trim_newline(line);
+        write_str(dst, line);
+    }
+    if (fp)
+        fclose(fp);
+
+    boosted_pid = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : cgroup_boost_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : bool - true if a cpu cgroup hierarchy with top-app exists
+ * Description        : Prefers the v1 cpuctl mount Android uses and falls back to
+ *                      the v2 unified hierarchy. The root prefix lets a mocked
+ *                      cgroupfs directory tree stand in for the real mounts.
+ ***********************************************************************************/
+bool cgroup_boost_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/dev/cpuctl/top-app", root_dir);
+    if (access(path, F_OK) == 0) {
+        snprintf(cpu_dir, sizeof(cpu_dir), "%s/dev/cpuctl", root_dir);
+        is_v2 = false;
+    } else {
+        char controllers[MAX_LINE] = {0};
+        snprintf(path, sizeof(path), "%s/sys/fs/cgroup/cgroup.controllers", root_dir);
+        if (!read_line(path, controllers, sizeof(controllers)) || !strstr(controllers, "cpu")) {
+            log_zenith(LOG_INFO, "cgroup boost: no cpu controller found");
+            return false;
+        }
+        snprintf(cpu_dir, sizeof(cpu_dir), "%s/sys/fs/cgroup", root_dir);
+        is_v2 = true;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", cpu_dir, CGROUP_BOOST_GROUP);
+    if (mkdir(path, 0755) == -1 && access(path, F_OK) != 0) {
+        log_zenith(LOG_WARN, "cgroup boost: unable to create %s", path);
+        cpu_dir[0] = '\0';
+        return false;
+    }
+
+    log_zenith(LOG_INFO, "cgroup boost ready on %s (%s)", cpu_dir, is_v2 ? "v2" : "v1 cpuctl");
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : cgroup_boost_restore
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Moves the game back and writes every saved attribute
+ *                      back in reverse order.
+ ***********************************************************************************/
+void cgroup_boost_restore(void) {
+    release_game_tasks();
+
+    for (int i = nr_saved - 1; i >= 0; i--)
+        write_str(saved[i].path, saved[i].value);
+    nr_saved = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : cgroup_boost_apply
+ * Inputs             : mode (ProfileMode) - profile being applied
+ *                      pid (pid_t) - game process, 0 if none
+ * Returns            : None
+ * Description        : Restores the previous profile's changes, then applies the
+ *                      uclamp/latency/shares table of the new profile. Balanced
+ *                      keeps the system values.
+ ***********************************************************************************/
+void cgroup_boost_apply(ProfileMode mode, pid_t pid) {
+    if (!cpu_dir[0])
+        return;
+
+    cgroup_boost_restore();
+
+    if (mode == PERFORMANCE_PROFILE) {
+        apply_knobs(perf_knobs, sizeof(perf_knobs) / sizeof(perf_knobs[0]));
+        if (pid > 0)
+            move_game_tasks(pid);
+    } else if (mode == ECO_MODE) {
+        apply_knobs(eco_knobs, sizeof(eco_knobs) / sizeof(eco_knobs[0]));
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : cgroup_boost_add
+ * Inputs             : pid (pid_t) - helper process of the boosted game
+ * Returns            : None
+ * Description        : Moves another process of the game into the boost group.
+ *                      Does nothing unless a game is boosted, restore sends it
+ *                      back to the group the game came from.
+ ***********************************************************************************/
+void cgroup_boost_add(pid_t pid) {
+    if (!cpu_dir[0] || boosted_pid == 0 || pid <= 0)
+        return;
+
+    move_tasks(pid);
+    log_zenith(LOG_DEBUG, "cgroup boost: moved helper %d", pid);
+}
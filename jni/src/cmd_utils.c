@@ -15,67 +15,211 @@
  */
 
 #include <AZenith.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+
+static pthread_mutex_t cmd_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cmd_slot = PTHREAD_COND_INITIALIZER;
+static int cmd_running = 0;
 
 /***********************************************************************************
- * Function Name      : execute_command
- * Inputs             : command (const char *) - shell command to execute
- * Returns            : char * - Pointer to the dynamically allocated output of the command
- *                      variadic arguments - Additional arguments for command
- * Description        : Executes a shell command and captures its output.
+ * Function Name      : open_output
+ * Inputs             : None
+ * Returns            : int - fd the child writes its stdout to, -1 on failure
+ * Description        : Output goes to an anonymous memfd rather than a pipe, so
+ *                      it is never truncated, a child can't stall on a full pipe
+ *                      and a background grandchild holding stdout open doesn't
+ *                      keep the caller reading.
  ***********************************************************************************/
-char* execute_command(const char* format, ...) {
-    char command[MAX_COMMAND_LENGTH];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(command, sizeof(command), format, args);
-    va_end(args);
+static int open_output(void) {
+    int fd = (int)syscall(__NR_memfd_create, "azenith-cmd", MFD_CLOEXEC);
+    if (fd != -1)
+        return fd;
+
+    FILE* tmp = tmpfile();
+    if (!tmp)
+        return -1;
+    fd = fcntl(fileno(tmp), F_DUPFD_CLOEXEC, 0);
+    fclose(tmp);
+    return fd;
+}
 
-    int pipefd[2];
-    if (pipe(pipefd) == -1) [[clang::unlikely]] {
-        log_zenith(LOG_ERROR, "pipe failed in execute_command()");
+static char* read_output(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) == -1)
         return NULL;
-    }
 
-    pid_t pid = fork();
-    if (pid == -1) [[clang::unlikely]] {
-        close(pipefd[0]);
-        close(pipefd[1]);
-        log_zenith(LOG_ERROR, "fork failed in execute_command()");
+    char* buf = malloc((size_t)st.st_size + 1);
+    if (!buf)
         return NULL;
+
+    ssize_t total = 0;
+    while (total < st.st_size) {
+        ssize_t bytes = pread(fd, buf + total, (size_t)(st.st_size - total), total);
+        if (bytes <= 0)
+            break;
+        total += bytes;
     }
+    buf[total] = '\0';
+    return buf;
+}
+
+/***********************************************************************************
+ * Function Name      : wait_exit
+ * Inputs             : pid (pid_t) - child to reap
+ *                      pidfd (int) - pidfd of the child, -1 if unsupported
+ *                      timeout_ms (int) - how long to wait
+ *                      status (int *) - wait status of the child
+ * Returns            : bool - true once the child was reaped
+ * Description        : Sleeps on the pidfd until the child exits. Kernels before
+ *                      5.3 have no pidfd_open, there the child is polled every
+ *                      10 ms instead.
+ ***********************************************************************************/
+static bool wait_exit(pid_t pid, int pidfd, int timeout_ms, int* status) {
+    int64_t deadline = now_ms() + timeout_ms;
+
+    while (true) {
+        pid_t ret = waitpid(pid, status, WNOHANG);
+        if (ret == pid)
+            return true;
+        if (ret == -1 && errno != EINTR) {
+            *status = 0;
+            return true;
+        }
+
+        int64_t remaining = deadline - now_ms();
+        if (remaining <= 0)
+            return false;
+
+        if (pidfd != -1) {
+            struct pollfd pfd = {.fd = pidfd, .events = POLLIN};
+            poll(&pfd, 1, (int)remaining);
+        } else {
+            usleep((useconds_t)(remaining < 10 ? remaining : 10) * 1000);
+        }
+    }
+}
 
+/***********************************************************************************
+ * Function Name      : run_process
+ * Inputs             : path (const char *) - executable
+ *                      argv (char *const []) - arguments, NULL terminated
+ *                      envp (char *const []) - environment, NULL to inherit
+ *                      out_fd (int) - stdout of the child, -1 to inherit
+ *                      timeout_ms (int) - deadline for the child to exit
+ *                      what (const char *) - command line for the log
+ *                      idle (bool) - run at SCHED_IDLE and idle I/O priority
+ * Returns            : int - exit status of the child
+ *                           -1 if it could not run, timed out or was killed
+ * Description        : Runs the child in its own process group. Past the deadline
+ *                      the group gets SIGTERM, and SIGKILL once the child is gone
+ *                      or CMD_KILL_GRACE_MS later. At most CMD_MAX_CONCURRENT
+ *                      children run at once, callers beyond that wait for a slot.
+ ***********************************************************************************/
+static int run_process(const char* path, char* const argv[], char* const envp[], int out_fd, int timeout_ms,
+                       const char* what, bool idle) {
+    pthread_mutex_lock(&cmd_lock);
+    while (cmd_running >= CMD_MAX_CONCURRENT)
+        pthread_cond_wait(&cmd_slot, &cmd_lock);
+    cmd_running++;
+    stats.cmd_runs++;
+    pthread_mutex_unlock(&cmd_lock);
+
+    int status = 0;
+    bool timed_out = false;
+    bool hung = false;
+
+    pid_t pid = fork();
     if (pid == 0) {
-        dup2(pipefd[1], STDOUT_FILENO);
-        close(pipefd[0]);
-        close(pipefd[1]);
+        setpgid(0, 0);
+        footprint_child_reset();
+        if (idle)
+            footprint_idle_child();
+        if (out_fd != -1)
+            dup2(out_fd, STDOUT_FILENO);
 
-        char* env[] = {MY_PATH, NULL};
-        execle("/system/bin/sh", "sh", "-c", command, NULL, env);
+        if (envp)
+            execve(path, argv, envp);
+        else
+            execv(path, argv);
         _exit(127);
     }
 
-    close(pipefd[1]);
+    if (pid == -1) [[clang::unlikely]] {
+        log_zenith(LOG_ERROR, "fork failed for %s", what);
+        status = -1;
+    } else {
+        // Either side may get here first, the group has to exist before a kill
+        setpgid(pid, pid);
+        int pidfd = (int)syscall(__NR_pidfd_open, pid, 0);
 
-    char output[MAX_OUTPUT_LENGTH] = {0};
-    ssize_t total_read = 0;
-    while (1) {
-        ssize_t bytes = read(pipefd[0], output + total_read, sizeof(output) - total_read - 1);
-        if (bytes <= 0)
-            break;
+        if (!wait_exit(pid, pidfd, timeout_ms, &status)) {
+            timed_out = true;
+            log_zenith(LOG_WARN, "Command timed out after %d ms: %s", timeout_ms, what);
+            kill(-pid, SIGTERM);
+            if (!wait_exit(pid, pidfd, CMD_KILL_GRACE_MS, &status)) {
+                hung = true;
+                kill(-pid, SIGKILL);
+                waitpid(pid, &status, 0);
+            }
+            // The shell may go on SIGTERM while what it started ignores it
+            kill(-pid, SIGKILL);
+        }
+        if (pidfd != -1)
+            close(pidfd);
+    }
 
-        total_read += bytes;
+    pthread_mutex_lock(&cmd_lock);
+    cmd_running--;
+    stats.cmd_timeouts += timed_out;
+    stats.cmd_hangs += hung;
+    pthread_cond_signal(&cmd_slot);
+    pthread_mutex_unlock(&cmd_lock);
 
-        if (total_read >= (ssize_t)(sizeof(output) - 1))
-            break;
-    }
-    close(pipefd[0]);
+    if (pid == -1 || timed_out)
+        return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static int run_shell(const char* command, int out_fd, int timeout_ms, bool idle) {
+    char* const argv[] = {"sh", "-c", (char*)command, NULL};
+    char* const env[] = {MY_PATH, NULL};
+    return run_process(CMD_SHELL, argv, env, out_fd, timeout_ms, command, idle);
+}
+
+/***********************************************************************************
+ * Function Name      : execute_command
+ * Inputs             : command (const char *) - shell command to execute
+ *                      variadic arguments - Additional arguments for command
+ * Returns            : char * - Pointer to the dynamically allocated output of the command
+ * Description        : Executes a shell command and captures its output. Gives
+ *                      up after CMD_TIMEOUT_MS.
+ * Note               : Caller is responsible for freeing the returned string.
+ ***********************************************************************************/
+char* execute_command(const char* format, ...) {
+    char command[MAX_COMMAND_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(command, sizeof(command), format, args);
+    va_end(args);
 
-    int status;
-    waitpid(pid, &status, 0);
-    if (WEXITSTATUS(status))
+    int fd = open_output();
+    if (fd == -1) [[clang::unlikely]] {
+        log_zenith(LOG_ERROR, "Unable to capture output in execute_command()");
         return NULL;
+    }
 
-    return strdup(trim_newline(output));
+    char* output = run_shell(command, fd, CMD_TIMEOUT_MS, false) == 0 ? read_output(fd) : NULL;
+    close(fd);
+    return output ? trim_newline(output) : NULL;
 }
 
 /***********************************************************************************
@@ -84,7 +228,8 @@ char* execute_command(const char* format, ...) {
  *                      arg0 (const char *) - First argument (typically the program name)
  *                      variadic arguments - Additional arguments, must end with NULL
  * Returns            : char * - Pointer to the dynamically allocated output of the command
- * Description        : Executes a binary directly with specified arguments and captures output.
+ * Description        : Executes a binary directly with specified arguments and
+ *                      captures output. Gives up after CMD_TIMEOUT_MS.
  * Note               : Caller is responsible for freeing the returned string.
  ***********************************************************************************/
 char* execute_direct(const char* path, const char* arg0, ...) {
@@ -102,51 +247,51 @@ char* execute_direct(const char* path, const char* arg0, ...) {
     argv[argc] = NULL;
     va_end(args);
 
-    int pipefd[2];
-    if (pipe(pipefd) == -1) [[clang::unlikely]] {
-        log_zenith(LOG_ERROR, "pipe failed in execute_direct()");
-        return NULL;
-    }
-
-    pid_t pid = fork();
-    if (pid == -1) [[clang::unlikely]] {
-        close(pipefd[0]);
-        close(pipefd[1]);
-        log_zenith(LOG_ERROR, "fork failed in execute_direct()");
+    int fd = open_output();
+    if (fd == -1) [[clang::unlikely]] {
+        log_zenith(LOG_ERROR, "Unable to capture output in execute_direct()");
         return NULL;
     }
 
-    if (pid == 0) {
-        dup2(pipefd[1], STDOUT_FILENO);
-        close(pipefd[0]);
-        close(pipefd[1]);
-
-        execv(path, (char* const*)argv);
-        _exit(127);
-    }
-
-    close(pipefd[1]);
-
-    char output[MAX_OUTPUT_LENGTH] = {0};
-    ssize_t total_read = 0;
-    while (1) {
-        ssize_t bytes = read(pipefd[0], output + total_read, sizeof(output) - total_read - 1);
-        if (bytes <= 0)
-            break;
-
-        total_read += bytes;
+    char* output = run_process(path, (char* const*)argv, NULL, fd, CMD_TIMEOUT_MS, path, false) == 0 ? read_output(fd) : NULL;
+    close(fd);
+    return output ? trim_newline(output) : NULL;
+}
 
-        if (total_read >= (ssize_t)(sizeof(output) - 1))
-            break;
-    }
-    close(pipefd[0]);
+/***********************************************************************************
+ * Function Name      : popen_deadline
+ * Inputs             : timeout_ms (int) - deadline for the command
+ *                      format (const char *) - shell command to execute
+ *                      variadic arguments - other arguments
+ * Returns            : FILE * - stream over the command output, NULL on failure
+ *                      or timeout
+ * Description        : Read-only popen() replacement. The command has finished
+ *                      by the time this returns, its output is read back from
+ *                      memory. Close the stream with fclose(), not pclose().
+ ***********************************************************************************/
+FILE* popen_deadline(int timeout_ms, const char* format, ...) {
+    char command[MAX_COMMAND_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(command, sizeof(command), format, args);
+    va_end(args);
 
-    int status;
-    waitpid(pid, &status, 0);
-    if (WEXITSTATUS(status))
+    int fd = open_output();
+    if (fd == -1) [[clang::unlikely]]
         return NULL;
 
-    return strdup(trim_newline(output));
+    FILE* fp = NULL;
+    if (run_shell(command, fd, timeout_ms, false) != -1 && lseek(fd, 0, SEEK_SET) == 0)
+        fp = fdopen(fd, "r");
+    if (!fp)
+        close(fd);
+    return fp;
+}
+
+static int vsystemv(int timeout_ms, bool idle, const char* format, va_list args) {
+    char command[MAX_COMMAND_LENGTH];
+    vsnprintf(command, sizeof(command), format, args);
+    return run_shell(command, -1, timeout_ms, idle);
 }
 
 /***********************************************************************************
@@ -154,37 +299,49 @@ char* execute_direct(const char* path, const char* arg0, ...) {
  * Inputs             : format (const char *) - shell command to execute
  *                      variadic arguments - other arguments
  * Returns            : int - 0 if execution success
- *                           -1 if execution failed
+ *                           -1 if execution failed or timed out
  *                            * other if command returns an error
- * Description        : Executes a shell command just like system() with additional format.
+ * Description        : Executes a shell command just like system() with additional
+ *                      format. Gives up after CMD_TIMEOUT_MS.
  ***********************************************************************************/
 int systemv(const char* format, ...) {
-    char command[MAX_COMMAND_LENGTH];
     va_list args;
     va_start(args, format);
-    vsnprintf(command, sizeof(command), format, args);
+    int ret = vsystemv(CMD_TIMEOUT_MS, false, format, args);
     va_end(args);
+    return ret;
+}
 
-    pid_t pid = fork();
-    if (pid == -1) [[clang::unlikely]] {
-        log_zenith(LOG_ERROR, "fork failed in systemv()");
-        return -1;
-    }
-
-    if (pid == 0) {
-        char* env[] = {MY_PATH, NULL};
-        execle("/system/bin/sh", "sh", "-c", command, NULL, env);
-
-        // If exec fails
-        _exit(127);
-    }
-
-    int status;
-    if (waitpid(pid, &status, 0) == -1)
-        return -1;
-
-    if (WIFEXITED(status))
-        return WEXITSTATUS(status);
+/***********************************************************************************
+ * Function Name      : systemv_deadline
+ * Inputs             : timeout_ms (int) - deadline for the command
+ *                      format (const char *) - shell command to execute
+ *                      variadic arguments - other arguments
+ * Returns            : int - same as systemv()
+ * Description        : systemv() for commands that legitimately run longer.
+ ***********************************************************************************/
+int systemv_deadline(int timeout_ms, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int ret = vsystemv(timeout_ms, false, format, args);
+    va_end(args);
+    return ret;
+}
 
-    return -1;
+/***********************************************************************************
+ * Function Name      : systemv_idle
+ * Inputs             : timeout_ms (int) - deadline for the command
+ *                      format (const char *) - shell command to execute
+ *                      variadic arguments - other arguments
+ * Returns            : int - same as systemv()
+ * Description        : systemv_deadline() for maintenance work. The command and
+ *                      everything it starts run at SCHED_IDLE in the idle I/O
+ *                      class, so they only use time a game leaves over.
+ ***********************************************************************************/
+int systemv_idle(int timeout_ms, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int ret = vsystemv(timeout_ms, true, format, args);
+    va_end(args);
+    return ret;
 }
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+CpuCluster clusters[MAX_CLUSTERS];
+int nr_clusters = 0;
+
+/***********************************************************************************
+ * Function Name      : read_int_file
+ * Inputs             : path (const char *) - file to read
+ *                      fallback (int) - value returned on failure
+ * Returns            : int - first integer found in the file
+ * Description        : Reads a single integer from a sysfs/procfs node.
+ ***********************************************************************************/
+int read_int_file(const char* path, int fallback) {
+    char buf[64] = {0};
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return fallback;
+
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0)
+        return fallback;
+
+    buf[len] = '\0';
+    return atoi(buf);
+}
+
+/***********************************************************************************
+ * Function Name      : parse_cpu_list
+ * Inputs             : list (const char *) - cpu list, e.g. "0-3,6 7"
+ * Returns            : uint64_t - cpu bitmask
+ * Description        : Converts a kernel cpu list string into a bitmask.
+ ***********************************************************************************/
+uint64_t parse_cpu_list(const char* list) {
+    uint64_t mask = 0;
+    const char* p = list;
+
+    while (*p) {
+        if (!isdigit((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+
+        for (long cpu = first; cpu <= last && cpu < MAX_CPUS; cpu++)
+            mask |= 1ULL << cpu;
+
+        p = end;
+    }
+
+    return mask;
+}
+
+static int compare_int(const void* a, const void* b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+static int compare_cluster(const void* a, const void* b) {
+    return ((const CpuCluster*)a)->policy - ((const CpuCluster*)b)->policy;
+}
+
+/***********************************************************************************
+ * Function Name      : cpu_topology_init
+ * Inputs             : None
+ * Returns            : int - number of clusters discovered
+ * Description        : Discovers cpufreq policies and caches their cpu masks and
+ *                      frequency tables, ordered by policy number. The cluster
+ *                      index matches the PPM cluster index.
+ ***********************************************************************************/
+int cpu_topology_init(void) {
+    DIR* dir = opendir(CPUFREQ_PATH);
+    if (!dir) {
+        log_zenith(LOG_WARN, "Unable to open %s", CPUFREQ_PATH);
+        return 0;
+    }
+
+    nr_clusters = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && nr_clusters < MAX_CLUSTERS) {
+        if (strncmp(entry->d_name, "policy", 6) != 0 || !isdigit((unsigned char)entry->d_name[6]))
+            continue;
+
+        CpuCluster* c = &clusters[nr_clusters];
+        memset(c, 0, sizeof(*c));
+        c->policy = atoi(entry->d_name + 6);
+
+        char path[MAX_PATH_LENGTH];
+        char buf[MAX_DATA_LENGTH] = {0};
+
+        snprintf(path, sizeof(path), "%s/%s/related_cpus", CPUFREQ_PATH, entry->d_name);
+        FILE* fp = fopen(path, "r");
+        if (fp) {
+            if (fgets(buf, sizeof(buf), fp))
+                c->cpu_mask = parse_cpu_list(buf);
+            fclose(fp);
+        }
+        if (!c->cpu_mask)
+            c->cpu_mask = 1ULL << c->policy;
+
+        snprintf(path, sizeof(path), "%s/%s/cpuinfo_max_freq", CPUFREQ_PATH, entry->d_name);
+        c->cpuinfo_max = read_int_file(path, 0);
+        snprintf(path, sizeof(path), "%s/%s/cpuinfo_min_freq", CPUFREQ_PATH, entry->d_name);
+        c->cpuinfo_min = read_int_file(path, 0);
+
+        snprintf(path, sizeof(path), "%s/%s/scaling_available_frequencies", CPUFREQ_PATH, entry->d_name);
+        fp = fopen(path, "r");
+        if (fp) {
+            while (c->nr_freqs < MAX_CLUSTER_FREQS && fscanf(fp, "%d", &c->freqs[c->nr_freqs]) == 1)
+                c->nr_freqs++;
+            fclose(fp);
+        }
+
+        // Some drivers don't expose a table, fall back to the hardware range
+        if (c->nr_freqs == 0) {
+            c->freqs[c->nr_freqs++] = c->cpuinfo_min;
+            c->freqs[c->nr_freqs++] = c->cpuinfo_max;
+        }
+        qsort(c->freqs, c->nr_freqs, sizeof(int), compare_int);
+
+        nr_clusters++;
+    }
+    closedir(dir);
+
+    qsort(clusters, nr_clusters, sizeof(CpuCluster), compare_cluster);
+
+    for (int i = 0; i < nr_clusters; i++) {
+        log_zenith(LOG_DEBUG, "Cluster %d: policy%d mask=0x%llx freq=%d-%d (%d steps)", i, clusters[i].policy,
+                   (unsigned long long)clusters[i].cpu_mask, clusters[i].cpuinfo_min, clusters[i].cpuinfo_max,
+                   clusters[i].nr_freqs);
+    }
+
+    return nr_clusters;
+}
+
+/***********************************************************************************
+ * Function Name      : cluster_floor_freq
+ * Inputs             : c (const CpuCluster *) - target cluster
+ *                      target (int) - wanted frequency in kHz
+ * Returns            : int - highest available frequency not above target
+ * Description        : Snaps a frequency to the cluster frequency table.
+ ***********************************************************************************/
+int cluster_floor_freq(const CpuCluster* c, int target) {
+    int best = c->freqs[0];
+    for (int i = 0; i < c->nr_freqs; i++) {
+        if (c->freqs[i] <= target)
+            best = c->freqs[i];
+    }
+    return best;
+}
+
+/***********************************************************************************
+ * Function Name      : cluster_nearest_freq
+ * Inputs             : c (const CpuCluster *) - target cluster
+ *                      target (int) - wanted frequency in kHz
+ * Returns            : int - closest available frequency
+ * Description        : Same rounding as setfreqs() in profilesettings.
+ ***********************************************************************************/
+int cluster_nearest_freq(const CpuCluster* c, int target) {
+    int best = target;
+    int min_diff = INT32_MAX;
+    for (int i = 0; i < c->nr_freqs; i++) {
+        int diff = abs(target - c->freqs[i]);
+        if (diff < min_diff) {
+            min_diff = diff;
+            best = c->freqs[i];
+        }
+    }
+    return best;
+}
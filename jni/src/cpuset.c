@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+// Ordered from most to least important, the planner relies on this order
+static const char* const cpuset_groups[NR_CPUSET_GROUPS] = {"top-app", "foreground", "background", "system-background"};
+
+static char cpuset_dir[MAX_PATH_LENGTH] = "";
+static char online_path[MAX_PATH_LENGTH] = "";
+static char cpus_file[16] = "cpus";
+static char vendor[NR_CPUSET_GROUPS][MAX_LINE];
+static bool applied = false;
+
+static bool read_line(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    bool ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        trim_newline(buf);
+    return ok;
+}
+
+static bool write_str(const char* path, const char* value) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    bool ok = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+    return ok;
+}
+
+static void group_path(char* buf, size_t size, int group) {
+    snprintf(buf, size, "%s/%s/%s", cpuset_dir, cpuset_groups[group], cpus_file);
+}
+
+/***********************************************************************************
+ * Function Name      : cpu_mask_to_list
+ * Inputs             : mask (uint64_t) - cpu bitmask
+ *                      buf (char *) - output buffer
+ *                      size (size_t) - size of buf
+ * Returns            : char * - buf, e.g. "0-3,6"
+ * Description        : Inverse of parse_cpu_list, produces the format cpuset
+ *                      expects.
+ ***********************************************************************************/
+char* cpu_mask_to_list(uint64_t mask, char* buf, size_t size) {
+    size_t len = 0;
+    buf[0] = '\0';
+
+    for (int cpu = 0; cpu < MAX_CPUS && len < size; cpu++) {
+        if (!(mask & (1ULL << cpu)))
+            continue;
+
+        int last = cpu;
+        while (last + 1 < MAX_CPUS && (mask & (1ULL << (last + 1))))
+            last++;
+
+        if (last == cpu)
+            len += snprintf(buf + len, size - len, "%s%d", len ? "," : "", cpu);
+        else
+            len += snprintf(buf + len, size - len, "%s%d-%d", len ? "," : "", cpu, last);
+        cpu = last;
+    }
+
+    return buf;
+}
+
+/***********************************************************************************
+ * Function Name      : cpuset_online_mask
+ * Inputs             : None
+ * Returns            : uint64_t - online cpus, 0 if unknown
+ * Description        : Reads the kernel online cpu list.
+ ***********************************************************************************/
+uint64_t cpuset_online_mask(void) {
+    char buf[MAX_LINE] = {0};
+    if (!read_line(online_path[0] ? online_path : "/sys/devices/system/cpu/online", buf, sizeof(buf)))
+        return 0;
+    return parse_cpu_list(buf);
+}
+
+/***********************************************************************************
+ * Function Name      : cpuset_plan
+ * Inputs             : mode (ProfileMode) - profile to plan for
+ *                      online (uint64_t) - online cpus
+ *                      plan (CpusetPlan *) - filled with one mask per group
+ * Returns            : bool - false if the profile keeps the vendor cpusets
+ * Description        : Derives the masks from the discovered clusters.
+ *                      Performance gives the prime cluster to top-app alone and
+ *                      keeps background work on the little cluster, eco keeps
+ *                      everything off the prime cluster. A prime cluster only
+ *                      exists with three or more clusters, on two cluster SoCs
+ *                      the big cores stay shared.
+ ***********************************************************************************/
+bool cpuset_plan(ProfileMode mode, uint64_t online, CpusetPlan* plan) {
+    memset(plan, 0, sizeof(*plan));
+    if (nr_clusters == 0 || online == 0 || (mode != PERFORMANCE_PROFILE && mode != ECO_MODE))
+        return false;
+
+    uint64_t little = clusters[0].cpu_mask & online;
+    uint64_t prime = nr_clusters >= 3 ? clusters[nr_clusters - 1].cpu_mask & online : 0;
+    uint64_t shared = online & ~prime;
+
+    // Hotplug can take a whole cluster offline, fall back to what is left
+    if (!little)
+        little = shared ? shared : online;
+    if (!shared)
+        shared = online;
+
+    if (mode == PERFORMANCE_PROFILE) {
+        plan->mask[CPUSET_TOP_APP] = online;
+        plan->mask[CPUSET_FOREGROUND] = shared;
+    } else {
+        plan->mask[CPUSET_TOP_APP] = shared;
+        plan->mask[CPUSET_FOREGROUND] = shared;
+    }
+    plan->mask[CPUSET_BACKGROUND] = little;
+    plan->mask[CPUSET_SYSTEM_BACKGROUND] = little;
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : cpuset_validate
+ * Inputs             : plan (const CpusetPlan *) - planned masks
+ *                      online (uint64_t) - online cpus
+ * Returns            : const char * - NULL if the plan is sane, reason otherwise
+ * Description        : Every mask must be non-empty, only hold online cpus and
+ *                      never give a less important group cpus a more important
+ *                      group cannot use.
+ ***********************************************************************************/
+const char* cpuset_validate(const CpusetPlan* plan, uint64_t online) {
+    for (int i = 0; i < NR_CPUSET_GROUPS; i++) {
+        if (plan->mask[i] == 0)
+            return "empty mask";
+        if (plan->mask[i] & ~online)
+            return "mask contains offline cpus";
+        if (i > 0 && (plan->mask[i] & ~plan->mask[i - 1]))
+            return "mask is wider than the group above it";
+    }
+    return NULL;
+}
+
+/***********************************************************************************
+ * Function Name      : cpuset_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : bool - true if all groups were found
+ * Description        : Finds the cpuset mount and snapshots the vendor masks,
+ *                      which are what balanced and restore go back to.
+ ***********************************************************************************/
+bool cpuset_init(const char* root) {
+    if (!root)
+        root = "";
+
+    snprintf(cpuset_dir, sizeof(cpuset_dir), "%s/dev/cpuset", root);
+    snprintf(online_path, sizeof(online_path), "%s/sys/devices/system/cpu/online", root);
+
+    // Android mounts cpuset with noprefix, upstream names it cpuset.cpus
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/top-app/cpus", cpuset_dir);
+    snprintf(cpus_file, sizeof(cpus_file), "%s", access(path, F_OK) == 0 ? "cpus" : "cpuset.cpus");
+
+    for (int i = 0; i < NR_CPUSET_GROUPS; i++) {
+        group_path(path, sizeof(path), i);
+        if (!read_line(path, vendor[i], sizeof(vendor[i])) || !vendor[i][0]) {
+            log_zenith(LOG_INFO, "Cpuset: %s not available", path);
+            cpuset_dir[0] = '\0';
+            return false;
+        }
+    }
+
+    log_zenith(LOG_DEBUG, "Cpuset: vendor top-app=%s fg=%s bg=%s sys-bg=%s", vendor[0], vendor[1], vendor[2], vendor[3]);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : write_groups
+ * Inputs             : values (char [][MAX_LINE]) - cpu list per group
+ *                      order (const int *) - groups in write order
+ * Returns            : int - number of groups written before a failure
+ * Description        : Stops at the first rejected write.
+ ***********************************************************************************/
+static int write_groups(char values[][MAX_LINE], const int* order) {
+    char path[MAX_PATH_LENGTH * 2];
+    for (int n = 0; n < NR_CPUSET_GROUPS; n++) {
+        group_path(path, sizeof(path), order[n]);
+        if (!write_str(path, values[order[n]])) {
+            log_zenith(LOG_WARN, "Cpuset: unable to write %s to %s", values[order[n]], path);
+            return n;
+        }
+    }
+    return NR_CPUSET_GROUPS;
+}
+
+/***********************************************************************************
+ * Function Name      : cpuset_apply
+ * Inputs             : mode (ProfileMode) - profile being applied
+ * Returns            : bool - true if the cpusets match the profile
+ * Description        : Validates the plan, then writes all groups. If any write
+ *                      is rejected, the groups already written are put back to
+ *                      their previous masks so the system never runs with half
+ *                      a plan. Profiles without a plan restore the vendor masks.
+ ***********************************************************************************/
+bool cpuset_apply(ProfileMode mode) {
+    if (!cpuset_dir[0])
+        return false;
+
+    uint64_t online = cpuset_online_mask();
+    CpusetPlan plan;
+    if (!cpuset_plan(mode, online, &plan)) {
+        cpuset_restore();
+        return true;
+    }
+
+    const char* err = cpuset_validate(&plan, online);
+    if (err) {
+        log_zenith(LOG_WARN, "Cpuset: refusing plan for profile %d, %s", mode, err);
+        cpuset_restore();
+        return false;
+    }
+
+    char prev[NR_CPUSET_GROUPS][MAX_LINE];
+    char next[NR_CPUSET_GROUPS][MAX_LINE];
+    char path[MAX_PATH_LENGTH * 2];
+    int order[NR_CPUSET_GROUPS];
+    int nr_narrow = 0;
+    int nr_widen = 0;
+
+    for (int i = 0; i < NR_CPUSET_GROUPS; i++) {
+        group_path(path, sizeof(path), i);
+        if (!read_line(path, prev[i], sizeof(prev[i])))
+            snprintf(prev[i], sizeof(prev[i]), "%s", vendor[i]);
+        cpu_mask_to_list(plan.mask[i], next[i], sizeof(next[i]));
+
+        // cpu_exclusive siblings must give cpus up before another group takes them
+        if (plan.mask[i] & ~parse_cpu_list(prev[i]))
+            order[NR_CPUSET_GROUPS - 1 - nr_widen++] = i;
+        else
+            order[nr_narrow++] = i;
+    }
+
+    int done = write_groups(next, order);
+    if (done < NR_CPUSET_GROUPS) {
+        // Undo in reverse, the last successful write first
+        for (int n = done - 1; n >= 0; n--) {
+            group_path(path, sizeof(path), order[n]);
+            write_str(path, prev[order[n]]);
+        }
+        log_zenith(LOG_ERROR, "Cpuset: profile %d rejected by the kernel, rolled back", mode);
+        return false;
+    }
+
+    applied = true;
+    log_zenith(LOG_DEBUG, "Cpuset: top-app=%s fg=%s bg=%s sys-bg=%s", next[0], next[1], next[2], next[3]);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : cpuset_restore
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Puts the vendor masks back if AZenith changed them.
+ ***********************************************************************************/
+void cpuset_restore(void) {
+    if (!applied || !cpuset_dir[0])
+        return;
+
+    const int order[NR_CPUSET_GROUPS] = {CPUSET_TOP_APP, CPUSET_FOREGROUND, CPUSET_BACKGROUND, CPUSET_SYSTEM_BACKGROUND};
+    if (write_groups(vendor, order) == NR_CPUSET_GROUPS)
+        applied = false;
+}
+
+/***********************************************************************************
+ * Function Name      : handle_cpuset_check
+ * Inputs             : argc - number of CLI arguments
+ *                      argv - array of CLI argument strings
+ * Returns            : int - 0 if every profile plan is valid, 1 otherwise
+ * Description        : Prints the current and planned masks for each profile
+ *                      against the online cpus without writing anything.
+ *                      An optional root checks a mocked tree instead of /.
+ ***********************************************************************************/
+int handle_cpuset_check(int argc, char** argv) {
+    if (cpu_topology_init() == 0) {
+        fprintf(stderr, "\033[31mERROR:\033[0m Unable to discover cpu clusters\n");
+        return 1;
+    }
+
+    bool have_cpuset = cpuset_init(argc > 2 ? argv[2] : NULL);
+    uint64_t online = cpuset_online_mask();
+    char buf[MAX_LINE];
+
+    printf("Online: %s\n", cpu_mask_to_list(online, buf, sizeof(buf)));
+    for (int i = 0; i < nr_clusters; i++)
+        printf("Cluster %d: %s\n", i, cpu_mask_to_list(clusters[i].cpu_mask, buf, sizeof(buf)));
+
+    if (have_cpuset) {
+        for (int i = 0; i < NR_CPUSET_GROUPS; i++)
+            printf("Current %s: %s\n", cpuset_groups[i], vendor[i]);
+    } else {
+        printf("Current: cpuset groups not found\n");
+    }
+
+    int ret = 0;
+    const ProfileMode modes[] = {PERFORMANCE_PROFILE, ECO_MODE};
+    const char* names[] = {"Performance", "Eco"};
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        CpusetPlan plan;
+        if (!cpuset_plan(modes[m], online, &plan)) {
+            printf("%s: no plan\n", names[m]);
+            ret = 1;
+            continue;
+        }
+
+        for (int i = 0; i < NR_CPUSET_GROUPS; i++)
+            printf("%s %s: %s\n", names[m], cpuset_groups[i], cpu_mask_to_list(plan.mask[i], buf, sizeof(buf)));
+
+        const char* err = cpuset_validate(&plan, online);
+        printf("%s: %s\n", names[m], err ? err : "OK");
+        if (err)
+            ret = 1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+DaemonStats stats = {0};
+static int64_t last_flush = 0;
+static uint64_t last_wakeups = 0;
+
+/***********************************************************************************
+ * Function Name      : stats_flush
+ * Inputs             : force (bool) - write even if the flush interval has not passed
+ * Returns            : None
+ * Description        : Publishes daemon counters to DAEMON_STATS as key=value
+ *                      lines. Rate limited to one write per STATS_FLUSH_MS.
+ ***********************************************************************************/
+void stats_flush(bool force) {
+    int64_t now = now_ms();
+    if (!force && now - last_flush < STATS_FLUSH_MS)
+        return;
+    if (now > last_flush && last_flush > 0)
+        stats.wakeups_per_min = (stats.wakeups - last_wakeups) * 60000 / (uint64_t)(now - last_flush);
+    last_flush = now;
+    last_wakeups = stats.wakeups;
+    footprint_sample();
+
+    write2file(DAEMON_STATS, false, false,
+               "freq_enforce_writes=%llu\n"
+               "freq_enforce_conflicts=%llu\n"
+               "load_samples=%llu\n"
+               "load_sampler_cpu_us=%llu\n"
+               "input_boosts=%llu\n"
+               "input_boost_suppressed=%llu\n"
+               "gpu_floor_changes=%llu\n"
+               "mem_stall_some_ms=%llu\n"
+               "mem_stall_full_ms=%llu\n"
+               "session_mem_stall_some_ms=%llu\n"
+               "session_mem_stall_full_ms=%llu\n"
+               "vm_adjustments=%llu\n"
+               "procs_frozen=%llu\n"
+               "blk_loads=%llu\n"
+               "blk_load_read_kbps=%llu\n"
+               "blk_load_read_lat_us=%llu\n"
+               "sessions_recorded=%llu\n"
+               "init_ms=%llu\n"
+               "boot_to_profile_ms=%llu\n"
+               "cmd_runs=%llu\n"
+               "cmd_timeouts=%llu\n"
+               "cmd_hangs=%llu\n"
+               "wakeups=%llu\n"
+               "wakeups_per_min=%llu\n"
+               "timer_fires=%llu\n"
+               "forks=%llu\n"
+               "self_rss_kb=%llu\n"
+               "self_cpu_ms=%llu\n"
+               "child_cpu_ms=%llu\n",
+               (unsigned long long)stats.freq_enforce_writes, (unsigned long long)stats.freq_enforce_conflicts,
+               (unsigned long long)stats.load_samples, (unsigned long long)stats.load_sampler_cpu_us,
+               (unsigned long long)stats.input_boosts, (unsigned long long)stats.input_boost_suppressed,
+               (unsigned long long)stats.gpu_floor_changes, (unsigned long long)(stats.mem_stall_some_us / 1000),
+               (unsigned long long)(stats.mem_stall_full_us / 1000),
+               (unsigned long long)(stats.session_stall_some_us / 1000),
+               (unsigned long long)(stats.session_stall_full_us / 1000), (unsigned long long)stats.vm_adjustments,
+               (unsigned long long)stats.procs_frozen, (unsigned long long)stats.blk_loads,
+               (unsigned long long)stats.blk_load_read_kbps, (unsigned long long)stats.blk_load_read_lat_us,
+               (unsigned long long)stats.sessions_recorded,
+               (unsigned long long)stats.init_ms, (unsigned long long)stats.boot_to_profile_ms,
+               (unsigned long long)stats.cmd_runs, (unsigned long long)stats.cmd_timeouts,
+               (unsigned long long)stats.cmd_hangs, (unsigned long long)stats.wakeups,
+               (unsigned long long)stats.wakeups_per_min, (unsigned long long)stats.timer_fires,
+               (unsigned long long)stats.forks, (unsigned long long)stats.self_rss_kb,
+               (unsigned long long)stats.self_cpu_ms, (unsigned long long)stats.child_cpu_ms);
+}
@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#define HELPER_SENTINEL "__AZENITH_DONE__"
+#define HELPER_DEAD -2
+
+static const char* helper_path = DISPLAY_HELPER;
+static pid_t helper_pid = 0;
+static int helper_in = -1;
+static int helper_out = -1;
+
+static int cached_rate = -1;
+static int64_t cached_at = 0;
+static int saved_rate = -1;
+
+/***********************************************************************************
+ * Function Name      : display_helper_stop
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Kills and reaps the helper, next request respawns it.
+ ***********************************************************************************/
+void display_helper_stop(void) {
+    if (helper_pid > 0) {
+        kill(helper_pid, SIGKILL);
+        waitpid(helper_pid, NULL, 0);
+    }
+    if (helper_in != -1)
+        close(helper_in);
+    if (helper_out != -1)
+        close(helper_out);
+
+    helper_pid = 0;
+    helper_in = -1;
+    helper_out = -1;
+}
+
+/***********************************************************************************
+ * Function Name      : display_helper_start
+ * Inputs             : path (const char *) - helper executable, NULL for default
+ * Returns            : bool - true if the helper is running
+ * Description        : Spawns one long-lived helper. Commands go over a socket
+ *                      so a dead helper shows up as EPIPE from send() instead
+ *                      of SIGPIPE killing the daemon, output comes back over a
+ *                      pipe. Any program that runs stdin lines as shell
+ *                      commands works, a stub that records its input can be
+ *                      used for testing.
+ ***********************************************************************************/
+bool display_helper_start(const char* path) {
+    if (path)
+        helper_path = path;
+
+    display_helper_stop();
+
+    int to_helper[2];
+    int from_helper[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, to_helper) == -1)
+        return false;
+    if (pipe2(from_helper, O_CLOEXEC) == -1) {
+        close(to_helper[0]);
+        close(to_helper[1]);
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid == -1) [[clang::unlikely]] {
+        close(to_helper[0]);
+        close(to_helper[1]);
+        close(from_helper[0]);
+        close(from_helper[1]);
+        log_zenith(LOG_ERROR, "fork failed in display_helper_start()");
+        return false;
+    }
+
+    if (pid == 0) {
+        footprint_child_reset();
+        dup2(to_helper[0], STDIN_FILENO);
+        dup2(from_helper[1], STDOUT_FILENO);
+        char* env[] = {MY_PATH, NULL};
+        execle(helper_path, helper_path, NULL, env);
+        _exit(127);
+    }
+
+    stats.forks++;
+    close(to_helper[0]);
+    close(from_helper[1]);
+    helper_pid = pid;
+    helper_in = to_helper[1];
+    helper_out = from_helper[0];
+
+    log_zenith(LOG_DEBUG, "Display helper started as PID %d", pid);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : helper_round_trip
+ * Inputs             : command (const char *) - command line for the helper
+ *                      output (char *) - buffer for command output, may be NULL
+ *                      size (size_t) - output buffer size
+ * Returns            : int - command exit status, -1 on timeout, HELPER_DEAD if
+ *                      the helper had exited
+ * Description        : Sends one command and reads until the sentinel line.
+ *                      Output that does not fit the buffer is dropped, the
+ *                      reply is still read up to the sentinel.
+ ***********************************************************************************/
+static int helper_round_trip(const char* command, char* output, size_t size) {
+    char line[MAX_COMMAND_LENGTH];
+    int len = snprintf(line, sizeof(line), "{ %s; } 2>/dev/null; echo %s $?\n", command, HELPER_SENTINEL);
+    if (len >= (int)sizeof(line))
+        return -1;
+    if (send(helper_in, line, len, MSG_NOSIGNAL) != len)
+        return HELPER_DEAD;
+
+    char buf[MAX_DATA_LENGTH * 4];
+    const size_t tail = sizeof(HELPER_SENTINEL) + 16; // sentinel, status and newline
+    size_t total = 0;
+    size_t scan = 0;
+    size_t head = 0;
+    int64_t deadline = now_ms() + DISPLAY_HELPER_TIMEOUT_MS;
+
+    for (;;) {
+        // Reply outgrew buf: keep the start as output and only a tail to find the sentinel in
+        if (total == sizeof(buf) - 1) {
+            if (head == 0)
+                head = sizeof(buf) / 2;
+            memmove(buf + head, buf + total - tail, tail);
+            total = head + tail;
+            scan = head;
+        }
+
+        int64_t remaining = deadline - now_ms();
+        struct pollfd pfd = {.fd = helper_out, .events = POLLIN};
+        if (remaining <= 0 || poll(&pfd, 1, (int)remaining) <= 0)
+            return -1;
+
+        ssize_t bytes = read(helper_out, buf + total, sizeof(buf) - 1 - total);
+        if (bytes <= 0)
+            return HELPER_DEAD;
+        total += bytes;
+        buf[total] = '\0';
+
+        char* mark = strstr(buf + scan, HELPER_SENTINEL);
+        if (mark && strchr(mark, '\n')) {
+            int status = atoi(mark + strlen(HELPER_SENTINEL));
+            *mark = '\0';
+            if (head)
+                buf[head] = '\0';
+            if (output && size > 0) {
+                strncpy(output, buf, size - 1);
+                output[size - 1] = '\0';
+            }
+            return status;
+        }
+        // Only the last bytes can hold the start of a sentinel split across reads
+        if (!mark && total > scan + tail)
+            scan = total - tail;
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : display_helper_exec
+ * Inputs             : command (const char *) - command line for the helper
+ *                      output (char *) - buffer for command output, may be NULL
+ *                      size (size_t) - output buffer size
+ * Returns            : int - command exit status, -1 if the helper failed
+ * Description        : Runs one command through the resident helper. A helper
+ *                      that died since the last call is respawned and the
+ *                      command sent once more, one that stops answering within
+ *                      DISPLAY_HELPER_TIMEOUT_MS is killed.
+ ***********************************************************************************/
+static int display_helper_exec(const char* command, char* output, size_t size) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (helper_pid <= 0 && !display_helper_start(NULL))
+            return -1;
+
+        int status = helper_round_trip(command, output, size);
+        if (status >= 0)
+            return status;
+
+        display_helper_stop();
+        if (status != HELPER_DEAD) {
+            log_zenith(LOG_WARN, "Display helper stopped responding, restarting");
+            return -1;
+        }
+        log_zenith(LOG_WARN, "Display helper exited, respawning");
+    }
+    return -1;
+}
+
+/***********************************************************************************
+ * Function Name      : parse_render_rate
+ * Inputs             : dump (const char *) - output of cmd display get-displays
+ * Returns            : int - rounded renderFrameRate, -1 if not found
+ * Description        : Replaces the old grep | awk pipeline.
+ ***********************************************************************************/
+static int parse_render_rate(const char* dump) {
+    const char* p = strstr(dump, "renderFrameRate ");
+    if (!p)
+        return -1;
+
+    double rate = strtod(p + strlen("renderFrameRate "), NULL);
+    return rate > 0 ? (int)(rate + 0.5) : -1;
+}
+
+/***********************************************************************************
+ * Function Name      : display_get_refresh_rate
+ * Inputs             : None
+ * Returns            : int - current refresh rate in Hz, -1 on failure
+ * Description        : Answers from cache when fresh, otherwise asks the
+ *                      resident helper.
+ ***********************************************************************************/
+int display_get_refresh_rate(void) {
+    if (cached_rate > 0 && now_ms() - cached_at < DISPLAY_CACHE_MS)
+        return cached_rate;
+
+    char dump[MAX_DATA_LENGTH * 4] = {0};
+    int rate = -1;
+    if (display_helper_exec("cmd display get-displays", dump, sizeof(dump)) == 0)
+        rate = parse_render_rate(dump);
+
+    if (rate > 0) {
+        cached_rate = rate;
+        cached_at = now_ms();
+    }
+    return rate;
+}
+
+/***********************************************************************************
+ * Function Name      : display_set_refresh_rate
+ * Inputs             : rate (int) - refresh rate in Hz
+ * Returns            : bool - true if both peak and min rate were written
+ * Description        : Sets peak and min refresh rate in a single helper
+ *                      round trip, both or neither succeed. Talks to the
+ *                      settings service through cmd directly, the settings
+ *                      wrapper script would cost another shell per write.
+ ***********************************************************************************/
+bool display_set_refresh_rate(int rate) {
+    char command[MAX_COMMAND_LENGTH];
+    snprintf(command, sizeof(command),
+             "cmd settings put system peak_refresh_rate %d && cmd settings put system min_refresh_rate %d.0", rate,
+             rate);
+
+    if (display_helper_exec(command, NULL, 0) != 0) {
+        log_zenith(LOG_WARN, "Unable to set refresh rate to %dhz", rate);
+        return false;
+    }
+
+    cached_rate = rate;
+    cached_at = now_ms();
+    log_zenith(LOG_DEBUG, "Set current refresh rates to: %dhz", rate);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : display_save_refresh_rate
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Remembers the rate to restore once per game session.
+ ***********************************************************************************/
+void display_save_refresh_rate(void) {
+    if (saved_rate > 0)
+        return;
+
+    saved_rate = display_get_refresh_rate();
+    log_zenith(LOG_INFO, "Saved refresh rate: %d", saved_rate);
+}
+
+/***********************************************************************************
+ * Function Name      : display_restore_refresh_rate
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Restores the saved rate. The saved value is only dropped
+ *                      once the restore went through, so a failed attempt is
+ *                      retried on the next profile switch.
+ ***********************************************************************************/
+void display_restore_refresh_rate(void) {
+    if (saved_rate <= 0)
+        return;
+
+    if (display_set_refresh_rate(saved_rate))
+        saved_rate = -1;
+}
+
+/***********************************************************************************
+ * Function Name      : display_set_renderer
+ * Inputs             : renderer (const char *) - "skiavk" or "skiagl"
+ * Returns            : None
+ * Description        : Sets debug.hwui.renderer directly, skipping the write when
+ *                      it already holds the requested value.
+ ***********************************************************************************/
+void display_set_renderer(const char* renderer) {
+    char current[PROP_VALUE_MAX] = {0};
+    __system_property_get("debug.hwui.renderer", current);
+    if (strcmp(current, renderer) == 0)
+        return;
+
+    if (__system_property_set("debug.hwui.renderer", renderer) != 0) {
+        log_zenith(LOG_WARN, "Unable to set renderer to %s", renderer);
+        return;
+    }
+    log_zenith(LOG_DEBUG, "Set current renderer to: %s", renderer);
+}
@@ -27,7 +27,7 @@ char* get_visible_package(void) {
     if (!get_screenstate())
         return NULL;
 
-    FILE* fp = popen("dumpsys window displays", "r");
+    FILE* fp = popen_deadline(CMD_TIMEOUT_MS, "dumpsys window displays");
     if (!fp) {
         log_zenith(LOG_INFO, "Failed to run dumpsys window displays");
         return NULL;
@@ -69,6 +69,6 @@ char* get_visible_package(void) {
         }
     }
 
-    pclose(fp);
+    fclose(fp);
     return pkg[0] ? strdup(pkg) : NULL;
 }
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <errno.h>
+#include <poll.h>
+
+typedef struct {
+    int fd;
+    EventHandler handler;
+} EventSource;
+
+static EventSource sources[MAX_EVENT_SOURCES];
+static int nr_sources = 0;
+
+/***********************************************************************************
+ * Function Name      : now_ms
+ * Inputs             : None
+ * Returns            : int64_t - CLOCK_MONOTONIC time in milliseconds
+ * Description        : Monotonic clock helper for deadlines.
+ ***********************************************************************************/
+int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/***********************************************************************************
+ * Function Name      : event_loop_add
+ * Inputs             : fd (int) - readable file descriptor to watch
+ *                      handler (EventHandler) - called when fd becomes readable
+ * Returns            : int - 0 on success, -1 if the table is full
+ * Description        : Registers an fd to be serviced while the daemon waits.
+ ***********************************************************************************/
+int event_loop_add(int fd, EventHandler handler) {
+    if (fd < 0 || nr_sources >= MAX_EVENT_SOURCES)
+        return -1;
+
+    sources[nr_sources].fd = fd;
+    sources[nr_sources].handler = handler;
+    nr_sources++;
+    return 0;
+}
+
+/***********************************************************************************
+ * Function Name      : event_loop_remove
+ * Inputs             : fd (int) - previously registered fd
+ * Returns            : None
+ * Description        : Stops watching an fd. Does not close it.
+ ***********************************************************************************/
+void event_loop_remove(int fd) {
+    for (int i = 0; i < nr_sources; i++) {
+        if (sources[i].fd == fd) {
+            sources[i] = sources[--nr_sources];
+            return;
+        }
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : event_loop_once
+ * Inputs             : timeout_ms (int) - how long to wait, -1 for no limit
+ * Returns            : None
+ * Description        : Sleeps until a registered fd is readable or the timeout
+ *                      passes, then dispatches whatever is ready. The daemon
+ *                      loop calls this with no limit, timers arrive as a
+ *                      timerfd like every other event.
+ ***********************************************************************************/
+void event_loop_once(int timeout_ms) {
+    struct pollfd pfds[MAX_EVENT_SOURCES];
+    EventSource snapshot[MAX_EVENT_SOURCES];
+
+    int count = nr_sources;
+    memcpy(snapshot, sources, sizeof(EventSource) * count);
+    for (int i = 0; i < count; i++) {
+        pfds[i].fd = sources[i].fd;
+        pfds[i].events = POLLIN;
+        pfds[i].revents = 0;
+    }
+
+    int ready = poll(pfds, count, timeout_ms);
+    stats.wakeups++;
+    if (ready < 0 && errno != EINTR) [[clang::unlikely]] {
+        log_zenith(LOG_ERROR, "poll failed in event_loop_once()");
+        usleep((timeout_ms < 0 ? 1000 : timeout_ms) * 1000);
+        return;
+    }
+
+    // Handlers may unregister themselves, walk the snapshot
+    for (int i = 0; i < count && ready > 0; i++) {
+        if (pfds[i].revents & (POLLIN | POLLERR | POLLHUP))
+            snapshot[i].handler(pfds[i].fd);
+    }
+}
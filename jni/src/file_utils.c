@@ -82,7 +82,7 @@ int write2file(const char* filename, const bool append, const bool use_flock, co
 int check_running_state(void) {
     char state[64] = {0};
 
-    FILE* fp = popen("getprop persist.sys.azenith.state", "r");
+    FILE* fp = popen_deadline(CMD_TIMEOUT_MS, "getprop persist.sys.azenith.state");
     if (!fp) {
         perror("popen");
         return -1;
@@ -94,11 +94,11 @@ int check_running_state(void) {
             state[len - 1] = '\0';
 
         if (strcmp(state, "running") == 0) {
-            pclose(fp);
+            fclose(fp);
             return 1;
         }
     }
-    pclose(fp);
+    fclose(fp);
     return 0;
 }
 
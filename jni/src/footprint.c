@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static char group_dir[MAX_PATH_LENGTH * 2] = "";
+static struct rlimit saved_data;
+static bool data_limited = false;
+
+static bool read_line(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    bool ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        trim_newline(buf);
+    return ok;
+}
+
+static bool write_str(const char* path, const char* value) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    bool ok = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+    return ok;
+}
+
+/***********************************************************************************
+ * Function Name      : join_cpuset
+ * Inputs             : pid (pid_t) - process to move
+ *                      cpus (const char *) - cpu list of the group
+ * Returns            : bool - true if pid is in FOOTPRINT_GROUP
+ * Description        : Creates FOOTPRINT_GROUP under the v1 cpuset mount Android
+ *                      uses, or the v2 unified hierarchy with the cpuset
+ *                      controller delegated to it. cpus and mems have to be
+ *                      set before a v1 group accepts tasks, mems is inherited
+ *                      from the root group.
+ ***********************************************************************************/
+static bool join_cpuset(pid_t pid, const char* cpus) {
+    char path[MAX_PATH_LENGTH * 3];
+    char mems[MAX_LINE] = {0};
+    char base[MAX_PATH_LENGTH + 32];
+    const char* cpus_file;
+    const char* mems_file;
+
+    snprintf(base, sizeof(base), "%s/dev/cpuset", root_dir);
+    snprintf(path, sizeof(path), "%s/cpus", base);
+    if (access(path, F_OK) == 0) {
+        // Android mounts cpuset with noprefix
+        cpus_file = "cpus";
+        mems_file = "mems";
+    } else {
+        snprintf(path, sizeof(path), "%s/cpuset.cpus", base);
+        if (access(path, F_OK) != 0) {
+            char controllers[MAX_LINE] = {0};
+            snprintf(base, sizeof(base), "%s/sys/fs/cgroup", root_dir);
+            snprintf(path, sizeof(path), "%s/cgroup.controllers", base);
+            if (!read_line(path, controllers, sizeof(controllers)) || !strstr(controllers, "cpuset"))
+                return false;
+            snprintf(path, sizeof(path), "%s/cgroup.subtree_control", base);
+            write_str(path, "+cpuset");
+        }
+        cpus_file = "cpuset.cpus";
+        mems_file = "cpuset.mems";
+    }
+
+    snprintf(group_dir, sizeof(group_dir), "%s/%s", base, FOOTPRINT_GROUP);
+    if (mkdir(group_dir, 0755) == -1 && access(group_dir, F_OK) != 0) {
+        log_zenith(LOG_WARN, "Footprint: unable to create %s", group_dir);
+        group_dir[0] = '\0';
+        return false;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", group_dir, cpus_file);
+    if (!write_str(path, cpus)) {
+        log_zenith(LOG_WARN, "Footprint: unable to write %s to %s", cpus, path);
+        return false;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", base, mems_file);
+    if (read_line(path, mems, sizeof(mems)) && mems[0]) {
+        snprintf(path, sizeof(path), "%s/%s", group_dir, mems_file);
+        write_str(path, mems);
+    }
+
+    // cgroup.procs moves every thread of the process on both versions
+    char value[16];
+    snprintf(value, sizeof(value), "%d", pid);
+    snprintf(path, sizeof(path), "%s/cgroup.procs", group_dir);
+    return write_str(path, value);
+}
+
+/***********************************************************************************
+ * Function Name      : footprint_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : bool - true if the daemon now runs on the little cluster
+ * Description        : Keeps the daemon out of the way of the game. The process
+ *                      and everything it forks moves to a cpuset holding only
+ *                      the first cluster, and its private writable memory is
+ *                      capped at FOOTPRINT_DATA_MB through RLIMIT_DATA. The
+ *                      memory cap is a soft limit on the daemon alone, children
+ *                      drop it before exec. A memcg limit would also charge the
+ *                      page cache of game preloading to the daemon. The root
+ *                      prefix lets a mocked cgroupfs stand in.
+ ***********************************************************************************/
+bool footprint_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+
+    if (getrlimit(RLIMIT_DATA, &saved_data) == 0) {
+        struct rlimit lim = saved_data;
+        rlim_t cap = (rlim_t)FOOTPRINT_DATA_MB << 20;
+        if (lim.rlim_max == RLIM_INFINITY || lim.rlim_max > cap)
+            lim.rlim_cur = cap;
+        data_limited = setrlimit(RLIMIT_DATA, &lim) == 0;
+    }
+
+    uint64_t little = nr_clusters > 1 ? clusters[0].cpu_mask & cpuset_online_mask() : 0;
+    char cpus[MAX_LINE] = {0};
+    bool placed = little && join_cpuset(getpid(), cpu_mask_to_list(little, cpus, sizeof(cpus)));
+
+    log_zenith(LOG_INFO, "Footprint: cpus %s, data limit %s", placed ? cpus : "unrestricted",
+               data_limited ? "set" : "unset");
+    return placed;
+}
+
+/***********************************************************************************
+ * Function Name      : footprint_child_reset
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Called in a forked child before exec. Puts back the data
+ *                      limit the daemon was started with, the cap is meant for
+ *                      the daemon and not for the tools it runs.
+ ***********************************************************************************/
+void footprint_child_reset(void) {
+    if (data_limited)
+        setrlimit(RLIMIT_DATA, &saved_data);
+}
+
+/***********************************************************************************
+ * Function Name      : footprint_idle_child
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Called in a forked child before exec. Maintenance only
+ *                      gets CPU and disk time nobody else wants, SCHED_IDLE and
+ *                      the idle I/O class are inherited by everything it starts.
+ ***********************************************************************************/
+void footprint_idle_child(void) {
+    struct sched_param param = {0};
+    sched_setscheduler(0, SCHED_IDLE, &param);
+    syscall(SYS_ioprio_set, 1, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+}
+
+/***********************************************************************************
+ * Function Name      : footprint_sample
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Refreshes the daemon's own resident memory and the CPU
+ *                      time of the daemon and of the children it reaped.
+ ***********************************************************************************/
+void footprint_sample(void) {
+    char path[MAX_PATH_LENGTH + 32];
+    char line[MAX_LINE] = {0};
+    snprintf(path, sizeof(path), "%s/proc/self/statm", root_dir);
+
+    long size_pages;
+    long rss_pages;
+    if (read_line(path, line, sizeof(line)) && sscanf(line, "%ld %ld", &size_pages, &rss_pages) == 2)
+        stats.self_rss_kb = (uint64_t)rss_pages * (uint64_t)sysconf(_SC_PAGESIZE) / 1024;
+
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        stats.self_cpu_ms = (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000 +
+                            (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000;
+    if (getrusage(RUSAGE_CHILDREN, &ru) == 0)
+        stats.child_cpu_ms = (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000 +
+                             (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000;
+}
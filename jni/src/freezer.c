@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+typedef struct {
+    pid_t pid; // v1 process in the AZenith group
+    int uid;   // v2 app whose uid group is frozen
+    char path[MAX_PATH_LENGTH + 48]; // v2 cgroup.freeze of the uid group
+} FrozenProc;
+
+// Messaging and music keep running unless the user says otherwise
+static const char* const default_whitelist[] = {
+    "com.whatsapp",          "org.telegram.messenger", "com.google.android.apps.messaging",
+    "com.discord",           "com.facebook.orca",      "com.spotify.music",
+    "com.google.android.apps.youtube.music", "com.android.systemui", "com.android.phone",
+};
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static char v1_dir[MAX_PATH_LENGTH + 16] = "";
+static bool is_v2 = false;
+static bool available = false;
+static FrozenProc frozen[MAX_FROZEN];
+static int nr_frozen = 0;
+static int64_t screen_off_since = 0;
+static int64_t last_scan = 0;
+
+static bool read_line(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    bool ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        trim_newline(buf);
+    return ok;
+}
+
+static bool write_str(const char* path, const char* value) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    bool ok = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+    return ok;
+}
+
+/***********************************************************************************
+ * Function Name      : freezer_whitelisted
+ * Inputs             : process (const char *) - process name from cmdline
+ * Returns            : bool - true if the package must not be frozen
+ * Description        : Matches the package part of a process name, so
+ *                      "com.whatsapp:push" is covered by "com.whatsapp", against
+ *                      the built-in list and persist.sys.azenithconf.freezewhitelist
+ *                      (comma separated).
+ ***********************************************************************************/
+bool freezer_whitelisted(const char* process) {
+    size_t len = strcspn(process, ":");
+    for (size_t i = 0; i < sizeof(default_whitelist) / sizeof(default_whitelist[0]); i++) {
+        if (strlen(default_whitelist[i]) == len && strncmp(process, default_whitelist[i], len) == 0)
+            return true;
+    }
+
+    char list[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.freezewhitelist", list);
+    for (char* pkg = strtok(list, ", "); pkg; pkg = strtok(NULL, ", ")) {
+        if (strlen(pkg) == len && strncmp(process, pkg, len) == 0)
+            return true;
+    }
+    return false;
+}
+
+/***********************************************************************************
+ * Function Name      : freezer_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : bool - true if a freezer is available
+ * Description        : Prefers the v2 uid_N/pid_N hierarchy Android uses for its
+ *                      own app freezer, and falls back to an AZenith group in a
+ *                      v1 freezer mount. The root prefix lets a mock cgroupfs
+ *                      and procfs stand in.
+ ***********************************************************************************/
+bool freezer_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+
+    // cgroup.freeze is core to v2, the uid_* groups only exist with per-app cgroups
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/sys/fs/cgroup/uid_1000", root_dir);
+    if (access(path, F_OK) == 0) {
+        is_v2 = true;
+        available = true;
+        log_zenith(LOG_INFO, "Freezer: using v2 per-app cgroups");
+        return true;
+    }
+
+    const char* v1_mounts[] = {"/dev/freezer", "/sys/fs/cgroup/freezer"};
+    for (size_t i = 0; i < sizeof(v1_mounts) / sizeof(v1_mounts[0]); i++) {
+        char dir[MAX_PATH_LENGTH * 2];
+        snprintf(dir, sizeof(dir), "%s%s", root_dir, v1_mounts[i]);
+        if (access(dir, F_OK) != 0)
+            continue;
+
+        snprintf(v1_dir, sizeof(v1_dir), "%s/%s", dir, FREEZER_GROUP);
+        if (mkdir(v1_dir, 0755) == -1 && access(v1_dir, F_OK) != 0)
+            continue;
+
+        is_v2 = false;
+        available = true;
+        log_zenith(LOG_INFO, "Freezer: using v1 freezer at %s", dir);
+        return true;
+    }
+
+    log_zenith(LOG_INFO, "Freezer: no freezer cgroup found");
+    return false;
+}
+
+/***********************************************************************************
+ * Function Name      : freeze_candidate
+ * Inputs             : pid (pid_t) - process to check
+ *                      keep_uid (int) - uid never frozen, the game's
+ *                      uid (int *) - filled with the process uid
+ * Returns            : bool - true if the process is a cached/background app
+ * Description        : Apps only, identified by uid, that the framework already
+ *                      ranks as unimportant as FREEZER_MIN_ADJ or less and that
+ *                      are not on the whitelist.
+ ***********************************************************************************/
+static bool freeze_candidate(pid_t pid, int keep_uid, int* uid) {
+    char path[MAX_PATH_LENGTH * 2];
+    char buf[MAX_LINE] = {0};
+
+    snprintf(path, sizeof(path), "%s/proc/%d/oom_score_adj", root_dir, pid);
+    if (!read_line(path, buf, sizeof(buf)) || atoi(buf) < FREEZER_MIN_ADJ)
+        return false;
+
+    *uid = -1;
+    snprintf(path, sizeof(path), "%s/proc/%d/status", root_dir, pid);
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+    while (fgets(buf, sizeof(buf), fp)) {
+        if (strncmp(buf, "Uid:", 4) == 0) {
+            *uid = atoi(buf + 4);
+            break;
+        }
+    }
+    fclose(fp);
+
+    // Regular app uids of any user, 10000-19999 per user
+    int app_id = *uid % 100000;
+    if (*uid == keep_uid || app_id < 10000 || app_id > 19999)
+        return false;
+
+    snprintf(path, sizeof(path), "%s/proc/%d/cmdline", root_dir, pid);
+    if (!read_line(path, buf, sizeof(buf)) || !buf[0])
+        return false;
+    return !freezer_whitelisted(buf);
+}
+
+static bool already_frozen(pid_t pid, int uid) {
+    for (int i = 0; i < nr_frozen; i++) {
+        if (is_v2 ? frozen[i].uid == uid : frozen[i].pid == pid)
+            return true;
+    }
+    return false;
+}
+
+/***********************************************************************************
+ * Function Name      : uid_candidates
+ * Inputs             : uid (int) - app uid
+ *                      keep_uid (int) - uid never frozen, the game's
+ * Returns            : int - processes in uid_N, 0 unless all are candidates
+ * Description        : A uid group is only frozen when every process in it
+ *                      would be frozen on its own.
+ ***********************************************************************************/
+static int uid_candidates(int uid, int keep_uid) {
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/sys/fs/cgroup/uid_%d", root_dir, uid);
+    DIR* dir = opendir(path);
+    if (!dir)
+        return 0;
+
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "pid_", 4) != 0)
+            continue;
+
+        int other;
+        if (!freeze_candidate(atoi(entry->d_name + 4), keep_uid, &other) || other != uid) {
+            count = 0;
+            break;
+        }
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+/***********************************************************************************
+ * Function Name      : freezer_freeze
+ * Inputs             : keep_pid (pid_t) - process never frozen, 0 for none
+ * Returns            : int - number of processes newly frozen
+ * Description        : Scans /proc for candidates and freezes them. On v2 the
+ *                      app's uid_N group is frozen, freezing is hierarchical so
+ *                      that holds every process of the app while the pid_N
+ *                      cgroup.freeze the framework's own freezer writes stays
+ *                      untouched. Thawing the uid group later leaves whatever
+ *                      the framework froze in the meantime frozen.
+ ***********************************************************************************/
+int freezer_freeze(pid_t keep_pid) {
+    if (!available)
+        return 0;
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/proc", root_dir);
+    DIR* dir = opendir(path);
+    if (!dir)
+        return 0;
+
+    int keep_uid = -2;
+    if (keep_pid > 0) {
+        char status[MAX_PATH_LENGTH * 2];
+        char line[MAX_LINE];
+        snprintf(status, sizeof(status), "%s/proc/%d/status", root_dir, keep_pid);
+        FILE* fp = fopen(status, "r");
+        while (fp && fgets(line, sizeof(line), fp)) {
+            if (strncmp(line, "Uid:", 4) == 0) {
+                keep_uid = atoi(line + 4);
+                break;
+            }
+        }
+        if (fp)
+            fclose(fp);
+    }
+
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && nr_frozen < MAX_FROZEN) {
+        if (!isdigit((unsigned char)entry->d_name[0]))
+            continue;
+
+        pid_t pid = atoi(entry->d_name);
+        int uid;
+        if (pid == keep_pid || !freeze_candidate(pid, keep_uid, &uid) || already_frozen(pid, uid))
+            continue;
+
+        FrozenProc* f = &frozen[nr_frozen];
+        f->pid = pid;
+        f->uid = uid;
+        int procs_frozen = 1;
+        if (is_v2) {
+            char state[8] = {0};
+            snprintf(f->path, sizeof(f->path), "%s/sys/fs/cgroup/uid_%d/cgroup.freeze", root_dir, uid);
+            procs_frozen = uid_candidates(uid, keep_uid);
+            if (!procs_frozen || !read_line(f->path, state, sizeof(state)) || strcmp(state, "1") == 0)
+                continue;
+            if (!write_str(f->path, "1"))
+                continue;
+        } else {
+            char procs[MAX_PATH_LENGTH * 2];
+            snprintf(procs, sizeof(procs), "%s/cgroup.procs", v1_dir);
+            if (!write_str(procs, entry->d_name))
+                continue;
+        }
+
+        nr_frozen++;
+        count += procs_frozen;
+    }
+    closedir(dir);
+
+    if (!is_v2 && nr_frozen > 0) {
+        snprintf(path, sizeof(path), "%s/freezer.state", v1_dir);
+        write_str(path, "FROZEN");
+    }
+
+    stats.procs_frozen += count;
+    if (count)
+        log_zenith(LOG_DEBUG, "Freezer: froze %d processes, %d total", count, nr_frozen);
+    return count;
+}
+
+/***********************************************************************************
+ * Function Name      : freezer_thaw_all
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Thaws everything AZenith froze. v2 uid groups are
+ *                      unfrozen, v1 tasks move back to the root freezer group.
+ ***********************************************************************************/
+void freezer_thaw_all(void) {
+    if (nr_frozen == 0)
+        return;
+
+    if (is_v2) {
+        for (int i = 0; i < nr_frozen; i++)
+            write_str(frozen[i].path, "0");
+    } else {
+        char path[MAX_PATH_LENGTH * 2];
+        char parent[MAX_PATH_LENGTH * 2];
+        snprintf(path, sizeof(path), "%s/freezer.state", v1_dir);
+        write_str(path, "THAWED");
+
+        // Parent of the AZenith group is the freezer root
+        snprintf(parent, sizeof(parent), "%s", v1_dir);
+        char* slash = strrchr(parent, '/');
+        if (slash)
+            strcpy(slash, "/cgroup.procs");
+
+        for (int i = 0; i < nr_frozen; i++) {
+            char pid[16];
+            snprintf(pid, sizeof(pid), "%d", frozen[i].pid);
+            write_str(parent, pid);
+        }
+    }
+
+    nr_frozen = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : freezer_tick
+ * Inputs             : gaming (bool) - a game is boosted
+ *                      screen_on (bool) - current screen state
+ *                      keep_pid (pid_t) - game process, 0 if none
+ * Returns            : None
+ * Description        : Freezes while a game is boosted or after the screen has
+ *                      been off for FREEZER_SCREEN_OFF_MS, rescanning every
+ *                      FREEZER_RESCAN_MS for apps that became cached since.
+ *                      Thaws as soon as neither holds.
+ ***********************************************************************************/
+void freezer_tick(bool gaming, bool screen_on, pid_t keep_pid) {
+    if (!available)
+        return;
+
+    int64_t now = now_ms();
+    if (screen_on)
+        screen_off_since = 0;
+    else if (screen_off_since == 0)
+        screen_off_since = now;
+
+    bool want = gaming || (screen_off_since != 0 && now - screen_off_since >= FREEZER_SCREEN_OFF_MS);
+    if (!want) {
+        if (nr_frozen > 0)
+            log_zenith(LOG_DEBUG, "Freezer: thawing %d %s", nr_frozen, is_v2 ? "apps" : "processes");
+        freezer_thaw_all();
+        last_scan = 0;
+        return;
+    }
+
+    if (last_scan != 0 && now - last_scan < FREEZER_RESCAN_MS)
+        return;
+    last_scan = now;
+    freezer_freeze(gaming ? keep_pid : 0);
+}
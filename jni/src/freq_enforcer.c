@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+typedef struct {
+    int max_fd;
+    int min_fd;
+    int target_max;
+    int target_min;
+    int stuck_max; // value the kernel keeps reporting over our target
+} FreqLimit;
+
+static FreqLimit limits[MAX_CLUSTERS];
+static bool enforcer_ready = false;
+static char last_offset[PROP_VALUE_MAX] = {0};
+static ProfileMode last_mode = PERFCOMMON;
+
+/***********************************************************************************
+ * Function Name      : freq_offset_percent
+ * Inputs             : offset (const char *) - freqoffset property value
+ * Returns            : int - limiter in percent
+ * Description        : Same parsing as get_freq_limiter() in profilesettings.
+ ***********************************************************************************/
+static int freq_offset_percent(const char* offset) {
+    if (!offset[0] || strstr(offset, "Disabled"))
+        return 100;
+
+    int pct = atoi(offset);
+    return pct > 0 ? pct : 100;
+}
+
+static int pread_int(int fd) {
+    char buf[24] = {0};
+    if (fd == -1 || pread(fd, buf, sizeof(buf) - 1, 0) <= 0)
+        return -1;
+    return atoi(buf);
+}
+
+static void pwrite_int(int fd, int value) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%d", value);
+    pwrite(fd, buf, len, 0);
+}
+
+/***********************************************************************************
+ * Function Name      : freq_enforcer_init
+ * Inputs             : None
+ * Returns            : bool - true if cpufreq limits can be enforced
+ * Description        : Opens persistent fds for every cluster's frequency limits.
+ ***********************************************************************************/
+bool freq_enforcer_init(void) {
+    for (int i = 0; i < nr_clusters; i++) {
+        char path[MAX_PATH_LENGTH];
+        snprintf(path, sizeof(path), "%s/policy%d/scaling_max_freq", CPUFREQ_PATH, clusters[i].policy);
+        limits[i].max_fd = open(path, O_RDWR | O_CLOEXEC);
+        snprintf(path, sizeof(path), "%s/policy%d/scaling_min_freq", CPUFREQ_PATH, clusters[i].policy);
+        limits[i].min_fd = open(path, O_RDWR | O_CLOEXEC);
+        limits[i].stuck_max = -1;
+    }
+
+    enforcer_ready = nr_clusters > 0;
+    return enforcer_ready;
+}
+
+/***********************************************************************************
+ * Function Name      : freq_compute_targets
+ * Inputs             : pct (int) - freqoffset limiter
+ *                      mode (ProfileMode) - active profile
+ * Returns            : None
+ * Description        : Mirrors dsetfreq(): max is scaled by the offset, min is
+ *                      40% of max on eco and the hardware min otherwise.
+ ***********************************************************************************/
+static void freq_compute_targets(int pct, ProfileMode mode) {
+    for (int i = 0; i < nr_clusters; i++) {
+        const CpuCluster* c = &clusters[i];
+        limits[i].target_max = cluster_nearest_freq(c, (int)((long)c->cpuinfo_max * pct / 100));
+        limits[i].target_min = mode == ECO_MODE ? cluster_nearest_freq(c, (int)((long)c->cpuinfo_max * 40 / 100)) : c->cpuinfo_min;
+        limits[i].stuck_max = -1;
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : freq_enforce
+ * Inputs             : external (bool) - mismatches were caused by another agent
+ * Returns            : None
+ * Description        : Writes only the limits that differ from their targets.
+ *                      When the kernel keeps reporting a lower max right after
+ *                      our write (thermal or vendor QoS caps win), the value is
+ *                      remembered and not fought until it changes again.
+ ***********************************************************************************/
+static void freq_enforce(bool external) {
+    bool use_ppm = access(PPM_MAX_FREQ, F_OK) == 0;
+
+    for (int i = 0; i < nr_clusters; i++) {
+        FreqLimit* l = &limits[i];
+        int cur_max = pread_int(l->max_fd);
+        int cur_min = pread_int(l->min_fd);
+        bool max_off = cur_max != -1 && cur_max != l->target_max && cur_max != l->stuck_max;
+        bool min_off = cur_min != -1 && cur_min != l->target_min;
+
+        if (!max_off && !min_off)
+            continue;
+
+        if (use_ppm) {
+            write2file(PPM_MAX_FREQ, false, false, "%d %d", i, l->target_max);
+            write2file(PPM_MIN_FREQ, false, false, "%d %d", i, l->target_min);
+        } else {
+            // Same order as dsetfreq(), max first
+            pwrite_int(l->max_fd, l->target_max);
+            pwrite_int(l->min_fd, l->target_min);
+        }
+
+        stats.freq_enforce_writes++;
+        if (external) {
+            stats.freq_enforce_conflicts++;
+            log_zenith(LOG_DEBUG, "policy%d limits overwritten externally (%d-%d), restoring %d-%d", clusters[i].policy,
+                       cur_min, cur_max, l->target_min, l->target_max);
+        }
+
+        int after = pread_int(l->max_fd);
+        l->stuck_max = (after != -1 && after != l->target_max) ? after : -1;
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : freq_enforcer_tick
+ * Inputs             : mode (ProfileMode) - active profile
+ * Returns            : None
+ * Description        : Resident replacement for the per-tick applyfreqbalance
+ *                      exec. Targets are recomputed only when freqoffset or the
+ *                      profile changes; otherwise the current limits are read
+ *                      back and rewritten only if another agent changed them.
+ ***********************************************************************************/
+void freq_enforcer_tick(ProfileMode mode) {
+    if (!enforcer_ready)
+        return;
+
+    char offset[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.freqoffset", offset);
+
+    if (strstr(offset, "Disabled") != NULL) {
+        strcpy(last_offset, offset);
+        return;
+    }
+
+    if (strcmp(offset, last_offset) != 0 || mode != last_mode) {
+        strcpy(last_offset, offset);
+        last_mode = mode;
+        freq_compute_targets(freq_offset_percent(offset), mode);
+        freq_enforce(false);
+        return;
+    }
+
+    freq_enforce(true);
+}
@@ -35,14 +35,14 @@ void GamePreload(const char* package) {
     char cmd_apk[512];
     snprintf(cmd_apk, sizeof(cmd_apk), "cmd package path %s | head -n1 | cut -d: -f2", package);
 
-    FILE* apk = popen(cmd_apk, "r");
+    FILE* apk = popen_deadline(CMD_TIMEOUT_MS, "%s", cmd_apk);
     if (!apk || !fgets(apk_path, sizeof(apk_path), apk)) {
         log_zenith(LOG_WARN, "Failed to get APK path for %s", package);
         if (apk)
-            pclose(apk);
+            fclose(apk);
         return;
     }
-    pclose(apk);
+    fclose(apk);
     apk_path[strcspn(apk_path, "\n")] = 0;
 
     char* last_slash = strrchr(apk_path, '/');
@@ -84,7 +84,7 @@ void GamePreload(const char* package) {
         char preload_cmd[512];
         snprintf(preload_cmd, sizeof(preload_cmd), "sys.azenith-preloadbin -v -t -m %s \"%s\"", budget, lib_path);
 
-        fp = popen(preload_cmd, "r");
+        fp = popen_deadline(CMD_LONG_TIMEOUT_MS, "%s", preload_cmd);
         if (!fp) {
             log_zenith(LOG_WARN, "Failed to run preloadbin for %s", package);
             return;
@@ -98,7 +98,7 @@ void GamePreload(const char* package) {
         char preload_cmd[512];
         snprintf(preload_cmd, sizeof(preload_cmd), "sys.azenith-preloadbin -v -t -m %s \"%s\"", budget, apk_path);
 
-        fp = popen(preload_cmd, "r");
+        fp = popen_deadline(CMD_LONG_TIMEOUT_MS, "%s", preload_cmd);
         if (!fp) {
             log_zenith(LOG_WARN, "Failed to run preloadbin for %s", package);
             return;
@@ -134,5 +134,11 @@ void GamePreload(const char* package) {
 
     log_preload(LOG_INFO, "Game %s preloaded success: total %d pages touched (~%s)", package, total_pages, total_size);
 
-    pclose(fp);
+    fclose(fp);
+
+    // Keep what was just warmed resident for the rest of the session
+    char guard[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.preloadguard", guard);
+    if (strcmp(guard, "1") == 0)
+        residency_guard_start(lib_exists ? lib_path : apk_path);
 }
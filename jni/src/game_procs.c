@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <fnmatch.h>
+
+// Gamelists written before game_process existed still expect these
+static const struct {
+    const char* package;
+    const char* process;
+} default_procs[] = {
+    {"com.mobile.legends", ":UnityKillsMe"},
+    {"com.mobilelegends.hwag", ":UnityKillsMe"},
+    {"com.mobiin.gp", ":UnityKillsMe"},
+    {"com.mobilechess.gp", ":UnityKillsMe"},
+};
+
+GameProcs game_procs;
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static char main_pattern[MAX_PACKAGE];
+static char helper_patterns[MAX_HELPER_PATTERNS];
+static int64_t last_scan = 0;
+
+static bool is_set(const char* value) {
+    return value && value[0] && !IS_DEFAULT(value);
+}
+
+static bool read_name(const char* pid, char* name, size_t size) {
+    char path[MAX_PATH_LENGTH + 32];
+    snprintf(path, sizeof(path), "%s/proc/%s/cmdline", root_dir, pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    // argv[0] of an app process is its process name, NUL terminated
+    ssize_t len = read(fd, name, size - 1);
+    close(fd);
+    if (len <= 0)
+        return false;
+    name[len] = '\0';
+    return true;
+}
+
+static bool match_helper(const char* pkg, const char* name) {
+    char list[MAX_HELPER_PATTERNS];
+    snprintf(list, sizeof(list), "%s", helper_patterns);
+
+    char* save = NULL;
+    for (char* pattern = strtok_r(list, ",", &save); pattern; pattern = strtok_r(NULL, ",", &save)) {
+        while (*pattern == ' ')
+            pattern++;
+        char* end = pattern + strlen(pattern);
+        while (end > pattern && end[-1] == ' ')
+            *--end = '\0';
+
+        if (pattern[0] && game_proc_match(pkg, pattern, name))
+            return true;
+    }
+    return false;
+}
+
+/***********************************************************************************
+ * Function Name      : scan_procs
+ * Inputs             : pkg (const char *) - game package
+ *                      helpers (pid_t *) - receives helper PIDs
+ *                      nr_helpers (int *) - receives the helper count
+ * Returns            : pid_t - PID of the main game process, 0 if not running
+ * Description        : One pass over /proc matching every process name against
+ *                      the main and helper patterns of the tracked game.
+ ***********************************************************************************/
+static pid_t scan_procs(const char* pkg, pid_t* helpers, int* nr_helpers) {
+    char path[MAX_PATH_LENGTH + 8];
+    snprintf(path, sizeof(path), "%s/proc", root_dir);
+    DIR* dir = opendir(path);
+    *nr_helpers = 0;
+    if (!dir)
+        return 0;
+
+    pid_t main = 0;
+    char name[MAX_PACKAGE];
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)entry->d_name[0]) || !read_name(entry->d_name, name, sizeof(name)))
+            continue;
+
+        if (main == 0 && game_proc_match(pkg, main_pattern, name)) {
+            main = (pid_t)atoi(entry->d_name);
+        } else if (helper_patterns[0] && *nr_helpers < MAX_GAME_HELPERS && match_helper(pkg, name)) {
+            helpers[(*nr_helpers)++] = (pid_t)atoi(entry->d_name);
+        }
+    }
+    closedir(dir);
+    return main;
+}
+
+/***********************************************************************************
+ * Function Name      : game_procs_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : None
+ * Description        : Sets where /proc is read from.
+ ***********************************************************************************/
+void game_procs_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+    memset(&game_procs, 0, sizeof(game_procs));
+}
+
+/***********************************************************************************
+ * Function Name      : game_proc_pattern
+ * Inputs             : pkg (const char *) - game package
+ *                      opts (const GameOptions *) - its gamelist entry, may be NULL
+ * Returns            : const char* - pattern of the main game process, NULL if
+ *                      the package itself is the game process
+ * Description        : game_process from the gamelist, or the built-in entry
+ *                      for packages that always render in a subprocess.
+ ***********************************************************************************/
+const char* game_proc_pattern(const char* pkg, const GameOptions* opts) {
+    if (opts && is_set(opts->game_process))
+        return opts->game_process;
+
+    for (size_t i = 0; i < sizeof(default_procs) / sizeof(default_procs[0]); i++) {
+        if (strcmp(pkg, default_procs[i].package) == 0)
+            return default_procs[i].process;
+    }
+    return NULL;
+}
+
+/***********************************************************************************
+ * Function Name      : game_proc_match
+ * Inputs             : pkg (const char *) - game package
+ *                      pattern (const char *) - process name pattern
+ *                      name (const char *) - process name to test
+ * Returns            : bool - true if name matches
+ * Description        : fnmatch() of the whole process name. A pattern starting
+ *                      with ':' is relative to the package, so ":UnityKillsMe"
+ *                      matches "<pkg>:UnityKillsMe" and ":*" every subprocess.
+ ***********************************************************************************/
+bool game_proc_match(const char* pkg, const char* pattern, const char* name) {
+    if (pattern[0] == ':') {
+        size_t len = strlen(pkg);
+        if (strncmp(name, pkg, len) != 0)
+            return false;
+        name += len;
+    }
+    return fnmatch(pattern, name, 0) == 0;
+}
+
+/***********************************************************************************
+ * Function Name      : game_procs_track
+ * Inputs             : pkg (const char *) - foreground game package
+ *                      opts (const GameOptions *) - its gamelist entry
+ * Returns            : GameProcState - GAME_RUNNING when the main process was
+ *                      found, GAME_RUN_BG when a declared game_process is not
+ *                      running, GAME_NOT_TRACKED when the entry declares no
+ *                      processes or only helpers whose main process is gone
+ * Description        : Finds the main and helper processes of a gamelist entry
+ *                      in /proc and keeps them in game_procs. A cached main
+ *                      process that is still alive skips the scan. An entry
+ *                      without game_process or helper_processes costs nothing,
+ *                      the caller falls back to pidof().
+ ***********************************************************************************/
+GameProcState game_procs_track(const char* pkg, const GameOptions* opts) {
+    const char* pattern = game_proc_pattern(pkg, opts);
+    const char* helpers = opts && is_set(opts->helper_processes) ? opts->helper_processes : NULL;
+
+    if (game_procs.main > 0 && strcmp(game_procs.package, pkg) == 0) {
+        if (kill(game_procs.main, 0) == 0) [[clang::likely]]
+            return GAME_RUNNING;
+    }
+
+    memset(&game_procs, 0, sizeof(game_procs));
+    if (!pattern && !helpers)
+        return GAME_NOT_TRACKED;
+
+    snprintf(game_procs.package, sizeof(game_procs.package), "%s", pkg);
+    snprintf(main_pattern, sizeof(main_pattern), "%s", pattern ? pattern : pkg);
+    snprintf(helper_patterns, sizeof(helper_patterns), "%s", helpers ? helpers : "");
+
+    game_procs.main = scan_procs(pkg, game_procs.helpers, &game_procs.nr_helpers);
+    last_scan = now_ms();
+    if (game_procs.main == 0) {
+        game_procs.nr_helpers = 0;
+        return pattern ? GAME_RUN_BG : GAME_NOT_TRACKED;
+    }
+
+    log_zenith(LOG_INFO, "Tracking %s: main process %d (%s), %d helpers", pkg, game_procs.main, main_pattern,
+               game_procs.nr_helpers);
+    return GAME_RUNNING;
+}
+
+/***********************************************************************************
+ * Function Name      : game_procs_tick
+ * Inputs             : None
+ * Returns            : int - index of the first helper found by this call,
+ *                      game_procs.nr_helpers if there is none
+ * Description        : Every GAME_PROCS_RESCAN_MS looks for helpers started
+ *                      after the game, e.g. a renderer spawned once loading is
+ *                      done. Helpers that exited are dropped, new ones are
+ *                      appended so the caller only has to boost the tail.
+ ***********************************************************************************/
+int game_procs_tick(void) {
+    if (game_procs.main <= 0 || !helper_patterns[0])
+        return game_procs.nr_helpers;
+
+    int64_t now = now_ms();
+    if (now - last_scan < GAME_PROCS_RESCAN_MS)
+        return game_procs.nr_helpers;
+    last_scan = now;
+
+    pid_t found[MAX_GAME_HELPERS];
+    int nr_found;
+    scan_procs(game_procs.package, found, &nr_found);
+
+    int kept = 0;
+    for (int i = 0; i < game_procs.nr_helpers; i++) {
+        for (int j = 0; j < nr_found; j++) {
+            if (found[j] == game_procs.helpers[i]) {
+                game_procs.helpers[kept++] = found[j];
+                found[j] = 0;
+                break;
+            }
+        }
+    }
+
+    int first = kept;
+    for (int j = 0; j < nr_found && kept < MAX_GAME_HELPERS; j++) {
+        if (found[j] > 0)
+            game_procs.helpers[kept++] = found[j];
+    }
+    game_procs.nr_helpers = kept;
+
+    if (kept > first)
+        log_zenith(LOG_DEBUG, "Tracking %s: %d new helpers", game_procs.package, kept - first);
+    return first;
+}
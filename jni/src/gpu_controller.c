@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+// devfreq names that belong to a GPU
+static const char* const gpu_devfreq_names[] = {"kgsl-3d0", "gpu", "mali", "pvr"};
+
+static long freqs[MAX_GPU_FREQS];
+static int nr_freqs = 0;
+static int util_fd = -1;
+static int cur_fd = -1;
+static int min_fd = -1;
+static bool running = false;
+static char saved_min[32];
+static GpuCtl ctl;
+
+static long pread_long(int fd) {
+    char buf[64] = {0};
+    if (fd == -1 || pread(fd, buf, sizeof(buf) - 1, 0) <= 0)
+        return -1;
+    return atol(buf);
+}
+
+static int compare_long(const void* a, const void* b) {
+    long x = *(const long*)a;
+    long y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+/***********************************************************************************
+ * Function Name      : gpu_ctl_reset
+ * Inputs             : c (GpuCtl *) - controller state
+ * Returns            : None
+ * Description        : Floor back at the lowest OPP, hold-offs cleared.
+ ***********************************************************************************/
+void gpu_ctl_reset(GpuCtl* c) {
+    c->floor_idx = 0;
+    c->up_hold = 0;
+    c->down_hold = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : gpu_ctl_update
+ * Inputs             : c (GpuCtl *) - controller state
+ *                      table (const long *) - available frequencies, ascending
+ *                      count (int) - number of frequencies
+ *                      util (int) - GPU busy percent
+ *                      cur_freq (long) - current GPU frequency
+ * Returns            : int - index of the min_freq floor
+ * Description        : Raises the floor to the OPP that would bring utilization
+ *                      back to GPU_TARGET_PCT after GPU_UP_HOLD busy samples and
+ *                      walks it down one OPP per GPU_DOWN_HOLD quiet samples.
+ *                      Loads between the two thresholds keep the floor.
+ ***********************************************************************************/
+int gpu_ctl_update(GpuCtl* c, const long* table, int count, int util, long cur_freq) {
+    if (count <= 0)
+        return 0;
+
+    long desired = cur_freq / GPU_TARGET_PCT * util;
+    int want = 0;
+    while (want < count - 1 && table[want] < desired)
+        want++;
+
+    if (util >= GPU_UP_PCT && want > c->floor_idx) {
+        c->down_hold = 0;
+        if (++c->up_hold >= GPU_UP_HOLD) {
+            c->floor_idx = want;
+            c->up_hold = 0;
+        }
+    } else if (util < GPU_DOWN_PCT && c->floor_idx > 0) {
+        c->up_hold = 0;
+        if (++c->down_hold >= GPU_DOWN_HOLD) {
+            c->floor_idx--;
+            c->down_hold = 0;
+        }
+    } else {
+        c->up_hold = 0;
+        c->down_hold = 0;
+    }
+
+    return c->floor_idx;
+}
+
+/***********************************************************************************
+ * Function Name      : gpu_controller_init
+ * Inputs             : root (const char *) - sysfs root, NULL for /sys
+ * Returns            : bool - true if a GPU devfreq device was found
+ * Description        : Finds the GPU devfreq device and its utilization node.
+ *                      Taking the root as a parameter lets a fake devfreq tree
+ *                      with scripted utilization stand in for the real one.
+ ***********************************************************************************/
+bool gpu_controller_init(const char* root) {
+    if (!root)
+        root = "/sys";
+
+    char base[MAX_PATH_LENGTH];
+    snprintf(base, sizeof(base), "%s/class/devfreq", root);
+
+    char dev[MAX_PATH_LENGTH] = {0};
+    DIR* dir = opendir(base);
+    struct dirent* entry;
+    while (dir && !dev[0] && (entry = readdir(dir)) != NULL) {
+        for (size_t i = 0; i < sizeof(gpu_devfreq_names) / sizeof(gpu_devfreq_names[0]); i++) {
+            // Skip bus scaling nodes like *gpubw*
+            if (strstr(entry->d_name, gpu_devfreq_names[i]) && !strstr(entry->d_name, "bw")) {
+                snprintf(dev, sizeof(dev), "%s/%s", base, entry->d_name);
+                break;
+            }
+        }
+    }
+    if (dir)
+        closedir(dir);
+
+    if (!dev[0]) {
+        log_zenith(LOG_INFO, "GPU controller: no GPU devfreq device");
+        return false;
+    }
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/available_frequencies", dev);
+    FILE* fp = fopen(path, "r");
+    if (fp) {
+        while (nr_freqs < MAX_GPU_FREQS && fscanf(fp, "%ld", &freqs[nr_freqs]) == 1)
+            nr_freqs++;
+        fclose(fp);
+        qsort(freqs, nr_freqs, sizeof(long), compare_long);
+    }
+
+    snprintf(path, sizeof(path), "%s/cur_freq", dev);
+    cur_fd = open(path, O_RDONLY | O_CLOEXEC);
+    snprintf(path, sizeof(path), "%s/min_freq", dev);
+    min_fd = open(path, O_RDWR | O_CLOEXEC);
+
+    const char* util_nodes[] = {"%s/class/kgsl/kgsl-3d0/gpu_busy_percentage", "%s/device/utilization", "%s/load",
+                                "%s/kernel/gpu/gpu_busy"};
+    for (size_t i = 0; i < sizeof(util_nodes) / sizeof(util_nodes[0]) && util_fd == -1; i++) {
+        // kgsl and /kernel/gpu hang off the sysfs root, the others off the device
+        const char* prefix = (i == 0 || i == 3) ? root : dev;
+        snprintf(path, sizeof(path), util_nodes[i], prefix);
+        util_fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+
+    if (nr_freqs == 0 || cur_fd == -1 || min_fd == -1 || util_fd == -1) {
+        log_zenith(LOG_INFO, "GPU controller: %s lacks frequency or utilization nodes", dev);
+        return false;
+    }
+
+    gpu_ctl_reset(&ctl);
+    log_zenith(LOG_INFO, "GPU controller ready on %s, %d OPPs", dev, nr_freqs);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : gpu_controller_tick
+ * Inputs             : None
+ * Returns            : None
+ * Description        : One sample of the performance profile GPU loop. The
+ *                      first tick after a profile apply saves min_freq and drops
+ *                      the floor to the lowest OPP.
+ ***********************************************************************************/
+void gpu_controller_tick(void) {
+    if (util_fd == -1)
+        return;
+
+    long util = pread_long(util_fd);
+    long cur = pread_long(cur_fd);
+    if (util < 0 || cur <= 0)
+        return;
+
+    int prev = ctl.floor_idx;
+    if (!running) {
+        memset(saved_min, 0, sizeof(saved_min));
+        if (pread(min_fd, saved_min, sizeof(saved_min) - 1, 0) > 0)
+            trim_newline(saved_min);
+        gpu_ctl_reset(&ctl);
+        running = true;
+        prev = -1;
+    }
+
+    int idx = gpu_ctl_update(&ctl, freqs, nr_freqs, (int)(util > 100 ? 100 : util), cur);
+    if (idx == prev)
+        return;
+
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%ld", freqs[idx]);
+    pwrite(min_fd, buf, len, 0);
+    stats.gpu_floor_changes++;
+}
+
+/***********************************************************************************
+ * Function Name      : gpu_controller_stop
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Gives min_freq back before another profile is applied.
+ ***********************************************************************************/
+void gpu_controller_stop(void) {
+    if (!running)
+        return;
+
+    running = false;
+    if (saved_min[0])
+        pwrite(min_fd, saved_min, strlen(saved_min), 0);
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <errno.h>
+#include <linux/input.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+
+#define BITS_PER_LONG (sizeof(long) * 8)
+#define NBITS(x) ((((x) - 1) / BITS_PER_LONG) + 1)
+#define TEST_BIT(bit, array) ((array[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1)
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static int input_fd = -1;
+static int timer_fd = -1;
+static int min_fd = -1;
+static int uclamp_fd = -1;
+static const CpuCluster* top = NULL;
+static bool enabled = false;
+static bool touching = false;
+static bool has_btn_touch = false;
+static int level = 0; // remaining decay steps, 0 when released
+static int64_t last_boost = 0;
+static char saved_min[24];
+static char saved_uclamp[24];
+
+static void arm_timer(int ms) {
+    struct itimerspec its = {0};
+    its.it_value.tv_sec = ms / 1000;
+    its.it_value.tv_nsec = (long)(ms % 1000) * 1000000;
+    timerfd_settime(timer_fd, 0, &its, NULL);
+}
+
+static void pwrite_str(int fd, const char* value) {
+    if (fd != -1)
+        pwrite(fd, value, strlen(value), 0);
+}
+
+static void pread_str(int fd, char* buf, size_t size) {
+    memset(buf, 0, size);
+    if (fd != -1 && pread(fd, buf, size - 1, 0) > 0)
+        trim_newline(buf);
+}
+
+/***********************************************************************************
+ * Function Name      : boost_apply_level
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Writes the top cluster min frequency and top-app uclamp.min
+ *                      for the current decay level, scaled linearly between the
+ *                      saved values and the full boost.
+ ***********************************************************************************/
+static void boost_apply_level(void) {
+    char buf[24];
+    int base = atoi(saved_min);
+    int full = cluster_floor_freq(top, (int)((long)top->cpuinfo_max * INPUT_BOOST_FREQ_PCT / 100));
+    int freq = base + (full - base) * level / INPUT_BOOST_STEPS;
+    freq = freq > base ? cluster_floor_freq(top, freq) : base;
+
+    if (access(PPM_MIN_FREQ, F_OK) == 0) {
+        write2file(PPM_MIN_FREQ, false, false, "%d %d", nr_clusters - 1, freq);
+    } else {
+        snprintf(buf, sizeof(buf), "%d", freq);
+        pwrite_str(min_fd, buf);
+    }
+
+    if (uclamp_fd != -1) {
+        int base_clamp = atoi(saved_uclamp);
+        int clamp = base_clamp + (INPUT_BOOST_UCLAMP - base_clamp) * level / INPUT_BOOST_STEPS;
+        snprintf(buf, sizeof(buf), "%d", clamp > base_clamp ? clamp : base_clamp);
+        pwrite_str(uclamp_fd, buf);
+    }
+}
+
+static void boost_restore(void) {
+    // saved_min comes from cpufreq, PPM only drops its floor with -1
+    if (access(PPM_MIN_FREQ, F_OK) == 0) {
+        write2file(PPM_MIN_FREQ, false, false, "%d -1", nr_clusters - 1);
+    } else {
+        pwrite_str(min_fd, saved_min);
+    }
+    pwrite_str(uclamp_fd, saved_uclamp);
+}
+
+/***********************************************************************************
+ * Function Name      : boost_release
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Stops the decay and restores the values saved when the
+ *                      boost started.
+ ***********************************************************************************/
+static void boost_release(void) {
+    if (level == 0)
+        return;
+
+    level = 0;
+    arm_timer(0);
+    boost_restore();
+}
+
+/***********************************************************************************
+ * Function Name      : boost_touch_down
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Starts or refreshes the boost. Refreshes are limited to
+ *                      one per INPUT_BOOST_RATE_MS so a swipe storm does not turn
+ *                      into a sysfs write storm.
+ ***********************************************************************************/
+static void boost_touch_down(void) {
+    if (!enabled)
+        return;
+
+    int64_t now = now_ms();
+    if (now - last_boost < INPUT_BOOST_RATE_MS) {
+        stats.input_boost_suppressed++;
+        return;
+    }
+    last_boost = now;
+
+    if (level == 0) {
+        pread_str(min_fd, saved_min, sizeof(saved_min));
+        pread_str(uclamp_fd, saved_uclamp, sizeof(saved_uclamp));
+    }
+
+    level = INPUT_BOOST_STEPS;
+    boost_apply_level();
+    arm_timer(INPUT_BOOST_STEP_MS);
+    stats.input_boosts++;
+}
+
+static void input_handler(int fd) {
+    struct input_event ev[64];
+    ssize_t len;
+
+    while ((len = read(fd, ev, sizeof(ev))) > 0) {
+        for (size_t i = 0; i < (size_t)len / sizeof(ev[0]); i++) {
+            bool down = false;
+            if (has_btn_touch && ev[i].type == EV_KEY && ev[i].code == BTN_TOUCH) {
+                down = ev[i].value == 1 && !touching;
+                touching = ev[i].value == 1;
+            } else if (!has_btn_touch && ev[i].type == EV_ABS && ev[i].code == ABS_MT_TRACKING_ID) {
+                // Without BTN_TOUCH every new contact counts as a touch-down
+                down = ev[i].value >= 0;
+            }
+
+            if (down)
+                boost_touch_down();
+        }
+    }
+
+    // Device went away, stop polling it
+    if (len == 0 || (len < 0 && errno != EAGAIN)) {
+        log_zenith(LOG_WARN, "Touch boost: input device lost");
+        event_loop_remove(fd);
+        close(fd);
+        input_fd = -1;
+        enabled = false;
+        boost_release();
+    }
+}
+
+static void timer_handler(int fd) {
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations) || level == 0)
+        return;
+
+    if (--level == 0) {
+        boost_restore();
+        return;
+    }
+
+    boost_apply_level();
+    arm_timer(INPUT_BOOST_STEP_MS);
+}
+
+/***********************************************************************************
+ * Function Name      : is_touchscreen
+ * Inputs             : fd (int) - opened evdev node
+ * Returns            : bool - true if the device reports multitouch positions
+ * Description        : Checks EV_ABS capabilities for ABS_MT_POSITION_X.
+ ***********************************************************************************/
+static bool is_touchscreen(int fd) {
+    unsigned long ev_bits[NBITS(EV_MAX)] = {0};
+    unsigned long abs_bits[NBITS(ABS_MAX)] = {0};
+
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(ev_bits)), ev_bits) < 0 || !TEST_BIT(EV_ABS, ev_bits))
+        return false;
+    if (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs_bits)), abs_bits) < 0)
+        return false;
+    return TEST_BIT(ABS_MT_POSITION_X, abs_bits);
+}
+
+/***********************************************************************************
+ * Function Name      : input_boost_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ *                      device (const char *) - evdev node, NULL to scan /dev/input
+ * Returns            : bool - true if a touchscreen is being watched
+ * Description        : Opens the touchscreen read-only and registers the decay
+ *                      timer with the event loop. The touchscreen itself is
+ *                      only polled while boosting is enabled. Passing a device
+ *                      lets a uinput test device stand in for the touchscreen.
+ ***********************************************************************************/
+bool input_boost_init(const char* root, const char* device) {
+    if (nr_clusters == 0)
+        return false;
+
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+    char path[MAX_PATH_LENGTH * 2];
+
+    if (device) {
+        input_fd = open(device, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    } else {
+        snprintf(path, sizeof(path), "%s/dev/input", root_dir);
+        DIR* dir = opendir(path);
+        struct dirent* entry;
+        while (dir && input_fd == -1 && (entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "event", 5) != 0)
+                continue;
+
+            snprintf(path, sizeof(path), "%s/dev/input/%s", root_dir, entry->d_name);
+            int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+            if (fd == -1)
+                continue;
+
+            if (is_touchscreen(fd)) {
+                input_fd = fd;
+                log_zenith(LOG_DEBUG, "Touch boost: using %s", path);
+            } else {
+                close(fd);
+            }
+        }
+        if (dir)
+            closedir(dir);
+    }
+
+    if (input_fd == -1) {
+        log_zenith(LOG_INFO, "Touch boost: no touchscreen found");
+        return false;
+    }
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1) {
+        close(input_fd);
+        input_fd = -1;
+        return false;
+    }
+
+    top = &clusters[nr_clusters - 1];
+    snprintf(path, sizeof(path), "%s%s/policy%d/scaling_min_freq", root_dir, CPUFREQ_PATH, top->policy);
+    min_fd = open(path, O_RDWR | O_CLOEXEC);
+    snprintf(path, sizeof(path), "%s/dev/cpuctl/top-app/cpu.uclamp.min", root_dir);
+    uclamp_fd = open(path, O_RDWR | O_CLOEXEC);
+
+    unsigned long key_bits[NBITS(KEY_MAX)] = {0};
+    if (ioctl(input_fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits) >= 0)
+        has_btn_touch = TEST_BIT(BTN_TOUCH, key_bits);
+
+    event_loop_add(timer_fd, timer_handler);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : input_boost_set_enabled
+ * Inputs             : on (bool) - whether touches should boost
+ * Returns            : None
+ * Description        : Called every loop. The touchscreen joins the event loop
+ *                      only while enabled, so touches do not wake the daemon
+ *                      otherwise. A running boost is released as soon as
+ *                      boosting is no longer wanted, and before every profile
+ *                      apply so its restore never lands on another profile.
+ ***********************************************************************************/
+void input_boost_set_enabled(bool on) {
+    on = on && input_fd != -1;
+    if (on == enabled)
+        return;
+
+    if (on) {
+        // Drop what queued up while nobody was listening
+        struct input_event ev[64];
+        while (read(input_fd, ev, sizeof(ev)) > 0)
+            ;
+        touching = false;
+        event_loop_add(input_fd, input_handler);
+    } else {
+        if (input_fd != -1)
+            event_loop_remove(input_fd);
+        boost_release();
+    }
+    enabled = on;
+}
+
+/***********************************************************************************
+ * Function Name      : input_boost_active
+ * Inputs             : None
+ * Returns            : bool - true while a boost holds the top cluster
+ * Description        : Lets the frequency enforcer stay off the boosted limits.
+ ***********************************************************************************/
+bool input_boost_active(void) {
+    return level > 0;
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+typedef struct {
+    IrqClass cls;
+    const char* pattern;
+} IrqPattern;
+
+// Matched against the lowercased chip and action names of /proc/interrupts
+static const IrqPattern irq_patterns[] = {
+    {IRQ_TOUCH, "touch"},   {IRQ_TOUCH, "fts"},    {IRQ_TOUCH, "goodix"},  {IRQ_TOUCH, "synaptics"},
+    {IRQ_TOUCH, "nvt"},     {IRQ_TOUCH, "himax"},  {IRQ_TOUCH, "ilitek"},  {IRQ_TOUCH, "sec_ts"},
+    {IRQ_GPU, "kgsl"},      {IRQ_GPU, "mali"},     {IRQ_GPU, "gpu"},       {IRQ_GPU, "pvr"},
+    {IRQ_STORAGE, "ufs"},   {IRQ_STORAGE, "mmc"},  {IRQ_STORAGE, "sdhc"},
+};
+
+// Thread names of the common engines' game and render loops
+static const char* const render_threads[] = {"UnityMain", "UnityGfxDevice", "RenderThread", "GameThread",
+                                             "RHIThread",  "GLThread",       "MainThread-UE4"};
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static IrqEntry irqs[MAX_IRQS];
+static int nr_irqs = 0;
+static bool steered = false;
+
+static bool read_line(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    bool ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        trim_newline(buf);
+    return ok;
+}
+
+// No stdio, a refused write has to surface as a return value
+static bool write_str(const char* path, const char* value) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    bool ok = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+    return ok;
+}
+
+/***********************************************************************************
+ * Function Name      : irq_classify
+ * Inputs             : desc (const char *) - everything after the per-cpu counts
+ * Returns            : IrqClass - class of the interrupt, IRQ_OTHER if unknown
+ * Description        : Classifies an interrupt by its chip and action names.
+ ***********************************************************************************/
+IrqClass irq_classify(const char* desc) {
+    char lower[MAX_LINE];
+    size_t i = 0;
+    for (; desc[i] && i < sizeof(lower) - 1; i++)
+        lower[i] = (char)tolower((unsigned char)desc[i]);
+    lower[i] = '\0';
+
+    for (size_t p = 0; p < sizeof(irq_patterns) / sizeof(irq_patterns[0]); p++) {
+        if (strstr(lower, irq_patterns[p].pattern))
+            return irq_patterns[p].cls;
+    }
+    return IRQ_OTHER;
+}
+
+/***********************************************************************************
+ * Function Name      : irq_steer_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : int - number of interrupts worth steering
+ * Description        : Parses /proc/interrupts into a table of touch, GPU and
+ *                      storage interrupts. Per-cpu rows like IPI or LOC have no
+ *                      numeric id and are skipped. The root prefix lets a fake
+ *                      procfs stand in for the real one.
+ ***********************************************************************************/
+int irq_steer_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+    nr_irqs = 0;
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/proc/interrupts", root_dir);
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        log_zenith(LOG_INFO, "IRQ steering: unable to open %s", path);
+        return 0;
+    }
+
+    // Header holds one column per cpu present at boot
+    char line[MAX_DATA_LENGTH];
+    int nr_cols = 0;
+    if (fgets(line, sizeof(line), fp)) {
+        for (char* p = strstr(line, "CPU"); p; p = strstr(p + 3, "CPU"))
+            nr_cols++;
+    }
+
+    while (nr_irqs < MAX_IRQS && fgets(line, sizeof(line), fp)) {
+        char* p = skip_space(line);
+        if (!isdigit((unsigned char)*p))
+            continue;
+
+        char* end;
+        int irq = (int)strtol(p, &end, 10);
+        if (*end != ':')
+            continue;
+
+        // Skip the per-cpu counters
+        p = end + 1;
+        for (int col = 0; col < nr_cols; col++) {
+            strtoull(p, &end, 10);
+            p = end;
+        }
+        trim_newline(p);
+
+        IrqClass cls = irq_classify(p);
+        if (cls == IRQ_OTHER)
+            continue;
+
+        IrqEntry* e = &irqs[nr_irqs];
+        e->irq = irq;
+        e->cls = cls;
+        snprintf(e->path, sizeof(e->path), "%s/proc/irq/%d/smp_affinity_list", root_dir, irq);
+        if (!read_line(e->path, e->saved, sizeof(e->saved)) || !e->saved[0])
+            continue;
+
+        log_zenith(LOG_DEBUG, "IRQ steering: irq %d class %d affinity %s (%s)", irq, cls, e->saved, skip_space(p));
+        nr_irqs++;
+    }
+    fclose(fp);
+
+    log_zenith(LOG_INFO, "IRQ steering: %d interrupts to steer", nr_irqs);
+    return nr_irqs;
+}
+
+static uint64_t cluster_of(int cpu) {
+    for (int i = 0; i < nr_clusters; i++) {
+        if (clusters[i].cpu_mask & (1ULL << cpu))
+            return clusters[i].cpu_mask;
+    }
+    return 0;
+}
+
+/***********************************************************************************
+ * Function Name      : irq_render_cpus
+ * Inputs             : pid (pid_t) - game process
+ * Returns            : uint64_t - cpus the game's render threads last ran on
+ * Description        : Walks the game's threads and collects the processor
+ *                      field of /proc/<pid>/task/<tid>/stat for threads named
+ *                      after a known engine loop.
+ ***********************************************************************************/
+uint64_t irq_render_cpus(pid_t pid) {
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/proc/%d/task", root_dir, pid);
+    DIR* dir = opendir(path);
+    if (!dir)
+        return 0;
+
+    uint64_t mask = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)entry->d_name[0]))
+            continue;
+
+        char comm[32] = {0};
+        snprintf(path, sizeof(path), "%s/proc/%d/task/%s/comm", root_dir, pid, entry->d_name);
+        if (!read_line(path, comm, sizeof(comm)))
+            continue;
+
+        bool render = false;
+        for (size_t i = 0; i < sizeof(render_threads) / sizeof(render_threads[0]) && !render; i++)
+            render = strncmp(comm, render_threads[i], strlen(render_threads[i])) == 0;
+        if (!render)
+            continue;
+
+        char stat[MAX_DATA_LENGTH] = {0};
+        snprintf(path, sizeof(path), "%s/proc/%d/task/%s/stat", root_dir, pid, entry->d_name);
+        if (!read_line(path, stat, sizeof(stat)))
+            continue;
+
+        // comm may hold spaces, count fields from the closing paren; processor is field 39
+        char* p = strrchr(stat, ')');
+        for (int field = 2; p && field < 39; field++) {
+            p = strchr(p + 1, ' ');
+        }
+        if (p) {
+            int cpu = atoi(p + 1);
+            if (cpu >= 0 && cpu < MAX_CPUS)
+                mask |= 1ULL << cpu;
+        }
+    }
+    closedir(dir);
+    return mask;
+}
+
+/***********************************************************************************
+ * Function Name      : irq_steer_restore
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Writes every saved affinity back, for other profiles
+ *                      and from restore_on_exit() once the main loop stopped.
+ ***********************************************************************************/
+void irq_steer_restore(void) {
+    if (!steered)
+        return;
+
+    for (int i = 0; i < nr_irqs; i++)
+        write_str(irqs[i].path, irqs[i].saved);
+    steered = false;
+}
+
+/***********************************************************************************
+ * Function Name      : irq_steer_apply
+ * Inputs             : mode (ProfileMode) - profile being applied
+ *                      pid (pid_t) - game process, 0 if none
+ * Returns            : None
+ * Description        : In performance, storage and GPU interrupts move off the
+ *                      cluster hosting the render threads, preferably onto the
+ *                      little cluster, and touch interrupts move onto that
+ *                      cluster next to the render threads without sharing their
+ *                      cpus when it can. Other profiles get the saved affinity.
+ * Note               : Managed and per-cpu interrupts reject the write, those
+ *                      keep the vendor affinity.
+ ***********************************************************************************/
+void irq_steer_apply(ProfileMode mode, pid_t pid) {
+    if (nr_irqs == 0 || nr_clusters == 0)
+        return;
+
+    if (mode != PERFORMANCE_PROFILE) {
+        irq_steer_restore();
+        return;
+    }
+
+    uint64_t online = 0;
+    for (int i = 0; i < nr_clusters; i++)
+        online |= clusters[i].cpu_mask;
+
+    uint64_t render = pid > 0 ? irq_render_cpus(pid) : 0;
+    if (!render)
+        render = clusters[nr_clusters - 1].cpu_mask;
+
+    uint64_t render_cluster = 0;
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (render & (1ULL << cpu))
+            render_cluster |= cluster_of(cpu);
+    }
+    if (!render_cluster)
+        render_cluster = render;
+
+    uint64_t away = clusters[0].cpu_mask & ~render_cluster;
+    if (!away)
+        away = online & ~render_cluster;
+    if (!away)
+        away = online & ~render;
+
+    uint64_t near = render_cluster & ~render;
+    if (!near)
+        near = render_cluster;
+
+    char touch_list[MAX_LINE];
+    char away_list[MAX_LINE];
+    cpu_mask_to_list(near, touch_list, sizeof(touch_list));
+    cpu_mask_to_list(away ? away : online, away_list, sizeof(away_list));
+
+    int moved = 0;
+    for (int i = 0; i < nr_irqs; i++) {
+        const char* target = irqs[i].cls == IRQ_TOUCH ? touch_list : away_list;
+        if (write_str(irqs[i].path, target))
+            moved++;
+        else
+            log_zenith(LOG_DEBUG, "IRQ steering: irq %d refused %s", irqs[i].irq, target);
+    }
+    steered = true;
+
+    log_zenith(LOG_INFO, "IRQ steering: %d/%d interrupts moved, touch on %s, storage/GPU on %s", moved, nr_irqs,
+               touch_list, away_list);
+}
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <sched.h>
+
+typedef struct {
+    uint64_t busy;
+    uint64_t total;
+    uint8_t load[LOAD_WINDOW]; // frequency normalised busy percent
+} CoreLoad;
+
+typedef struct {
+    int stats_fd; // stats/time_in_state
+    int cur_fd;   // scaling_cur_freq, used when cpufreq stats are disabled
+    uint64_t weighted;
+    uint64_t time;
+    int scale; // average frequency of the last interval, percent of cpuinfo_max
+} PolicyLoad;
+
+// First readable node wins, all of them report a busy percentage first
+static const char* const gpu_nodes[] = {
+    "/sys/class/kgsl/kgsl-3d0/gpu_busy_percentage",
+    "/sys/kernel/gpu/gpu_busy",
+    "/sys/kernel/ged/hal/gpu_utilization",
+    "/sys/module/ged/parameters/gpu_loading",
+    "/proc/mali/utilization",
+};
+
+static CoreLoad cores[MAX_CPUS];
+static PolicyLoad policies[MAX_CLUSTERS];
+static uint8_t gpu_load[LOAD_WINDOW];
+static int nr_cores = 0;
+static int ring_pos = 0;
+static int ring_fill = 0;
+static int stat_fd = -1;
+static int gpu_fd = -1;
+static LoadClassifier classifier;
+
+static ssize_t pread_text(int fd, char* buf, size_t size) {
+    ssize_t len = pread(fd, buf, size - 1, 0);
+    buf[len > 0 ? len : 0] = '\0';
+    return len;
+}
+
+/***********************************************************************************
+ * Function Name      : load_sampler_init
+ * Inputs             : None
+ * Returns            : bool - true if /proc/stat could be opened
+ * Description        : Opens every node the sampler reads once, samples are
+ *                      taken with pread afterwards.
+ ***********************************************************************************/
+bool load_sampler_init(void) {
+    stat_fd = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+    if (stat_fd == -1) {
+        log_zenith(LOG_WARN, "Load sampler: /proc/stat unavailable");
+        return false;
+    }
+
+    for (int i = 0; i < nr_clusters; i++) {
+        char path[MAX_PATH_LENGTH];
+        snprintf(path, sizeof(path), "%s/policy%d/stats/time_in_state", CPUFREQ_PATH, clusters[i].policy);
+        policies[i].stats_fd = open(path, O_RDONLY | O_CLOEXEC);
+        snprintf(path, sizeof(path), "%s/policy%d/scaling_cur_freq", CPUFREQ_PATH, clusters[i].policy);
+        policies[i].cur_fd = open(path, O_RDONLY | O_CLOEXEC);
+        policies[i].scale = 100;
+    }
+
+    for (size_t i = 0; i < sizeof(gpu_nodes) / sizeof(gpu_nodes[0]) && gpu_fd == -1; i++)
+        gpu_fd = open(gpu_nodes[i], O_RDONLY | O_CLOEXEC);
+
+    load_classifier_reset(&classifier);
+    log_zenith(LOG_INFO, "Load sampler ready, %d policies, GPU load %s", nr_clusters, gpu_fd != -1 ? "available" : "unavailable");
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : sample_policy_scale
+ * Inputs             : p (PolicyLoad *) - policy to update
+ *                      c (const CpuCluster *) - matching cluster
+ * Returns            : None
+ * Description        : Works out the average frequency of the last interval
+ *                      from time_in_state deltas, so 100% busy at the lowest
+ *                      OPP does not look like a heavy load.
+ ***********************************************************************************/
+static void sample_policy_scale(PolicyLoad* p, const CpuCluster* c) {
+    char buf[2048];
+    if (c->cpuinfo_max <= 0)
+        return;
+
+    if (p->stats_fd != -1 && pread_text(p->stats_fd, buf, sizeof(buf)) > 0) {
+        uint64_t weighted = 0;
+        uint64_t time = 0;
+        for (char* line = buf; *line;) {
+            char* end;
+            unsigned long long freq = strtoull(line, &end, 10);
+            unsigned long long t = strtoull(end, &end, 10);
+            weighted += freq * t;
+            time += t;
+            line = strchr(end, '\n');
+            if (!line)
+                break;
+            line++;
+        }
+
+        uint64_t dt = time - p->time;
+        if (p->time && dt > 0)
+            p->scale = (int)((weighted - p->weighted) / dt * 100 / (uint64_t)c->cpuinfo_max);
+        p->weighted = weighted;
+        p->time = time;
+    } else if (p->cur_fd != -1 && pread_text(p->cur_fd, buf, sizeof(buf)) > 0) {
+        p->scale = (int)((long)atoi(buf) * 100 / c->cpuinfo_max);
+    }
+
+    if (p->scale > 100)
+        p->scale = 100;
+}
+
+static int cpu_scale(int cpu) {
+    for (int i = 0; i < nr_clusters; i++) {
+        if (clusters[i].cpu_mask & (1ULL << cpu))
+            return policies[i].scale;
+    }
+    return 100;
+}
+
+/***********************************************************************************
+ * Function Name      : sample_once
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Takes one sample of every core and the GPU into the
+ *                      ring buffers.
+ ***********************************************************************************/
+static void sample_once(void) {
+    char buf[8192];
+
+    for (int i = 0; i < nr_clusters; i++)
+        sample_policy_scale(&policies[i], &clusters[i]);
+
+    if (pread_text(stat_fd, buf, sizeof(buf)) <= 0)
+        return;
+
+    // Skip the aggregate "cpu " line, per-core lines follow it
+    char* line = strchr(buf, '\n');
+    while (line && strncmp(++line, "cpu", 3) == 0) {
+        char* end;
+        int cpu = (int)strtol(line + 3, &end, 10);
+        if (cpu < 0 || cpu >= MAX_CPUS)
+            break;
+
+        uint64_t v[8] = {0};
+        for (int i = 0; i < 8; i++)
+            v[i] = strtoull(end, &end, 10);
+
+        // user nice system idle iowait irq softirq steal
+        uint64_t idle = v[3] + v[4];
+        uint64_t total = v[0] + v[1] + v[2] + v[5] + v[6] + v[7] + idle;
+        CoreLoad* c = &cores[cpu];
+        uint64_t dt = total - c->total;
+        uint64_t db = (total - idle) - c->busy;
+        int busy = (c->total && dt > 0) ? (int)(db * 100 / dt) : 0;
+        c->load[ring_pos] = (uint8_t)(busy * cpu_scale(cpu) / 100);
+        c->busy = total - idle;
+        c->total = total;
+
+        if (cpu + 1 > nr_cores)
+            nr_cores = cpu + 1;
+        line = strchr(line, '\n');
+    }
+
+    int gpu = 0;
+    if (gpu_fd != -1 && pread_text(gpu_fd, buf, 64) > 0)
+        gpu = atoi(buf);
+    gpu_load[ring_pos] = (uint8_t)(gpu < 0 ? 0 : gpu > 100 ? 100 : gpu);
+
+    ring_pos = (ring_pos + 1) % LOAD_WINDOW;
+    if (ring_fill < LOAD_WINDOW)
+        ring_fill++;
+}
+
+/***********************************************************************************
+ * Function Name      : load_classifier_reset
+ * Inputs             : c (LoadClassifier *) - classifier to reset
+ * Returns            : None
+ * Description        : Starts out interactive, which keeps the balanced profile.
+ ***********************************************************************************/
+void load_classifier_reset(LoadClassifier* c) {
+    c->cur = LOAD_INTERACTIVE;
+    c->pending = LOAD_INTERACTIVE;
+    c->hold = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : load_classifier_update
+ * Inputs             : c (LoadClassifier *) - classifier state
+ *                      top (int) - window mean of the busiest core, percent
+ *                      gpu (int) - window mean of GPU load, percent
+ * Returns            : LoadClass - class after this sample
+ * Description        : Hysteresis classifier. Leaving a class uses looser
+ *                      thresholds than entering it, and a new class must be
+ *                      seen for its hold count in a row before it is taken.
+ ***********************************************************************************/
+LoadClass load_classifier_update(LoadClassifier* c, int top, int gpu) {
+    bool heavy = c->cur == LOAD_HEAVY ? (top >= LOAD_HEAVY_EXIT || gpu >= LOAD_GPU_HEAVY_EXIT)
+                                      : (top >= LOAD_HEAVY_ENTER || gpu >= LOAD_GPU_HEAVY_ENTER);
+    bool idle = c->cur == LOAD_IDLE ? (top < LOAD_IDLE_EXIT && gpu < LOAD_GPU_IDLE_EXIT)
+                                    : (top < LOAD_IDLE_ENTER && gpu < LOAD_GPU_IDLE_ENTER);
+    LoadClass candidate = heavy ? LOAD_HEAVY : idle ? LOAD_IDLE : LOAD_INTERACTIVE;
+
+    if (candidate == c->cur) {
+        c->hold = 0;
+        return c->cur;
+    }
+
+    if (candidate != c->pending) {
+        c->pending = candidate;
+        c->hold = 0;
+    }
+
+    int need = candidate == LOAD_HEAVY ? LOAD_HEAVY_HOLD : candidate == LOAD_IDLE ? LOAD_IDLE_HOLD : LOAD_INTERACTIVE_HOLD;
+    if (++c->hold >= need) {
+        c->cur = candidate;
+        c->hold = 0;
+    }
+    return c->cur;
+}
+
+/***********************************************************************************
+ * Function Name      : load_sampler_tick
+ * Inputs             : None
+ * Returns            : LoadClass - current load class
+ * Description        : Takes a sample and runs the classifier over the window
+ *                      means. CPU time spent here is accounted in stats.
+ ***********************************************************************************/
+LoadClass load_sampler_tick(void) {
+    if (stat_fd == -1)
+        return LOAD_INTERACTIVE;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+
+    sample_once();
+
+    if (ring_fill == LOAD_WINDOW) {
+        int top = 0;
+        int gpu = 0;
+        for (int cpu = 0; cpu < nr_cores; cpu++) {
+            int sum = 0;
+            for (int i = 0; i < LOAD_WINDOW; i++)
+                sum += cores[cpu].load[i];
+            if (sum / LOAD_WINDOW > top)
+                top = sum / LOAD_WINDOW;
+        }
+        for (int i = 0; i < LOAD_WINDOW; i++)
+            gpu += gpu_load[i];
+        load_classifier_update(&classifier, top, gpu / LOAD_WINDOW);
+    }
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+    stats.load_samples++;
+    stats.load_sampler_cpu_us += (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+    return classifier.cur;
+}
+
+/***********************************************************************************
+ * Function Name      : load_sampler_class
+ * Inputs             : None
+ * Returns            : LoadClass - class from the last tick
+ * Description        : Read-only accessor used by the profile state machine.
+ ***********************************************************************************/
+LoadClass load_sampler_class(void) {
+    return classifier.cur;
+}
+
+/***********************************************************************************
+ * Function Name      : handle_bench_load
+ * Inputs             : argc - number of CLI arguments
+ *                      argv - array of CLI argument strings
+ * Returns            : int - 0 if the sampler fits its CPU budget, 1 otherwise
+ * Description        : Runs the sampler pinned to the first little core and
+ *                      reports its CPU cost against the daemon loop intervals.
+ *                      The budget is 1% of one core at the performance
+ *                      profile interval, the shortest one.
+ ***********************************************************************************/
+int handle_bench_load(int argc, char** argv) {
+    int iterations = argc > 2 ? atoi(argv[2]) : 1000;
+    if (iterations <= 0)
+        iterations = 1000;
+
+    cpu_topology_init();
+    if (!load_sampler_init()) {
+        fprintf(stderr, "\033[31mERROR:\033[0m Unable to open /proc/stat\n");
+        return 1;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(nr_clusters > 0 ? __builtin_ctzll(clusters[0].cpu_mask | (1ULL << 63)) : 0, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+
+    stats.load_samples = 0;
+    stats.load_sampler_cpu_us = 0;
+    for (int i = 0; i < iterations; i++)
+        load_sampler_tick();
+
+    double per_sample = (double)stats.load_sampler_cpu_us / iterations;
+    double perf_pct = per_sample / (LOOP_INTERVAL_MS * 1000.0) * 100.0;
+    double idle_pct = per_sample / (LOOP_INTERVAL_SEC * 1000000.0) * 100.0;
+
+    printf("Samples: %d, %.1fus CPU per sample\n", iterations, per_sample);
+    printf("Core usage at %dms interval: %.4f%%\n", LOOP_INTERVAL_MS, perf_pct);
+    printf("Core usage at %dms interval: %.4f%%\n", LOOP_INTERVAL_SEC * 1000, idle_pct);
+    printf("Budget 1%%: %s\n", perf_pct < 1.0 ? "OK" : "EXCEEDED");
+    return perf_pct < 1.0 ? 0 : 1;
+}
@@ -15,9 +15,10 @@
  */
 
 #include <AZenith.h>
+#include <errno.h>
 #include <sys/system_properties.h>
 #include <time.h>
-static time_t last_task_run = 0;
+static bool task_ran = false;
 
 /***********************************************************************************
  * Function Name      : trim_newline
@@ -68,20 +69,22 @@ void notify(const char* title, const char* fmt, const char* chrono, int timeout_
 /***********************************************************************************
  * Function Name      : timern
  * Inputs             : None
- * Returns            : char * - pointer to a statically allocated string
- *                      with the formatted time.
+ * Returns            : char * - pointer to a statically allocated, per thread
+ *                      string with the formatted time.
  * Description        : Generates a timestamp with the format
  *                      [YYYY-MM-DD HH:MM:SS.milliseconds].
  ***********************************************************************************/
 char* timern(void) {
-    static char timestamp[64];
+    // Per thread, init stages log concurrently
+    static _Thread_local char timestamp[64];
     struct timeval tv;
     time_t current_time;
+    struct tm tm_buf;
     struct tm* local_time;
 
     gettimeofday(&tv, NULL);
     current_time = tv.tv_sec;
-    local_time = localtime(&current_time);
+    local_time = localtime_r(&current_time, &tm_buf);
 
     if (local_time == NULL) [[clang::unlikely]] {
         strcpy(timestamp, "[TimeError]");
@@ -100,24 +103,59 @@ char* timern(void) {
     return timestamp;
 }
 
+static int signal_pipe[2] = {-1, -1};
+static pid_t signal_owner = 0;
+static volatile sig_atomic_t exit_signal = 0;
+
 /***********************************************************************************
  * Function Name      : sighandler
  * Inputs             : int signal - exit signal
  * Returns            : None
- * Description        : Handle exit signal.
+ * Description        : Handle exit signal. Only records it and wakes the daemon
+ *                      loop through the signal pipe, the loop then stops and
+ *                      puts everything back outside of signal context.
  ***********************************************************************************/
-[[noreturn]] void sighandler(const int signal) {
-    switch (signal) {
-    case SIGTERM:
-        log_zenith(LOG_INFO, "Received SIGTERM, exiting.");
-        break;
-    case SIGINT:
-        log_zenith(LOG_INFO, "Received SIGINT, exiting.");
-        break;
-    }
+void sighandler(const int signal) {
+    // A forked child that has not exec'd yet shares the pipe but is not the daemon
+    if (getpid() != signal_owner)
+        _exit(128 + signal);
+
+    int saved_errno = errno;
+    exit_signal = signal;
+    if (signal_pipe[1] != -1)
+        (void)!write(signal_pipe[1], "", 1);
+    errno = saved_errno;
+}
 
-    // Exit gracefully
-    _exit(EXIT_SUCCESS);
+/***********************************************************************************
+ * Function Name      : sighandler_init
+ * Inputs             : handler (EventHandler) - called from the loop on a signal
+ * Returns            : bool - true if SIGINT and SIGTERM are handled
+ * Description        : Creates the signal pipe, registers its read end with the
+ *                      event loop and installs sighandler.
+ ***********************************************************************************/
+bool sighandler_init(EventHandler handler) {
+    if (pipe2(signal_pipe, O_NONBLOCK | O_CLOEXEC) == -1)
+        return false;
+
+    signal_owner = getpid();
+    event_loop_add(signal_pipe[0], handler);
+    signal(SIGINT, sighandler);
+    signal(SIGTERM, sighandler);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : sighandler_take
+ * Inputs             : fd (int) - read end of the signal pipe
+ * Returns            : int - the signal received, 0 if none
+ * Description        : Drains the signal pipe.
+ ***********************************************************************************/
+int sighandler_take(int fd) {
+    char buf[16];
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+    return exit_signal;
 }
 
 /***********************************************************************************
@@ -145,10 +183,12 @@ void toast(const char* message) {
 /***********************************************************************************
  * Function Name      : is_kanged
  * Inputs             : None
- * Returns            : None
- * Description        : Checks if the module renamed/modified by 3rd party.
+ * Returns            : bool - true if the module was renamed/modified
+ * Description        : Checks if the module renamed/modified by 3rd party. A
+ *                      modified module is reported and the service marked
+ *                      stopped, exiting is left to the caller.
  ***********************************************************************************/
-void is_kanged(void) {
+bool is_kanged(void) {
     if (systemv("grep -q '^name=AZenith火$' %s", MODULE_PROP) != 0) [[clang::unlikely]] {
         goto doorprize;
     }
@@ -157,23 +197,24 @@ void is_kanged(void) {
         goto doorprize;
     }
 
-    return;
+    return false;
 
 doorprize:
     log_zenith(LOG_FATAL, "Module modified by 3rd party, exiting.");
     notify("Daemon Error", "Trying to rename me?", "false", 0);
     systemv("setprop persist.sys.azenith.service \"\"");
     systemv("setprop persist.sys.azenith.state stopped");
-    exit(EXIT_FAILURE);
+    return true;
 }
 
 /***********************************************************************************
  * Function Name      : check_module_version
  * Inputs             : None
- * Returns            : None
+ * Returns            : bool - true if the versions match
  * Description        : Compares version inside module.prop with daemon version.
+ *                      A mismatch is reported like is_kanged() does.
  ***********************************************************************************/
-void check_module_version(void) {
+bool check_module_version(void) {
     char DAEMON_VERSION[MAX_LINE] = {0};
     
     snprintf(DAEMON_VERSION, sizeof(DAEMON_VERSION), "%s", MODULE_VERSION);
@@ -190,8 +231,9 @@ void check_module_version(void) {
         notify("Daemon Error", "AZenith version mismatch, please reinstall!", "false", 0);
         systemv("setprop persist.sys.azenith.service \"\"");
         systemv("setprop persist.sys.azenith.state stopped");
-        exit(EXIT_FAILURE);
+        return false;
     }
+    return true;
 }
 
 /***********************************************************************************
@@ -202,10 +244,10 @@ void check_module_version(void) {
  ***********************************************************************************/
 void checkstate(void) {
     char state[64] = {0};
-    FILE* fp = popen("getprop persist.sys.azenith.state", "r");
+    FILE* fp = popen_deadline(CMD_TIMEOUT_MS, "getprop persist.sys.azenith.state");
     if (fp) {
         fgets(state, sizeof(state), fp);
-        pclose(fp);
+        fclose(fp);
     }
     state[strcspn(state, "\n")] = 0;
     if (state[0] == '\0' || strcmp(state, "stopped") == 0) [[clang::unlikely]] {
@@ -266,7 +308,7 @@ void runthermalcore(void) {
     __system_property_get("persist.sys.azenithconf.thermalcore", thermalcore);
     if (strcmp(thermalcore, "1") == 0) {
         systemv("sys.azenith-rianixiathermalcore &");
-        FILE* fp = popen("pidof sys.azenith-rianixiathermalcore", "r");
+        FILE* fp = popen_deadline(CMD_TIMEOUT_MS, "pidof sys.azenith-rianixiathermalcore");
         if (fp == NULL) {
             perror("pidof failed");
             log_zenith(LOG_INFO, "Failed to run Thermalcore service");
@@ -280,7 +322,7 @@ void runthermalcore(void) {
             log_zenith(LOG_INFO, "Thermalcore Service started but PID not found");
         }
 
-        pclose(fp);
+        fclose(fp);
     }
 }
 
@@ -288,27 +330,22 @@ void runthermalcore(void) {
  * Function Name      : runtask
  * Inputs             : none
  * Returns            : None
- * Description        : run a command periodically for every 12hours
+ * Description        : Maintenance job, the daemon timer calls it every
+ *                      TASK_INTERVAL_SEC starting with the first profile.
  ***********************************************************************************/
 void runtask(void) {
-    struct timespec now;
-
-    clock_gettime(CLOCK_MONOTONIC, &now);
-
-    if (last_task_run == 0) {
-        last_task_run = now.tv_sec;
+    if (!task_ran) {
+        task_ran = true;
         log_zenith(LOG_INFO, "Running scheduled task for the next 12h");
-        systemv("sys.azenith-utilityconf FSTrim");
+        // First run lands right after the first profile, keep it off the loop
+        systemv_idle(CMD_TIMEOUT_MS, "(sys.azenith-utilityconf FSTrim; sys.azenith-profilesettings maintenance) >/dev/null 2>&1 &");
         return;
     }
 
-    if ((now.tv_sec - last_task_run) >= TASK_INTERVAL_SEC) {
-        last_task_run = now.tv_sec;
-        log_zenith(LOG_INFO, "Executing scheduled task, next task will be run in next 12h");
-        notify("Daemon Info", "12 hours passed — AZenith doing its routine check. All good.", "false", 0);
-        
-        systemv("sys.azenith-utilityconf FSTrim");
-    }
+    log_zenith(LOG_INFO, "Executing scheduled task, next task will be run in next 12h");
+    notify("Daemon Info", "12 hours passed — AZenith doing its routine check. All good.", "false", 0);
+
+    systemv_idle(CMD_LONG_TIMEOUT_MS, "sys.azenith-utilityconf FSTrim");
 }
 
 char* skip_space(char* p) {
@@ -347,24 +384,3 @@ void extract_string_value(char* dest, const char* key_pos, size_t max_len) {
     strncpy(dest, start, len);
     dest[len] = '\0';
 }
-
-int get_current_refresh_rate(void) {
-    FILE *fp = popen(
-        "cmd display get-displays | "
-        "grep -oE \"renderFrameRate [0-9.]+\" | "
-        "awk '{print int($2+0.5)}'",
-        "r"
-    );
-
-    if (!fp)
-        return -1;
-
-    char buf[32] = {0};
-    if (!fgets(buf, sizeof(buf), fp)) {
-        pclose(fp);
-        return -1;
-    }
-
-    pclose(fp);
-    return atoi(buf);
-}
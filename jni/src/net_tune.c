@@ -0,0 +1,535 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <time.h>
+
+typedef struct {
+    const char* path; // relative to the filesystem root
+    const char* value;
+} NetKnob;
+
+typedef struct {
+    char path[MAX_PATH_LENGTH * 2];
+    char value[32];
+} SavedNetKnob;
+
+// busy_poll/busy_read only help NAPI drivers, everything else ignores them
+static const NetKnob net_knobs[] = {
+    {"/proc/sys/net/ipv4/tcp_low_latency", "1"},
+    {"/proc/sys/net/ipv4/tcp_fastopen", "3"},
+    {"/proc/sys/net/ipv4/tcp_ecn", "1"},
+    {"/proc/sys/net/core/busy_poll", "50"},
+    {"/proc/sys/net/core/busy_read", "50"},
+};
+
+// Wi-Fi, Qualcomm and MediaTek cellular, USB/ethernet tethering
+static const char* const net_ifaces[] = {"wlan", "rmnet_data", "ccmni", "eth"};
+
+static const char* const iptables[] = {"iptables", "ip6tables"};
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static bool with_loopback = false;
+static SavedNetKnob saved[MAX_NET_SAVED];
+static int nr_saved = 0;
+static bool chain_added = false;
+static bool wifi_low_latency = false;
+static bool wifi_iw = false;
+
+static bool read_line(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    bool ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        trim_newline(buf);
+    return ok;
+}
+
+static bool write_str(const char* path, const char* value) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    bool ok = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+    return ok;
+}
+
+static void save_and_write(const char* path, const char* value) {
+    char old[32] = {0};
+    if (!read_line(path, old, sizeof(old)) || strcmp(old, value) == 0)
+        return;
+
+    bool known = false;
+    for (int i = 0; i < nr_saved; i++)
+        known |= strcmp(saved[i].path, path) == 0;
+
+    if (!known && nr_saved < MAX_NET_SAVED) {
+        snprintf(saved[nr_saved].path, sizeof(saved[nr_saved].path), "%s", path);
+        snprintf(saved[nr_saved].value, sizeof(saved[nr_saved].value), "%s", old);
+        nr_saved++;
+    }
+
+    if (!write_str(path, value))
+        log_zenith(LOG_DEBUG, "Net tune: %s refused %s", path, value);
+}
+
+static bool is_net_iface(const char* name) {
+    if (with_loopback && strcmp(name, "lo") == 0)
+        return true;
+    for (size_t i = 0; i < sizeof(net_ifaces) / sizeof(net_ifaces[0]); i++) {
+        if (strncmp(name, net_ifaces[i], strlen(net_ifaces[i])) == 0)
+            return true;
+    }
+    return false;
+}
+
+// sysfs cpumasks take comma separated 32 bit groups
+static char* cpu_mask_to_hex(uint64_t mask, char* buf, size_t size) {
+    if (mask >> 32)
+        snprintf(buf, size, "%x,%08x", (unsigned)(mask >> 32), (unsigned)mask);
+    else
+        snprintf(buf, size, "%x", (unsigned)mask);
+    return buf;
+}
+
+/***********************************************************************************
+ * Function Name      : steer_queues
+ * Inputs             : mask (uint64_t) - cpus for packet processing
+ * Returns            : int - number of queues written
+ * Description        : Points RPS of every rx queue and XPS of every tx queue of
+ *                      the uplink interfaces at mask.
+ ***********************************************************************************/
+static int steer_queues(uint64_t mask) {
+    char path[MAX_PATH_LENGTH * 2];
+    char hex[24];
+    cpu_mask_to_hex(mask, hex, sizeof(hex));
+
+    snprintf(path, sizeof(path), "%s/sys/class/net", root_dir);
+    DIR* dir = opendir(path);
+    if (!dir)
+        return 0;
+
+    int written = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.' || !is_net_iface(entry->d_name))
+            continue;
+
+        char queues[MAX_PATH_LENGTH * 2];
+        snprintf(queues, sizeof(queues), "%s/sys/class/net/%s/queues", root_dir, entry->d_name);
+        DIR* qdir = opendir(queues);
+        struct dirent* q;
+        while (qdir && (q = readdir(qdir)) != NULL) {
+            const char* file = strncmp(q->d_name, "rx-", 3) == 0 ? "rps_cpus"
+                               : strncmp(q->d_name, "tx-", 3) == 0 ? "xps_cpus"
+                                                                   : NULL;
+            if (!file)
+                continue;
+
+            snprintf(path, sizeof(path), "%s/%s/%s", queues, q->d_name, file);
+            save_and_write(path, hex);
+            written++;
+        }
+        if (qdir)
+            closedir(qdir);
+    }
+    closedir(dir);
+    return written;
+}
+
+/***********************************************************************************
+ * Function Name      : mark_chain
+ * Inputs             : present (bool) - whether NET_CHAIN may exist
+ * Returns            : None
+ * Description        : Keeps NET_CHAIN_MARKER in step with the chain, so a new
+ *                      daemon knows without running iptables whether the last
+ *                      one left a chain behind.
+ ***********************************************************************************/
+static void mark_chain(bool present) {
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s%s", root_dir, NET_CHAIN_MARKER);
+    if (present) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+        if (fd != -1)
+            close(fd);
+    } else {
+        unlink(path);
+    }
+}
+
+static void drop_chain(void) {
+    for (size_t i = 0; i < sizeof(iptables) / sizeof(iptables[0]); i++) {
+        systemv("%s -w -t mangle -D OUTPUT -j %s >/dev/null 2>&1", iptables[i], NET_CHAIN);
+        systemv("%s -w -t mangle -F %s >/dev/null 2>&1", iptables[i], NET_CHAIN);
+        systemv("%s -w -t mangle -X %s >/dev/null 2>&1", iptables[i], NET_CHAIN);
+    }
+    mark_chain(false);
+}
+
+/***********************************************************************************
+ * Function Name      : mark_uid
+ * Inputs             : uid (int) - game uid
+ * Returns            : bool - true if at least one rule went in
+ * Description        : Marks everything the game sends as DSCP EF and sets its
+ *                      skb priority to 6, interactive. mac80211 maps both onto
+ *                      the voice/video WMM queues, qdiscs dequeue it first.
+ ***********************************************************************************/
+static bool mark_uid(int uid) {
+    bool any = false;
+    mark_chain(true);
+    for (size_t i = 0; i < sizeof(iptables) / sizeof(iptables[0]); i++) {
+        const char* ipt = iptables[i];
+        if (systemv("%s -w -t mangle -N %s >/dev/null 2>&1", ipt, NET_CHAIN) != 0)
+            continue;
+        chain_added = true;
+        if (systemv("%s -w -t mangle -I OUTPUT -j %s >/dev/null 2>&1", ipt, NET_CHAIN) != 0)
+            continue;
+
+        if (systemv("%s -w -t mangle -A %s -m owner --uid-owner %d -j DSCP --set-dscp-class EF >/dev/null 2>&1", ipt,
+                    NET_CHAIN, uid) == 0)
+            any = true;
+        else
+            log_zenith(LOG_DEBUG, "Net tune: %s has no DSCP target", ipt);
+
+        if (systemv("%s -w -t mangle -A %s -m owner --uid-owner %d -j CLASSIFY --set-class 0:6 >/dev/null 2>&1", ipt,
+                    NET_CHAIN, uid) == 0)
+            any = true;
+        else
+            log_zenith(LOG_DEBUG, "Net tune: %s has no CLASSIFY target", ipt);
+    }
+    return any;
+}
+
+/***********************************************************************************
+ * Function Name      : wifi_power_save_off
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Asks the Wi-Fi HAL for low latency mode, which turns off
+ *                      power save in the driver. Kernels driven through nl80211
+ *                      directly fall back to iw when it is installed.
+ ***********************************************************************************/
+static void wifi_power_save_off(void) {
+    wifi_low_latency = systemv("cmd wifi force-low-latency-mode enabled >/dev/null 2>&1") == 0;
+    if (wifi_low_latency)
+        return;
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/sys/class/net", root_dir);
+    DIR* dir = opendir(path);
+    struct dirent* entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "wlan", 4) == 0 &&
+            systemv("iw dev %s set power_save off >/dev/null 2>&1", entry->d_name) == 0)
+            wifi_iw = true;
+    }
+    if (dir)
+        closedir(dir);
+}
+
+static void wifi_power_save_restore(void) {
+    if (wifi_low_latency)
+        systemv("cmd wifi force-low-latency-mode disabled >/dev/null 2>&1");
+
+    if (wifi_iw) {
+        char path[MAX_PATH_LENGTH * 2];
+        snprintf(path, sizeof(path), "%s/sys/class/net", root_dir);
+        DIR* dir = opendir(path);
+        struct dirent* entry;
+        while (dir && (entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "wlan", 4) == 0)
+                systemv("iw dev %s set power_save on >/dev/null 2>&1", entry->d_name);
+        }
+        if (dir)
+            closedir(dir);
+    }
+    wifi_low_latency = false;
+    wifi_iw = false;
+}
+
+/***********************************************************************************
+ * Function Name      : net_tune_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ *                      loopback (bool) - --net-bench run, steer lo queues too
+ *                      and leave Wi-Fi alone
+ * Returns            : None
+ * Description        : Drops a netfilter chain a killed daemon left behind, only
+ *                      if NET_CHAIN_MARKER says there may be one.
+ ***********************************************************************************/
+void net_tune_init(const char* root, bool loopback) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+    with_loopback = loopback;
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s%s", root_dir, NET_CHAIN_MARKER);
+    if (access(path, F_OK) == 0) {
+        log_zenith(LOG_INFO, "Net tune: dropping the chain of a previous run");
+        drop_chain();
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : net_tune_restore
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Removes the game's netfilter marks, gives Wi-Fi power save
+ *                      back and writes every saved sysctl and queue mask back
+ *                      in reverse order.
+ ***********************************************************************************/
+void net_tune_restore(void) {
+    if (chain_added)
+        drop_chain();
+    chain_added = false;
+
+    wifi_power_save_restore();
+
+    for (int i = nr_saved - 1; i >= 0; i--)
+        write_str(saved[i].path, saved[i].value);
+    nr_saved = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : net_tune_apply
+ * Inputs             : uid (int) - game uid, negative skips the netfilter marks
+ *                      pid (pid_t) - game process, 0 if none
+ * Returns            : None
+ * Description        : Low latency network for one game session: latency
+ *                      sysctls, Wi-Fi power save off, DSCP and priority marks
+ *                      on the game's traffic and RPS/XPS on cpus the render
+ *                      threads do not use, preferably the little cluster.
+ *                      net_tune_restore() undoes all of it.
+ ***********************************************************************************/
+void net_tune_apply(int uid, pid_t pid) {
+    net_tune_restore();
+
+    char path[MAX_PATH_LENGTH * 2];
+    for (size_t i = 0; i < sizeof(net_knobs) / sizeof(net_knobs[0]); i++) {
+        snprintf(path, sizeof(path), "%s%s", root_dir, net_knobs[i].path);
+        save_and_write(path, net_knobs[i].value);
+    }
+
+    // Low latency mode is device wide, a network namespace does not fence it off
+    if (!with_loopback)
+        wifi_power_save_off();
+    bool marked = uid >= 0 && mark_uid(uid);
+
+    uint64_t online = 0;
+    for (int i = 0; i < nr_clusters; i++)
+        online |= clusters[i].cpu_mask;
+
+    uint64_t render = pid > 0 ? irq_render_cpus(pid) : 0;
+    if (!render && nr_clusters > 1)
+        render = clusters[nr_clusters - 1].cpu_mask;
+
+    uint64_t mask = nr_clusters > 0 ? clusters[0].cpu_mask & ~render : 0;
+    if (!mask)
+        mask = online & ~render;
+
+    int queues = mask ? steer_queues(mask) : 0;
+    char list[MAX_LINE] = "-";
+    if (mask)
+        cpu_mask_to_list(mask, list, sizeof(list));
+
+    log_zenith(LOG_INFO, "Net tune: low latency for uid %d, marks %s, wifi %s, %d queues on %s", uid,
+               marked ? "on" : "off", wifi_low_latency ? "hal" : wifi_iw ? "iw" : "untouched", queues, list);
+}
+
+typedef struct {
+    int fd;
+    volatile bool stop;
+} BenchSock;
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void* echo_thread(void* arg) {
+    BenchSock* s = arg;
+    char buf[64];
+    struct sockaddr_in from;
+    while (!s->stop) {
+        socklen_t len = sizeof(from);
+        ssize_t n = recvfrom(s->fd, buf, sizeof(buf), 0, (struct sockaddr*)&from, &len);
+        if (n > 0)
+            sendto(s->fd, buf, (size_t)n, 0, (struct sockaddr*)&from, len);
+    }
+    return NULL;
+}
+
+static void* bulk_send_thread(void* arg) {
+    BenchSock* s = arg;
+    static char buf[65536];
+    while (!s->stop && send(s->fd, buf, sizeof(buf), MSG_NOSIGNAL) > 0)
+        ;
+    return NULL;
+}
+
+static void* bulk_recv_thread(void* arg) {
+    BenchSock* s = arg;
+    static char buf[65536];
+    while (!s->stop && recv(s->fd, buf, sizeof(buf), 0) > 0)
+        ;
+    return NULL;
+}
+
+static int cmp_i64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int bench_socket(int type, struct sockaddr_in* addr) {
+    int fd = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        return -1;
+
+    struct timeval tv = {.tv_sec = 0, .tv_usec = 200000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    socklen_t len = sizeof(*addr);
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr*)addr, sizeof(*addr)) == -1 || getsockname(fd, (struct sockaddr*)addr, &len) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/***********************************************************************************
+ * Function Name      : handle_net_bench
+ * Inputs             : argc - number of CLI arguments
+ *                      argv - array of CLI argument strings
+ * Returns            : int - 0 on success, 1 if loopback is unusable
+ * Description        : Loopback traffic generator. A TCP stream saturates lo
+ *                      while N small UDP pings go to an echo thread 1ms apart,
+ *                      then RTT percentiles and jitter (mean difference of
+ *                      consecutive RTTs) are printed. "tuned" applies the low
+ *                      latency network settings for the caller's uid first and
+ *                      restores them afterwards, Wi-Fi power save excepted.
+ *                      Run inside "unshare -n" with lo up to compare both
+ *                      without touching the host stack.
+ ***********************************************************************************/
+int handle_net_bench(int argc, char** argv) {
+    int count = argc > 2 ? atoi(argv[2]) : 2000;
+    if (count <= 0)
+        count = 2000;
+    bool tuned = argc > 3 && strcmp(argv[3], "tuned") == 0;
+
+    if (tuned) {
+        cpu_topology_init();
+        net_tune_init(NULL, true);
+        net_tune_apply((int)getuid(), 0);
+    }
+
+    struct sockaddr_in echo_addr, ping_addr, sink_addr, src_addr;
+    BenchSock echo = {bench_socket(SOCK_DGRAM, &echo_addr), false};
+    int ping = bench_socket(SOCK_DGRAM, &ping_addr);
+    int listener = bench_socket(SOCK_STREAM, &sink_addr);
+    BenchSock sink = {-1, false};
+    BenchSock src = {bench_socket(SOCK_STREAM, &src_addr), false};
+
+    if (echo.fd == -1 || ping == -1 || listener == -1 || src.fd == -1 || listen(listener, 1) == -1 ||
+        connect(src.fd, (struct sockaddr*)&sink_addr, sizeof(sink_addr)) == -1 ||
+        (sink.fd = accept4(listener, NULL, NULL, SOCK_CLOEXEC)) == -1 ||
+        connect(ping, (struct sockaddr*)&echo_addr, sizeof(echo_addr)) == -1) {
+        fprintf(stderr, "\033[31mERROR:\033[0m Unable to set up loopback sockets, is lo up?\n");
+        if (tuned)
+            net_tune_restore();
+        return 1;
+    }
+
+    pthread_t echo_tid, send_tid, recv_tid;
+    pthread_create(&echo_tid, NULL, echo_thread, &echo);
+    pthread_create(&recv_tid, NULL, bulk_recv_thread, &sink);
+    pthread_create(&send_tid, NULL, bulk_send_thread, &src);
+
+    int64_t* rtt = calloc((size_t)count, sizeof(int64_t));
+    int got = 0;
+    int lost = 0;
+    for (int seq = 0; rtt && seq < count; seq++) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%d", seq);
+        int64_t start = now_us();
+        send(ping, buf, sizeof(buf), 0);
+
+        // A late echo of an earlier ping is not this one
+        char reply[32];
+        bool ok = false;
+        while (recv(ping, reply, sizeof(reply), 0) > 0) {
+            if (atoi(reply) == seq) {
+                ok = true;
+                break;
+            }
+        }
+        if (ok)
+            rtt[got++] = now_us() - start;
+        else
+            lost++;
+
+        nanosleep(&(struct timespec){.tv_sec = 0, .tv_nsec = 1000000}, NULL);
+    }
+
+    echo.stop = sink.stop = src.stop = true;
+    shutdown(src.fd, SHUT_RDWR);
+    shutdown(sink.fd, SHUT_RDWR);
+    pthread_join(send_tid, NULL);
+    pthread_join(recv_tid, NULL);
+    pthread_join(echo_tid, NULL);
+    close(echo.fd);
+    close(ping);
+    close(listener);
+    close(sink.fd);
+    close(src.fd);
+
+    if (tuned)
+        net_tune_restore();
+
+    if (got < 2) {
+        fprintf(stderr, "\033[31mERROR:\033[0m %d of %d pings answered\n", got, count);
+        free(rtt);
+        return 1;
+    }
+
+    double jitter = 0;
+    for (int i = 1; i < got; i++)
+        jitter += (double)llabs(rtt[i] - rtt[i - 1]);
+    jitter /= got - 1;
+
+    double mean = 0;
+    for (int i = 0; i < got; i++)
+        mean += (double)rtt[i];
+    mean /= got;
+
+    qsort(rtt, (size_t)got, sizeof(int64_t), cmp_i64);
+    printf("Network: %s, %d pings, %d lost\n", tuned ? "tuned" : "stock", count, lost);
+    printf("RTT us: mean %.1f, p50 %lld, p99 %lld, max %lld\n", mean, (long long)rtt[got / 2],
+           (long long)rtt[got * 99 / 100], (long long)rtt[got - 1]);
+    printf("Jitter us: %.1f\n", jitter);
+    free(rtt);
+    return 0;
+}
@@ -28,7 +28,7 @@ pid_t pidof(const char* name) {
     if (!name || !name[0])
         return 0;
 
-    FILE* fp = popen("dumpsys activity activities", "r");
+    FILE* fp = popen_deadline(CMD_TIMEOUT_MS, "dumpsys activity activities");
     if (!fp)
         return 0;
 
@@ -64,7 +64,7 @@ pid_t pidof(const char* name) {
         }
     }
 
-    pclose(fp);
+    fclose(fp);
     return pid;
 }
 
@@ -0,0 +1,451 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Trace replay for the profile state machine.
+ *
+ * A trace is a text file of "<time_ms> <event> [args]" lines, '#' starts a
+ * comment. Events:
+ *
+ *   <t> visible <pkg|->       foreground gamelist package, '-' for none
+ *   <t> start <proc> <pid>    process appears
+ *   <t> kill <proc>           process disappears
+ *   <t> screen <on|off>
+ *   <t> lowpower <on|off>
+ *   <t> prop <name> <value>
+ *   <t> load <idle|interactive|heavy>   output of the load classifier
+ *   <t> gameproc <pkg> <pattern>        game_process of a gamelist entry
+ *   cost <call> <ms>          simulated cost of an env call
+ *
+ * Cost calls: gamestart, pidof, pid_alive, screen, lowpower, getprop.
+ * Game processes resolve like game_procs_track(), built-in entries included.
+ */
+
+#include <AZenith.h>
+
+typedef struct {
+    int64_t t;
+    char event[16];
+    char arg1[MAX_PACKAGE];
+    char arg2[PROP_VALUE_MAX];
+} SimEvent;
+
+typedef struct {
+    char name[MAX_PACKAGE];
+    pid_t pid;
+} SimProc;
+
+typedef struct {
+    char name[MAX_PACKAGE];
+    char value[PROP_VALUE_MAX];
+} SimProp;
+
+typedef enum : char {
+    COST_GAMESTART,
+    COST_PIDOF,
+    COST_PID_ALIVE,
+    COST_SCREEN,
+    COST_LOWPOWER,
+    COST_GETPROP,
+    COST_COUNT
+} SimCost;
+
+static const char* const cost_names[COST_COUNT] = {"gamestart", "pidof", "pid_alive", "screen", "lowpower", "getprop"};
+
+// Rough on-device figures, dumpsys backed calls dominate
+static int cost_ms[COST_COUNT] = {45, 6, 0, 35, 30, 0};
+static uint64_t cost_calls[COST_COUNT];
+static int64_t cost_total[COST_COUNT];
+
+static int64_t sim_now = 0;
+static char sim_visible[MAX_PACKAGE];
+static char sim_game_pkg[MAX_PACKAGE];
+static char sim_game_process[MAX_PACKAGE];
+static bool sim_screen = true;
+static bool sim_lowpower = false;
+static LoadClass sim_load = LOAD_INTERACTIVE;
+static SimProc procs[MAX_SIM_PROCS];
+static int nr_procs = 0;
+static SimProp props[MAX_SIM_PROPS];
+static int nr_props = 0;
+
+static void charge(SimCost c) {
+    cost_calls[c]++;
+    cost_total[c] += cost_ms[c];
+}
+
+static SimProc* find_proc(const char* name) {
+    for (int i = 0; i < nr_procs; i++) {
+        if (strcmp(procs[i].name, name) == 0)
+            return &procs[i];
+    }
+    return NULL;
+}
+
+static void set_prop(const char* name, const char* value) {
+    for (int i = 0; i < nr_props; i++) {
+        if (strcmp(props[i].name, name) == 0) {
+            snprintf(props[i].value, sizeof(props[i].value), "%s", value);
+            return;
+        }
+    }
+    if (nr_props < MAX_SIM_PROPS) {
+        snprintf(props[nr_props].name, sizeof(props[nr_props].name), "%s", name);
+        snprintf(props[nr_props].value, sizeof(props[nr_props].value), "%s", value);
+        nr_props++;
+    }
+}
+
+static char* sim_get_gamestart(GameOptions* options) {
+    charge(COST_GAMESTART);
+    if (options) {
+        memset(options, 0, sizeof(*options));
+        if (sim_visible[0] && strcmp(sim_visible, sim_game_pkg) == 0)
+            snprintf(options->game_process, sizeof(options->game_process), "%s", sim_game_process);
+    }
+    return sim_visible[0] ? strdup(sim_visible) : NULL;
+}
+
+static pid_t sim_pidof(const char* name) {
+    charge(COST_PIDOF);
+    SimProc* p = find_proc(name);
+    return p ? p->pid : 0;
+}
+
+static bool sim_pid_alive(pid_t pid) {
+    charge(COST_PID_ALIVE);
+    for (int i = 0; i < nr_procs; i++) {
+        if (procs[i].pid == pid)
+            return true;
+    }
+    return false;
+}
+
+static GameProcState sim_game_state(const char* gamestart, const GameOptions* opts, pid_t* pid) {
+    *pid = 0;
+    const char* pattern = game_proc_pattern(gamestart, opts);
+    if (!pattern)
+        return GAME_NOT_TRACKED;
+
+    // Same price as a pidof, both walk the process list once
+    charge(COST_PIDOF);
+    for (int i = 0; i < nr_procs; i++) {
+        if (game_proc_match(gamestart, pattern, procs[i].name)) {
+            *pid = procs[i].pid;
+            return GAME_RUNNING;
+        }
+    }
+    return GAME_RUN_BG;
+}
+
+static bool sim_screen_on(void) {
+    charge(COST_SCREEN);
+    return sim_screen;
+}
+
+static bool sim_low_power(void) {
+    charge(COST_LOWPOWER);
+    return sim_lowpower;
+}
+
+static int sim_getprop(const char* name, char* value) {
+    charge(COST_GETPROP);
+    for (int i = 0; i < nr_props; i++) {
+        if (strcmp(props[i].name, name) == 0) {
+            strcpy(value, props[i].value);
+            return (int)strlen(value);
+        }
+    }
+    value[0] = '\0';
+    return 0;
+}
+
+static int64_t sim_clock_ms(void) {
+    return sim_now;
+}
+
+static LoadClass sim_load_class(void) {
+    return sim_load;
+}
+
+static const ProfileEnv sim_env = {
+    .get_gamestart = sim_get_gamestart,
+    .pidof = sim_pidof,
+    .pid_alive = sim_pid_alive,
+    .game_state = sim_game_state,
+    .screen_on = sim_screen_on,
+    .low_power = sim_low_power,
+    .getprop = sim_getprop,
+    .clock_ms = sim_clock_ms,
+    .load_class = sim_load_class,
+};
+
+static void apply_event(const SimEvent* e) {
+    if (strcmp(e->event, "visible") == 0) {
+        snprintf(sim_visible, sizeof(sim_visible), "%s", strcmp(e->arg1, "-") == 0 ? "" : e->arg1);
+    } else if (strcmp(e->event, "start") == 0) {
+        SimProc* p = find_proc(e->arg1);
+        if (!p && nr_procs < MAX_SIM_PROCS)
+            p = &procs[nr_procs++];
+        if (p) {
+            snprintf(p->name, sizeof(p->name), "%s", e->arg1);
+            p->pid = atoi(e->arg2);
+        }
+    } else if (strcmp(e->event, "kill") == 0) {
+        SimProc* p = find_proc(e->arg1);
+        if (p)
+            *p = procs[--nr_procs];
+    } else if (strcmp(e->event, "screen") == 0) {
+        sim_screen = strcmp(e->arg1, "on") == 0;
+    } else if (strcmp(e->event, "lowpower") == 0) {
+        sim_lowpower = strcmp(e->arg1, "on") == 0;
+    } else if (strcmp(e->event, "prop") == 0) {
+        set_prop(e->arg1, e->arg2);
+    } else if (strcmp(e->event, "load") == 0) {
+        sim_load = strcmp(e->arg1, "heavy") == 0 ? LOAD_HEAVY : strcmp(e->arg1, "idle") == 0 ? LOAD_IDLE : LOAD_INTERACTIVE;
+    } else if (strcmp(e->event, "gameproc") == 0) {
+        snprintf(sim_game_pkg, sizeof(sim_game_pkg), "%s", e->arg1);
+        snprintf(sim_game_process, sizeof(sim_game_process), "%s", e->arg2);
+    }
+}
+
+static const char* mode_name(ProfileMode mode) {
+    switch (mode) {
+    case PERFORMANCE_PROFILE:
+        return "PERFORMANCE";
+    case BALANCED_PROFILE:
+        return "BALANCED";
+    case ECO_MODE:
+        return "ECO";
+    default:
+        return "PERFCOMMON";
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : flush_apply
+ * Inputs             : line (char *) - held back apply line, emptied
+ * Returns            : None
+ * Description        : Prints an apply whose outcome is settled.
+ ***********************************************************************************/
+static void flush_apply(char* line) {
+    if (line[0]) {
+        printf("%s\n", line);
+        line[0] = '\0';
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : load_trace
+ * Inputs             : path (const char *) - trace file
+ *                      count (int *) - receives the number of events
+ * Returns            : SimEvent* - events sorted by time, NULL on error
+ * Description        : Parses a trace, cost lines are applied immediately.
+ * Note               : Caller is responsible for freeing the returned array.
+ ***********************************************************************************/
+static SimEvent* load_trace(const char* path, int* count) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "\033[31mERROR:\033[0m Unable to open trace %s\n", path);
+        return NULL;
+    }
+
+    int cap = 64;
+    SimEvent* events = malloc(sizeof(SimEvent) * cap);
+    char line[MAX_LINE];
+    int n = 0;
+    int lineno = 0;
+
+    while (events && fgets(line, sizeof(line), fp)) {
+        lineno++;
+        char* hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+
+        char a[32] = {0};
+        char b[16] = {0};
+        char c[MAX_PACKAGE] = {0};
+        char d[PROP_VALUE_MAX] = {0};
+        int fields = sscanf(line, "%31s %15s %127s %91s", a, b, c, d);
+        if (fields <= 0)
+            continue;
+
+        if (strcmp(a, "cost") == 0) {
+            for (int i = 0; i < COST_COUNT; i++) {
+                if (fields == 3 && strcmp(b, cost_names[i]) == 0)
+                    cost_ms[i] = atoi(c);
+            }
+            continue;
+        }
+
+        if (fields < 3 || !isdigit((unsigned char)a[0])) {
+            fprintf(stderr, "\033[31mERROR:\033[0m %s:%d: malformed event\n", path, lineno);
+            free(events);
+            events = NULL;
+            break;
+        }
+
+        if (n == cap) {
+            cap *= 2;
+            SimEvent* grown = realloc(events, sizeof(SimEvent) * cap);
+            if (!grown) {
+                free(events);
+                events = NULL;
+                break;
+            }
+            events = grown;
+        }
+
+        SimEvent* e = &events[n++];
+        e->t = atoll(a);
+        snprintf(e->event, sizeof(e->event), "%s", b);
+        snprintf(e->arg1, sizeof(e->arg1), "%s", c);
+        snprintf(e->arg2, sizeof(e->arg2), "%s", d);
+
+        // Keep the list ordered, traces are almost always sorted already
+        for (int i = n - 1; i > 0 && events[i - 1].t > events[i].t; i--) {
+            SimEvent tmp = events[i];
+            events[i] = events[i - 1];
+            events[i - 1] = tmp;
+        }
+    }
+
+    fclose(fp);
+    *count = n;
+    return events;
+}
+
+/***********************************************************************************
+ * Function Name      : handle_simulate
+ * Inputs             : argc - number of CLI arguments
+ *                      argv - array of CLI argument strings
+ * Returns            : int - 0 on success, 1 on error
+ * Description        : Drives the profile state machine from a recorded trace on
+ *                      a simulated clock and reports transitions, wasted profile
+ *                      applies and the env cost of the loop. An apply is counted
+ *                      as wasted when it re-applies the active profile, or
+ *                      when the next apply replaces it before any trace event
+ *                      changed the device state in between. An apply line is
+ *                      held back until that is known.
+ ***********************************************************************************/
+int handle_simulate(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: sys.azenith-service --simulate <trace>\n");
+        return 1;
+    }
+
+    int nr_events = 0;
+    SimEvent* events = load_trace(argv[2], &nr_events);
+    if (!events)
+        return 1;
+
+    set_prop("persist.sys.azenithconf.AIenabled", "1");
+
+    int64_t end = (nr_events ? events[nr_events - 1].t : 0) + 5000;
+    int next = 0;
+    uint64_t steps = 0;
+    uint64_t applies = 0;
+    uint64_t wasted = 0;
+    char pending[MAX_LINE * 2] = "";
+    int pending_events = 0;
+    int64_t mode_time[4] = {0};
+
+    ProfileState ps;
+    profile_state_init(&ps, &sim_env);
+    ProfileMode applied = PERFCOMMON;
+    int64_t mode_start = 0;
+
+    while (sim_now <= end) {
+        // The daemon sleeps first and then decides
+        sim_now += ps.cur_mode == PERFORMANCE_PROFILE ? LOOP_INTERVAL_MS : LOOP_INTERVAL_SEC * 1000;
+        while (next < nr_events && events[next].t <= sim_now)
+            apply_event(&events[next++]);
+        if (next != pending_events)
+            flush_apply(pending);
+
+        int64_t before = 0;
+        for (int i = 0; i < COST_COUNT; i++)
+            before += cost_total[i];
+
+        ProfileMode prev = ps.cur_mode;
+        profile_state_step(&ps, &sim_env);
+        steps++;
+
+        for (int i = 0; i < ps.nr_actions; i++) {
+            ProfileAction a = ps.actions[i];
+            if (a == ACTION_GAME_EXITED || a == ACTION_PID_LOST) {
+                flush_apply(pending);
+                printf("[%8.1fs] %s %s\n", sim_now / 1000.0, a == ACTION_GAME_EXITED ? "exited  " : "pid lost", ps.last_game);
+                continue;
+            }
+            if (a == ACTION_INITIALIZED)
+                continue;
+
+            ProfileMode to = (a == ACTION_APPLY_PERFORMANCE || a == ACTION_LOAD_PERFORMANCE) ? PERFORMANCE_PROFILE
+                             : (a == ACTION_APPLY_ECO || a == ACTION_LOAD_ECO)                ? ECO_MODE
+                                                                                              : BALANCED_PROFILE;
+            bool is_waste = to == applied;
+            applies++;
+            wasted += is_waste;
+
+            // Nothing happened since the previous apply, it only flapped
+            if (pending[0]) {
+                strcat(pending, " (wasted)");
+                wasted++;
+                flush_apply(pending);
+            }
+
+            mode_time[applied] += sim_now - mode_start;
+            mode_start = sim_now;
+            const char* why = (a == ACTION_LOAD_PERFORMANCE || a == ACTION_LOAD_ECO) ? "(load)" : a == ACTION_APPLY_PERFORMANCE ? ps.gamestart : "";
+            snprintf(pending, sizeof(pending) - sizeof(" (wasted)"), "[%8.1fs] %-11s -> %-11s %s", sim_now / 1000.0,
+                     mode_name(prev), mode_name(to), why);
+            pending_events = next;
+            if (is_waste) {
+                strcat(pending, " (wasted)");
+                flush_apply(pending);
+            }
+            applied = to;
+            prev = to;
+        }
+
+        int64_t spent = -before;
+        for (int i = 0; i < COST_COUNT; i++)
+            spent += cost_total[i];
+        sim_now += spent;
+    }
+    mode_time[applied] += sim_now - mode_start;
+    flush_apply(pending);
+
+    int64_t total = 0;
+    for (int i = 0; i < COST_COUNT; i++)
+        total += cost_total[i];
+
+    printf("\nSimulated %.1fs, %llu loops (%.1f wakeups/min)\n", sim_now / 1000.0, (unsigned long long)steps,
+           sim_now ? steps * 60000.0 / sim_now : 0.0);
+    printf("Profile applies: %llu, wasted: %llu\n", (unsigned long long)applies, (unsigned long long)wasted);
+    printf("Time in profile: performance %.1fs, balanced %.1fs, eco %.1fs\n", mode_time[PERFORMANCE_PROFILE] / 1000.0,
+           mode_time[BALANCED_PROFILE] / 1000.0, mode_time[ECO_MODE] / 1000.0);
+    printf("Loop cost: %lldms total, %.2fms per loop\n", (long long)total, steps ? (double)total / steps : 0.0);
+    for (int i = 0; i < COST_COUNT; i++) {
+        if (cost_calls[i])
+            printf("  %-10s %6llu calls %8lldms\n", cost_names[i], (unsigned long long)cost_calls[i], (long long)cost_total[i]);
+    }
+
+    free(ps.gamestart);
+    free(events);
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+static bool pid_alive_normal(pid_t pid) {
+    return kill(pid, 0) == 0;
+}
+
+static GameProcState game_state_normal(const char* gamestart, const GameOptions* opts, pid_t* pid) {
+    GameProcState state = game_procs_track(gamestart, opts);
+    *pid = game_procs.main;
+    return state;
+}
+
+// get_screenstate and get_low_power_state get swapped at runtime, resolve per call
+static bool screen_on_normal(void) {
+    return get_screenstate();
+}
+
+static bool low_power_normal(void) {
+    return get_low_power_state();
+}
+
+const ProfileEnv profile_env_default = {
+    .get_gamestart = get_gamestart,
+    .pidof = pidof,
+    .pid_alive = pid_alive_normal,
+    .game_state = game_state_normal,
+    .screen_on = screen_on_normal,
+    .low_power = low_power_normal,
+    .getprop = __system_property_get,
+    .clock_ms = now_ms,
+    .load_class = load_sampler_class,
+};
+
+static void push_action(ProfileState* s, ProfileAction action) {
+    if (s->nr_actions < MAX_PROFILE_ACTIONS)
+        s->actions[s->nr_actions++] = action;
+}
+
+static void switch_mode(ProfileState* s, const ProfileEnv* env, ProfileMode mode, ProfileAction action) {
+    s->cur_mode = mode;
+    s->need_profile_checkup = false;
+    s->load_boosted = action == ACTION_LOAD_PERFORMANCE;
+    s->mode_since = env->clock_ms();
+    push_action(s, action);
+}
+
+static void drop_game(ProfileState* s) {
+    snprintf(s->last_game, sizeof(s->last_game), "%s", s->gamestart);
+    free(s->gamestart);
+    s->gamestart = NULL;
+}
+
+/***********************************************************************************
+ * Function Name      : profile_state_init
+ * Inputs             : s (ProfileState *) - state to reset
+ *                      env (const ProfileEnv *) - environment to read from
+ * Returns            : None
+ * Description        : Puts the state machine in its boot state, PERFCOMMON and
+ *                      not initialized until the first balanced apply.
+ ***********************************************************************************/
+void profile_state_init(ProfileState* s, const ProfileEnv* env) {
+    memset(s, 0, sizeof(*s));
+    s->cur_mode = PERFCOMMON;
+    strcpy(s->prev_ai_state, "0");
+    env->getprop("persist.sys.azenithconf.AIenabled", s->prev_ai_state);
+    s->mode_since = env->clock_ms();
+}
+
+/***********************************************************************************
+ * Function Name      : profile_state_step
+ * Inputs             : s (ProfileState *) - current state
+ *                      env (const ProfileEnv *) - environment to read from
+ * Returns            : None
+ * Description        : One iteration of the profile decision logic. Only reads
+ *                      the outside world through env and leaves what has to be
+ *                      done in s->actions, the caller performs the side effects.
+ * Note               : The order of env calls matches the old main loop, the
+ *                      expensive dumpsys backed ones are short-circuited the
+ *                      same way.
+ ***********************************************************************************/
+void profile_state_step(ProfileState* s, const ProfileEnv* env) {
+    s->nr_actions = 0;
+
+    char ai_state[PROP_VALUE_MAX] = {0};
+    env->getprop("persist.sys.azenithconf.AIenabled", ai_state);
+    if (s->initialized) {
+        bool disabled = strcmp(s->prev_ai_state, "1") == 0 && strcmp(ai_state, "0") == 0;
+        bool enabled = strcmp(s->prev_ai_state, "0") == 0 && strcmp(ai_state, "1") == 0;
+        if (disabled || enabled) {
+            s->cur_mode = BALANCED_PROFILE;
+            s->load_boosted = false;
+            s->mode_since = env->clock_ms();
+            push_action(s, ACTION_AI_TOGGLED);
+        }
+        strcpy(s->prev_ai_state, ai_state);
+
+        // Dynamic profile is off, leave profiles to the user
+        if (strcmp(ai_state, "0") == 0)
+            return;
+    }
+
+    // Only fetch gamestart when user not in-game
+    // prevent overhead from dumpsys commands.
+    if (!s->gamestart) {
+        s->gamestart = env->get_gamestart(&s->opts);
+    } else if (s->game_pid != 0 && !env->pid_alive(s->game_pid)) [[clang::unlikely]] {
+        push_action(s, ACTION_GAME_EXITED);
+        s->game_pid = 0;
+        drop_game(s);
+        s->gamestart = env->get_gamestart(&s->opts);
+        // Force profile recheck to make sure new game session get boosted
+        s->need_profile_checkup = true;
+    }
+
+    GameProcState game = GAME_NOT_TRACKED;
+    pid_t main_pid = 0;
+    if (s->gamestart)
+        game = env->game_state(s->gamestart, &s->opts, &main_pid);
+
+    if (s->initialized && s->gamestart && env->screen_on() && game != GAME_RUN_BG) {
+        if (!s->need_profile_checkup && s->cur_mode == PERFORMANCE_PROFILE && !s->load_boosted)
+            return;
+
+        // Get PID and check if the game is "real" running program
+        s->game_pid = (game == GAME_RUNNING) ? main_pid : env->pidof(s->gamestart);
+        if (s->game_pid == 0) [[clang::unlikely]] {
+            push_action(s, ACTION_PID_LOST);
+            drop_game(s);
+            return;
+        }
+
+        switch_mode(s, env, PERFORMANCE_PROFILE, ACTION_APPLY_PERFORMANCE);
+    } else if (s->initialized && env->low_power()) {
+        if (s->cur_mode == ECO_MODE)
+            return;
+
+        switch_mode(s, env, ECO_MODE, ACTION_APPLY_ECO);
+    } else {
+        char load_aware[PROP_VALUE_MAX] = {0};
+        env->getprop("persist.sys.azenithconf.loadaware", load_aware);
+        LoadClass load = (s->initialized && strcmp(load_aware, "1") == 0) ? env->load_class() : LOAD_INTERACTIVE;
+
+        if (load == LOAD_HEAVY) {
+            if (s->cur_mode == PERFORMANCE_PROFILE && s->load_boosted)
+                return;
+
+            switch_mode(s, env, PERFORMANCE_PROFILE, ACTION_LOAD_PERFORMANCE);
+            return;
+        }
+
+        if (load == LOAD_IDLE) {
+            if (s->cur_mode == ECO_MODE)
+                return;
+
+            switch_mode(s, env, ECO_MODE, ACTION_LOAD_ECO);
+            return;
+        }
+
+        if (s->cur_mode == BALANCED_PROFILE)
+            return;
+
+        if (!s->initialized) {
+            s->initialized = true;
+            push_action(s, ACTION_INITIALIZED);
+        }
+        switch_mode(s, env, BALANCED_PROFILE, ACTION_APPLY_BALANCED);
+    }
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <sys/mman.h>
+
+typedef struct {
+    uint8_t* map;
+    size_t size;
+    size_t nr_chunks;
+    uint8_t* score; // samples each chunk was fully resident, saturating
+    uint8_t* locked;
+    bool is_lib;
+} GuardFile;
+
+static GuardFile files[MAX_GUARD_FILES];
+static int nr_files = 0;
+static size_t page_size = 4096;
+static int64_t last_sample = 0;
+static int samples = 0;
+static size_t locked_bytes = 0;
+static size_t lock_budget = 0;
+static bool lock_done = false;
+
+static void add_file(const char* path, off_t size) {
+    if (nr_files >= MAX_GUARD_FILES || size <= 0)
+        return;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return;
+
+    // The mapping shares page cache with the game, it never faults anything in by itself
+    void* map = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return;
+
+    size_t chunk = page_size * RESIDENCY_CHUNK_PAGES;
+    GuardFile* f = &files[nr_files];
+    f->map = map;
+    f->size = (size_t)size;
+    f->nr_chunks = (f->size + chunk - 1) / chunk;
+    f->score = calloc(f->nr_chunks, 1);
+    f->locked = calloc(f->nr_chunks, 1);
+    f->is_lib = strstr(path, ".so") != NULL;
+    if (!f->score || !f->locked) {
+        free(f->score);
+        free(f->locked);
+        munmap(map, f->size);
+        return;
+    }
+    nr_files++;
+}
+
+static int collect_file(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)ftw;
+    if (type == FTW_F && S_ISREG(st->st_mode))
+        add_file(path, st->st_size);
+    return nr_files >= MAX_GUARD_FILES ? 1 : 0;
+}
+
+static size_t parse_size(const char* value) {
+    char* end;
+    double n = strtod(value, &end);
+    switch (toupper((unsigned char)*end)) {
+    case 'G':
+        n *= 1024;
+        [[fallthrough]];
+    case 'M':
+        n *= 1024;
+        [[fallthrough]];
+    case 'K':
+        n *= 1024;
+        break;
+    }
+    return n > 0 ? (size_t)n : 0;
+}
+
+/***********************************************************************************
+ * Function Name      : residency_guard_start
+ * Inputs             : dir (const char *) - directory GamePreload warmed
+ * Returns            : int - number of files being guarded
+ * Description        : Maps every file GamePreload touched, libraries first,
+ *                      so their page cache residency can be sampled during the
+ *                      session. persist.sys.azenithconf.preloadlock sets an
+ *                      optional mlock budget (e.g. 64M, unset or 0 disables).
+ ***********************************************************************************/
+int residency_guard_start(const char* dir) {
+    residency_guard_stop();
+
+    long ps = sysconf(_SC_PAGESIZE);
+    if (ps > 0)
+        page_size = (size_t)ps;
+
+    nftw(dir, collect_file, 8, FTW_PHYS);
+
+    // Libraries go first, they get the rewarm and lock budget before anything else
+    for (int i = 0, j = 0; i < nr_files; i++) {
+        if (files[i].is_lib) {
+            GuardFile tmp = files[j];
+            files[j++] = files[i];
+            files[i] = tmp;
+        }
+    }
+
+    char lock[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.preloadlock", lock);
+    lock_budget = parse_size(lock);
+
+    samples = 0;
+    locked_bytes = 0;
+    lock_done = false;
+    last_sample = now_ms();
+    log_preload(LOG_INFO, "Residency guard: watching %d files in %s, lock budget %zuKB", nr_files, dir,
+                lock_budget / 1024);
+    return nr_files;
+}
+
+/***********************************************************************************
+ * Function Name      : residency_guard_stop
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Unlocks and unmaps everything at the end of a session.
+ ***********************************************************************************/
+void residency_guard_stop(void) {
+    for (int i = 0; i < nr_files; i++) {
+        munlock(files[i].map, files[i].size);
+        munmap(files[i].map, files[i].size);
+        free(files[i].score);
+        free(files[i].locked);
+    }
+    nr_files = 0;
+    locked_bytes = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : lock_hottest
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Pins library chunks once per session, highest score first,
+ *                      until the lock budget is used. A chunk that stayed
+ *                      resident through every sample so far survived reclaim
+ *                      because the game keeps using it.
+ ***********************************************************************************/
+static void lock_hottest(void) {
+    size_t chunk = page_size * RESIDENCY_CHUNK_PAGES;
+    lock_done = true;
+
+    for (int want = samples < UINT8_MAX ? samples : UINT8_MAX; want > 0 && locked_bytes < lock_budget; want--) {
+        for (int i = 0; i < nr_files && files[i].is_lib && locked_bytes < lock_budget; i++) {
+            GuardFile* f = &files[i];
+            for (size_t c = 0; c < f->nr_chunks && locked_bytes < lock_budget; c++) {
+                if (f->locked[c] || f->score[c] != want)
+                    continue;
+
+                size_t off = c * chunk;
+                size_t len = off + chunk > f->size ? f->size - off : chunk;
+                if (mlock(f->map + off, len) == 0) {
+                    f->locked[c] = 1;
+                    locked_bytes += len;
+                }
+            }
+        }
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : residency_guard_tick
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Every RESIDENCY_INTERVAL_MS samples mincore() over the
+ *                      preloaded files. Chunks that were fully resident before
+ *                      and lost pages since get MADV_WILLNEED, up to
+ *                      RESIDENCY_REWARM_KB per sample. The residency ratio goes
+ *                      to the preload log.
+ ***********************************************************************************/
+void residency_guard_tick(void) {
+    if (nr_files == 0)
+        return;
+
+    int64_t now = now_ms();
+    if (now - last_sample < RESIDENCY_INTERVAL_MS)
+        return;
+    last_sample = now;
+    samples++;
+
+    size_t chunk = page_size * RESIDENCY_CHUNK_PAGES;
+    size_t budget = (size_t)RESIDENCY_REWARM_KB * 1024;
+    size_t total = 0;
+    size_t resident = 0;
+    size_t rewarmed = 0;
+    unsigned char vec[RESIDENCY_CHUNK_PAGES];
+
+    for (int i = 0; i < nr_files; i++) {
+        GuardFile* f = &files[i];
+        for (size_t c = 0; c < f->nr_chunks; c++) {
+            size_t off = c * chunk;
+            size_t len = off + chunk > f->size ? f->size - off : chunk;
+            size_t pages = (len + page_size - 1) / page_size;
+            if (mincore(f->map + off, len, vec) != 0)
+                continue;
+
+            size_t in = 0;
+            for (size_t p = 0; p < pages; p++)
+                in += vec[p] & 1;
+            total += pages;
+            resident += in;
+
+            if (in == pages) {
+                if (f->score[c] < UINT8_MAX)
+                    f->score[c]++;
+            } else if (f->score[c] > 0 && rewarmed < budget) {
+                madvise(f->map + off, len, MADV_WILLNEED);
+                rewarmed += len;
+            }
+        }
+    }
+
+    if (lock_budget > 0 && !lock_done && samples >= RESIDENCY_LOCK_AFTER)
+        lock_hottest();
+
+    log_preload(LOG_INFO, "Residency guard: %zu%% resident (%zu/%zuMB), rewarmed %zuKB, locked %zuKB",
+                total ? resident * 100 / total : 0, resident * page_size >> 20, total * page_size >> 20,
+                rewarmed / 1024, locked_bytes / 1024);
+}
@@ -0,0 +1,615 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <time.h>
+
+typedef struct {
+    pid_t tid;
+    uint64_t ticks;
+    char comm[16];
+} SessionThread;
+
+typedef struct {
+    int nr_freqs[SESSION_MAX_CLUSTERS];
+    uint32_t khz[SESSION_MAX_CLUSTERS][MAX_CLUSTER_FREQS];
+    uint64_t time[SESSION_MAX_CLUSTERS][MAX_CLUSTER_FREQS]; // 10ms units
+    uint64_t psi_us[3];
+    long charge_uah;
+} SystemSnap;
+
+typedef struct {
+    uint64_t ticks;
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+    int nr_threads;
+    SessionThread threads[MAX_SESSION_THREADS];
+} GameSnap;
+
+// Toggles recorded with every session, bit n is session_features[n]
+static const char* const session_features[] = {"litemode", "cgroupboost", "cpuset",   "irqsteer",
+                                               "vmtune",   "freezer",     "blktune",  "gpuctl",
+                                               "thermalgov", "preloadguard", "APreload", "iosched"};
+
+static const char* const psi_nodes[] = {"cpu", "memory", "io"};
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static int zone_fd[MAX_THERMAL_ZONES];
+static int nr_zone_fds = 0;
+static bool active = false;
+static char package[MAX_PACKAGE];
+static pid_t pid = 0;
+static int64_t start_ms = 0;
+static int64_t last_tick = 0;
+static int64_t last_game_sample = 0;
+static SessionRecord rec;
+static SystemSnap sys_start;
+static SystemSnap sys_end;
+static GameSnap game_start;
+static GameSnap game_last;
+static int64_t voltage_sum = 0;
+static int voltage_samples = 0;
+
+static bool read_buf(const char* path, char* buf, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    ssize_t len = read(fd, buf, size - 1);
+    close(fd);
+    if (len <= 0)
+        return false;
+    buf[len] = '\0';
+    return true;
+}
+
+static long read_long(const char* path, long fallback) {
+    char buf[64];
+    return read_buf(path, buf, sizeof(buf)) ? atol(buf) : fallback;
+}
+
+static int hottest_zone(void) {
+    int hottest = 0;
+    for (int i = 0; i < nr_zone_fds; i++) {
+        char buf[24];
+        ssize_t len = pread(zone_fd[i], buf, sizeof(buf) - 1, 0);
+        if (len <= 0)
+            continue;
+        buf[len] = '\0';
+
+        int temp = atoi(buf);
+        if (temp > 0 && temp < 200)
+            temp *= 1000;
+        if (temp > hottest)
+            hottest = temp;
+    }
+    return hottest;
+}
+
+static void snap_system(SystemSnap* s) {
+    char path[MAX_PATH_LENGTH * 2];
+    char line[MAX_LINE];
+    memset(s, 0, sizeof(*s));
+
+    for (int c = 0; c < nr_clusters && c < SESSION_MAX_CLUSTERS; c++) {
+        snprintf(path, sizeof(path), "%s%s/policy%d/stats/time_in_state", root_dir, CPUFREQ_PATH,
+                 clusters[c].policy);
+        FILE* fp = fopen(path, "r");
+        if (!fp)
+            continue;
+
+        unsigned long khz;
+        unsigned long long ticks;
+        while (s->nr_freqs[c] < MAX_CLUSTER_FREQS && fgets(line, sizeof(line), fp)) {
+            if (sscanf(line, "%lu %llu", &khz, &ticks) != 2)
+                continue;
+            s->khz[c][s->nr_freqs[c]] = (uint32_t)khz;
+            s->time[c][s->nr_freqs[c]++] = ticks;
+        }
+        fclose(fp);
+    }
+
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=123456
+    for (int i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s/proc/pressure/%s", root_dir, psi_nodes[i]);
+        char* total;
+        if (read_buf(path, line, sizeof(line)) && (total = strstr(line, "total=")))
+            s->psi_us[i] = strtoull(total + 6, NULL, 10);
+    }
+
+    snprintf(path, sizeof(path), "%s/sys/class/power_supply/battery/charge_counter", root_dir);
+    s->charge_uah = read_long(path, -1);
+}
+
+static bool parse_stat_ticks(const char* stat, char* comm, size_t comm_size, uint64_t* ticks) {
+    const char* open_paren = strchr(stat, '(');
+    const char* close_paren = strrchr(stat, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren)
+        return false;
+
+    if (comm) {
+        size_t len = (size_t)(close_paren - open_paren - 1);
+        if (len >= comm_size)
+            len = comm_size - 1;
+        memcpy(comm, open_paren + 1, len);
+        comm[len] = '\0';
+    }
+
+    // state ppid pgrp session tty tpgid flags minflt cminflt majflt cmajflt utime stime
+    unsigned long long utime, stime;
+    if (sscanf(close_paren + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2)
+        return false;
+    *ticks = utime + stime;
+    return true;
+}
+
+static bool snap_game(GameSnap* s) {
+    char path[MAX_PATH_LENGTH * 2];
+    char buf[MAX_DATA_LENGTH];
+
+    snprintf(path, sizeof(path), "%s/proc/%d/stat", root_dir, pid);
+    uint64_t ticks;
+    if (!read_buf(path, buf, sizeof(buf)) || !parse_stat_ticks(buf, NULL, 0, &ticks))
+        return false;
+    s->ticks = ticks;
+
+    snprintf(path, sizeof(path), "%s/proc/%d/io", root_dir, pid);
+    if (read_buf(path, buf, sizeof(buf))) {
+        char* p;
+        if ((p = strstr(buf, "\nread_bytes:")))
+            s->read_bytes = strtoull(p + 12, NULL, 10);
+        if ((p = strstr(buf, "\nwrite_bytes:")))
+            s->write_bytes = strtoull(p + 13, NULL, 10);
+    }
+
+    snprintf(path, sizeof(path), "%s/proc/%d/task", root_dir, pid);
+    DIR* dir = opendir(path);
+    if (!dir)
+        return true;
+
+    s->nr_threads = 0;
+    struct dirent* entry;
+    while (s->nr_threads < MAX_SESSION_THREADS && (entry = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)entry->d_name[0]))
+            continue;
+
+        SessionThread* t = &s->threads[s->nr_threads];
+        snprintf(path, sizeof(path), "%s/proc/%d/task/%s/stat", root_dir, pid, entry->d_name);
+        if (!read_buf(path, buf, sizeof(buf)) || !parse_stat_ticks(buf, t->comm, sizeof(t->comm), &t->ticks))
+            continue;
+        t->tid = atoi(entry->d_name);
+        s->nr_threads++;
+    }
+    closedir(dir);
+    return true;
+}
+
+static bool clusters_capped(void) {
+    char path[MAX_PATH_LENGTH * 2];
+    for (int c = 0; c < nr_clusters; c++) {
+        snprintf(path, sizeof(path), "%s%s/policy%d/scaling_max_freq", root_dir, CPUFREQ_PATH, clusters[c].policy);
+        int cap = read_int_file(path, 0);
+        if (cap > 0 && cap < clusters[c].cpuinfo_max)
+            return true;
+    }
+    return false;
+}
+
+/***********************************************************************************
+ * Function Name      : session_rec_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : bool - true if the session directory is usable
+ * Description        : Opens the SoC thermal zones and creates SESSION_DIR.
+ ***********************************************************************************/
+bool session_rec_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s%s", root_dir, THERMAL_PATH);
+    DIR* dir = opendir(path);
+    if (dir) {
+        struct dirent* entry;
+        while (nr_zone_fds < MAX_THERMAL_ZONES && (entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "thermal_zone", 12) != 0)
+                continue;
+
+            char type[32] = {0};
+            snprintf(path, sizeof(path), "%s%s/%s/type", root_dir, THERMAL_PATH, entry->d_name);
+            if (!read_buf(path, type, sizeof(type)) || !thermal_zone_relevant(trim_newline(type)))
+                continue;
+
+            snprintf(path, sizeof(path), "%s%s/%s/temp", root_dir, THERMAL_PATH, entry->d_name);
+            int fd = open(path, O_RDONLY | O_CLOEXEC);
+            if (fd != -1)
+                zone_fd[nr_zone_fds++] = fd;
+        }
+        closedir(dir);
+    }
+
+    snprintf(path, sizeof(path), "%s%s", root_dir, SESSION_DIR);
+    if (mkdir(path, 0755) == -1 && errno != EEXIST) {
+        log_zenith(LOG_WARN, "Session recorder: unable to create %s", path);
+        return false;
+    }
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : session_rec_begin
+ * Inputs             : game (const char *) - package of the game
+ *                      game_pid (pid_t) - its main process
+ * Returns            : None
+ * Description        : Snapshots the kernel counters a session report is built
+ *                      from, ending any session still open.
+ ***********************************************************************************/
+void session_rec_begin(const char* game, pid_t game_pid) {
+    session_rec_end();
+    if (!game || !game[0] || strchr(game, '/') || game_pid <= 0)
+        return;
+
+    snprintf(package, sizeof(package), "%s", game);
+    pid = game_pid;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = SESSION_MAGIC;
+    rec.version = SESSION_VERSION;
+    rec.start = time(NULL);
+    for (size_t i = 0; i < sizeof(session_features) / sizeof(session_features[0]); i++) {
+        char name[PROP_VALUE_MAX];
+        char value[PROP_VALUE_MAX] = {0};
+        snprintf(name, sizeof(name), "persist.sys.azenithconf.%s", session_features[i]);
+        __system_property_get(name, value);
+        if (strcmp(value, "1") == 0)
+            rec.features |= 1U << i;
+    }
+
+    memset(&game_start, 0, sizeof(game_start));
+    snap_system(&sys_start);
+    snap_game(&game_start);
+    game_last = game_start;
+
+    rec.temp_start_mc = hottest_zone();
+    rec.temp_peak_mc = rec.temp_start_mc;
+    voltage_sum = 0;
+    voltage_samples = 0;
+    start_ms = now_ms();
+    last_tick = start_ms;
+    last_game_sample = start_ms;
+    active = true;
+}
+
+/***********************************************************************************
+ * Function Name      : session_rec_tick
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Accumulates what only shows while the game runs: time
+ *                      with any cluster capped below cpuinfo_max_freq, the peak
+ *                      temperature, battery voltage and charging. Game counters
+ *                      are refreshed every SESSION_SAMPLE_MS so a game that
+ *                      already exited still gets its last values reported.
+ ***********************************************************************************/
+void session_rec_tick(void) {
+    if (!active)
+        return;
+
+    int64_t now = now_ms();
+    if (clusters_capped())
+        rec.throttle_ms += (uint32_t)(now - last_tick);
+    last_tick = now;
+
+    int temp = hottest_zone();
+    if (temp > rec.temp_peak_mc)
+        rec.temp_peak_mc = temp;
+
+    char path[MAX_PATH_LENGTH * 2];
+    char status[32] = {0};
+    snprintf(path, sizeof(path), "%s/sys/class/power_supply/battery/voltage_now", root_dir);
+    long uv = read_long(path, 0);
+    if (uv > 0) {
+        voltage_sum += uv;
+        voltage_samples++;
+    }
+    snprintf(path, sizeof(path), "%s/sys/class/power_supply/battery/status", root_dir);
+    if (read_buf(path, status, sizeof(status)) && strncmp(status, "Charging", 8) == 0)
+        rec.flags |= SESSION_CHARGING;
+
+    if (now - last_game_sample >= SESSION_SAMPLE_MS) {
+        last_game_sample = now;
+        snap_game(&game_last);
+    }
+}
+
+static void fill_clusters(void) {
+    rec.nr_clusters = (uint8_t)(nr_clusters < SESSION_MAX_CLUSTERS ? nr_clusters : SESSION_MAX_CLUSTERS);
+    for (int c = 0; c < rec.nr_clusters; c++) {
+        // Frequencies come out in the same order every read
+        int n = sys_start.nr_freqs[c] < sys_end.nr_freqs[c] ? sys_start.nr_freqs[c] : sys_end.nr_freqs[c];
+        uint64_t total = 0;
+        uint64_t weighted = 0;
+        uint64_t at_max = 0;
+        uint32_t max_khz = 0;
+
+        for (int i = 0; i < n; i++) {
+            uint64_t dt = sys_end.time[c][i] - sys_start.time[c][i];
+            total += dt;
+            weighted += dt * sys_end.khz[c][i];
+            if (sys_end.khz[c][i] > max_khz) {
+                max_khz = sys_end.khz[c][i];
+                at_max = dt;
+            }
+        }
+        if (total > 0) {
+            rec.avg_khz[c] = (uint32_t)(weighted / total);
+            rec.top_pct[c] = (uint8_t)(at_max * 100 / total);
+        }
+    }
+}
+
+static void fill_threads(void) {
+    long hz = sysconf(_SC_CLK_TCK);
+    for (int i = 0; i < game_last.nr_threads; i++) {
+        const SessionThread* t = &game_last.threads[i];
+        uint64_t before = 0;
+        for (int j = 0; j < game_start.nr_threads; j++) {
+            if (game_start.threads[j].tid == t->tid) {
+                before = game_start.threads[j].ticks;
+                break;
+            }
+        }
+
+        uint32_t ms = (uint32_t)((t->ticks - before) * 1000 / (uint64_t)(hz > 0 ? hz : 100));
+        for (int k = 0; k < SESSION_TOP_THREADS; k++) {
+            if (ms <= rec.thread_ms[k])
+                continue;
+
+            // Shift the smaller ones down and take slot k
+            for (int m = SESSION_TOP_THREADS - 1; m > k; m--) {
+                rec.thread_ms[m] = rec.thread_ms[m - 1];
+                memcpy(rec.thread_name[m], rec.thread_name[m - 1], sizeof(rec.thread_name[m]));
+            }
+            rec.thread_ms[k] = ms;
+            snprintf(rec.thread_name[k], sizeof(rec.thread_name[k]), "%s", t->comm);
+            break;
+        }
+    }
+}
+
+static void save_record(void) {
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s%s/%s.bin", root_dir, SESSION_DIR, package);
+
+    // Keep the newest SESSION_MAX_RECORDS sessions per game
+    FILE* fp = fopen(path, "rb");
+    if (fp) {
+        SessionRecord* old = malloc(sizeof(SessionRecord) * SESSION_MAX_RECORDS);
+        size_t n = old ? fread(old, sizeof(SessionRecord), SESSION_MAX_RECORDS, fp) : 0;
+        fclose(fp);
+        if (n == SESSION_MAX_RECORDS && (fp = fopen(path, "wb"))) {
+            fwrite(old + 1, sizeof(SessionRecord), n - 1, fp);
+            fclose(fp);
+        }
+        free(old);
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1 || write(fd, &rec, sizeof(rec)) != (ssize_t)sizeof(rec))
+        log_zenith(LOG_WARN, "Session recorder: unable to write %s", path);
+    if (fd != -1)
+        close(fd);
+}
+
+/***********************************************************************************
+ * Function Name      : session_rec_end
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Computes the session deltas and appends the record to
+ *                      SESSION_DIR/<package>.bin. Average power comes from the
+ *                      battery charge counter and is left at 0 for short or
+ *                      charging sessions, where it means nothing.
+ ***********************************************************************************/
+void session_rec_end(void) {
+    if (!active)
+        return;
+    active = false;
+
+    int64_t now = now_ms();
+    snap_game(&game_last);
+    snap_system(&sys_end);
+
+    rec.duration_ms = (uint32_t)(now - start_ms);
+    rec.temp_end_mc = hottest_zone();
+
+    long hz = sysconf(_SC_CLK_TCK);
+    rec.game_cpu_ms = (uint32_t)((game_last.ticks - game_start.ticks) * 1000 / (uint64_t)(hz > 0 ? hz : 100));
+    rec.read_kb = (uint32_t)((game_last.read_bytes - game_start.read_bytes) >> 10);
+    rec.write_kb = (uint32_t)((game_last.write_bytes - game_start.write_bytes) >> 10);
+    for (int i = 0; i < 3; i++)
+        rec.psi_some_ms[i] = (uint32_t)((sys_end.psi_us[i] - sys_start.psi_us[i]) / 1000);
+
+    long used_uah = sys_start.charge_uah - sys_end.charge_uah;
+    if (!(rec.flags & SESSION_CHARGING) && rec.duration_ms >= SESSION_MIN_POWER_MS && sys_start.charge_uah > 0 &&
+        used_uah > 0 && voltage_samples > 0) {
+        // uAh * V gives uWh, spread over the session in ms
+        double volts = (double)voltage_sum / voltage_samples / 1e6;
+        rec.avg_power_mw = (int32_t)(used_uah * volts * 3600.0 / rec.duration_ms);
+    }
+
+    fill_clusters();
+    fill_threads();
+    save_record();
+    stats.sessions_recorded++;
+
+    log_zenith(LOG_INFO, "Session %s: %us, game CPU %u ms, %d mW, throttled %u ms, peak %d mC", package,
+               rec.duration_ms / 1000, rec.game_cpu_ms, rec.avg_power_mw, rec.throttle_ms, rec.temp_peak_mc);
+}
+
+typedef struct {
+    uint32_t features;
+    int count;
+    uint64_t duration_ms;
+    uint64_t cpu_ms;
+    uint64_t throttle_ms;
+    int64_t power_mw;
+    int power_count;
+    int64_t peak_mc;
+    uint64_t khz[SESSION_MAX_CLUSTERS];
+    uint64_t top_pct[SESSION_MAX_CLUSTERS];
+    int nr_clusters;
+} SessionGroup;
+
+static void print_features(uint32_t features) {
+    if (!features) {
+        printf("  stock (no toggles)\n");
+        return;
+    }
+
+    const char* sep = "  ";
+    for (size_t i = 0; i < sizeof(session_features) / sizeof(session_features[0]); i++) {
+        if (features & (1U << i)) {
+            printf("%s%s", sep, session_features[i]);
+            sep = ",";
+        }
+    }
+    printf("\n");
+}
+
+static void print_sessions(const char* path, const char* name) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return;
+
+    SessionGroup groups[8] = {0};
+    int nr_groups = 0;
+    int total = 0;
+    SessionRecord r;
+    SessionRecord last = {0};
+
+    while (fread(&r, sizeof(r), 1, fp) == 1) {
+        if (r.magic != SESSION_MAGIC || r.version != SESSION_VERSION || r.duration_ms == 0)
+            continue;
+
+        SessionGroup* g = NULL;
+        for (int i = 0; i < nr_groups && !g; i++) {
+            if (groups[i].features == r.features)
+                g = &groups[i];
+        }
+        if (!g && nr_groups < 8) {
+            g = &groups[nr_groups++];
+            g->features = r.features;
+        }
+        if (!g)
+            continue;
+
+        g->count++;
+        g->duration_ms += r.duration_ms;
+        g->cpu_ms += r.game_cpu_ms;
+        g->throttle_ms += r.throttle_ms;
+        g->peak_mc += r.temp_peak_mc;
+        if (r.avg_power_mw > 0) {
+            g->power_mw += r.avg_power_mw;
+            g->power_count++;
+        }
+        g->nr_clusters = r.nr_clusters;
+        for (int c = 0; c < r.nr_clusters && c < SESSION_MAX_CLUSTERS; c++) {
+            g->khz[c] += r.avg_khz[c];
+            g->top_pct[c] += r.top_pct[c];
+        }
+        last = r;
+        total++;
+    }
+    fclose(fp);
+
+    if (total == 0)
+        return;
+
+    printf("%s: %d sessions\n", name, total);
+    for (int i = 0; i < nr_groups; i++) {
+        SessionGroup* g = &groups[i];
+        uint64_t avg_s = g->duration_ms / g->count / 1000;
+        print_features(g->features);
+        printf("    %d sessions, avg %llum%02llus, game CPU %llu%%, throttled %llu%%, peak %.1fC",
+               g->count, (unsigned long long)(avg_s / 60), (unsigned long long)(avg_s % 60),
+               (unsigned long long)(g->cpu_ms * 100 / g->duration_ms),
+               (unsigned long long)(g->throttle_ms * 100 / g->duration_ms), (double)g->peak_mc / g->count / 1000);
+        if (g->power_count > 0)
+            printf(", %lld mW", (long long)(g->power_mw / g->power_count));
+        printf("\n    avg MHz");
+        for (int c = 0; c < g->nr_clusters; c++)
+            printf("%s%llu", c ? "/" : " ", (unsigned long long)(g->khz[c] / g->count / 1000));
+        printf(", at max");
+        for (int c = 0; c < g->nr_clusters; c++)
+            printf("%s%llu", c ? "/" : " ", (unsigned long long)(g->top_pct[c] / g->count));
+        printf("%%\n");
+    }
+
+    char when[32] = "?";
+    time_t start = (time_t)last.start;
+    struct tm* tm = localtime(&start);
+    if (tm)
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M", tm);
+    printf("  last %s, %um%02us, read %u KB, write %u KB, PSI cpu/mem/io %u/%u/%u ms%s\n    threads", when,
+           last.duration_ms / 60000, last.duration_ms / 1000 % 60, last.read_kb, last.write_kb, last.psi_some_ms[0],
+           last.psi_some_ms[1], last.psi_some_ms[2], last.flags & SESSION_CHARGING ? ", charging" : "");
+    for (int k = 0; k < SESSION_TOP_THREADS && last.thread_ms[k]; k++)
+        printf("%s%s %u%%", k ? ", " : " ", last.thread_name[k], last.thread_ms[k] * 100 / last.duration_ms);
+    printf("\n");
+}
+
+/***********************************************************************************
+ * Function Name      : handle_sessions
+ * Inputs             : argc - number of CLI arguments
+ *                      argv - array of CLI argument strings
+ * Returns            : int - 0 on success, non-zero on failure
+ * Description        : Summarises the recorded sessions of every game, or only
+ *                      argv[2], grouped by the toggles that were enabled so the
+ *                      effect of a profile change can be read off directly.
+ ***********************************************************************************/
+int handle_sessions(int argc, char** argv) {
+    const char* only = argc > 2 ? argv[2] : NULL;
+    DIR* dir = opendir(SESSION_DIR);
+    if (!dir) {
+        fprintf(stderr, "ERROR: No sessions recorded yet.\n");
+        return 1;
+    }
+
+    int printed = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char name[MAX_PACKAGE];
+        char* ext = strstr(entry->d_name, ".bin");
+        if (!ext || ext[4] || (size_t)(ext - entry->d_name) >= sizeof(name))
+            continue;
+
+        snprintf(name, sizeof(name), "%.*s", (int)(ext - entry->d_name), entry->d_name);
+        if (only && strcmp(only, name) != 0)
+            continue;
+
+        char path[MAX_PATH_LENGTH * 2];
+        snprintf(path, sizeof(path), "%s/%s", SESSION_DIR, entry->d_name);
+        if (printed++)
+            printf("\n");
+        print_sessions(path, name);
+    }
+    closedir(dir);
+
+    if (!printed) {
+        fprintf(stderr, "ERROR: No sessions recorded%s%s.\n", only ? " for " : "", only ? only : "");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <sys/inotify.h>
+
+#define SETTINGS_GLOBAL "settings_global.xml"
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static int screen_fds[MAX_SCREEN_NODES];
+static int nr_screen_fds = 0;
+static bool screen_on = true;
+static int64_t screen_read_at = 0;
+static int64_t screen_verified_at = 0;
+static int screen_mismatches = 0;
+
+static int settings_fd = -1;
+static bool low_power = false;
+static bool low_power_dirty = true;
+static int64_t low_power_read_at = 0;
+
+// "0" is a dark backlight, DRM connectors report their dpms state as text
+static bool node_is_on(int fd) {
+    char buf[32] = {0};
+    if (pread(fd, buf, sizeof(buf) - 1, 0) <= 0)
+        return false;
+    if (isdigit((unsigned char)buf[0]))
+        return atoi(buf) > 0;
+    return strncmp(buf, "On", 2) == 0;
+}
+
+static void add_screen_nodes(const char* dir, const char* prefix, const char* file) {
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s%s", root_dir, dir);
+    DIR* d = opendir(path);
+    if (!d)
+        return;
+
+    struct dirent* entry;
+    while (nr_screen_fds < MAX_SCREEN_NODES && (entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.' || strncmp(entry->d_name, prefix, strlen(prefix)) != 0)
+            continue;
+
+        snprintf(path, sizeof(path), "%s%s/%s/%s", root_dir, dir, entry->d_name, file);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd != -1)
+            screen_fds[nr_screen_fds++] = fd;
+    }
+    closedir(d);
+}
+
+static void settings_handler(int fd) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + len;) {
+            struct inotify_event* ev = (struct inotify_event*)p;
+            // AtomicFile writes a .new or .tmp sibling and renames it over
+            if (ev->len && strncmp(ev->name, SETTINGS_GLOBAL, strlen(SETTINGS_GLOBAL)) == 0)
+                low_power_dirty = true;
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : state_screen_on
+ * Inputs             : None
+ * Returns            : bool - true if the screen is on
+ * Description        : Screen state from the backlight or DRM dpms nodes, reread
+ *                      at most every STATE_SCREEN_MS. Every STATE_VERIFY_MS the
+ *                      answer is checked against dumpsys power; two mismatches
+ *                      in a row (always-on displays keep the backlight lit)
+ *                      hand screen state back to dumpsys for good.
+ ***********************************************************************************/
+bool state_screen_on(void) {
+    int64_t now = now_ms();
+    if (now - screen_read_at >= STATE_SCREEN_MS) {
+        screen_read_at = now;
+        screen_on = false;
+        for (int i = 0; i < nr_screen_fds && !screen_on; i++)
+            screen_on = node_is_on(screen_fds[i]);
+    }
+
+    if (now - screen_verified_at >= STATE_VERIFY_MS) {
+        screen_verified_at = now;
+        if (get_screenstate_normal() != screen_on) {
+            if (++screen_mismatches >= 2) {
+                log_zenith(LOG_WARN, "State tracker: display nodes disagree with dumpsys, using dumpsys");
+                get_screenstate = get_screenstate_normal;
+                return get_screenstate_normal();
+            }
+        } else {
+            screen_mismatches = 0;
+        }
+    }
+    return screen_on;
+}
+
+/***********************************************************************************
+ * Function Name      : state_low_power
+ * Inputs             : None
+ * Returns            : bool - true if Battery Saver is enabled
+ * Description        : Cached battery saver state. Refetched when the global
+ *                      settings file changes, or after STATE_LOW_POWER_TTL_MS
+ *                      in case a write was missed.
+ ***********************************************************************************/
+bool state_low_power(void) {
+    int64_t now = now_ms();
+    if (low_power_dirty || now - low_power_read_at >= STATE_LOW_POWER_TTL_MS) {
+        low_power_dirty = false;
+        low_power_read_at = now;
+        low_power = get_low_power_state_normal();
+    }
+    return low_power;
+}
+
+/***********************************************************************************
+ * Function Name      : state_tracker_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : int - number of display nodes found
+ * Description        : Opens the backlight and DRM dpms nodes and watches the
+ *                      global settings for battery saver changes, then points
+ *                      get_screenstate and get_low_power_state at the cached
+ *                      readers. Either stays on the dumpsys path when its
+ *                      source is missing.
+ ***********************************************************************************/
+int state_tracker_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+
+    add_screen_nodes("/sys/class/backlight", "", "brightness");
+    add_screen_nodes("/sys/class/leds", "lcd-backlight", "brightness");
+    add_screen_nodes("/sys/class/drm", "card", "dpms");
+
+    if (nr_screen_fds > 0) {
+        screen_read_at = screen_verified_at = now_ms();
+        screen_on = false;
+        for (int i = 0; i < nr_screen_fds && !screen_on; i++)
+            screen_on = node_is_on(screen_fds[i]);
+        if (screen_on != get_screenstate_normal()) {
+            log_zenith(LOG_INFO, "State tracker: display nodes disagree with dumpsys at init");
+            screen_mismatches = 1;
+        }
+        get_screenstate = state_screen_on;
+    }
+
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s/data/system/users/0", root_dir);
+    settings_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (settings_fd != -1 && inotify_add_watch(settings_fd, path, IN_CLOSE_WRITE | IN_MOVED_TO) != -1 &&
+        event_loop_add(settings_fd, settings_handler) == 0) {
+        get_low_power_state = state_low_power;
+    } else if (settings_fd != -1) {
+        close(settings_fd);
+        settings_fd = -1;
+    }
+
+    log_zenith(LOG_INFO, "State tracker: %d display nodes, battery saver %s", nr_screen_fds,
+               settings_fd != -1 ? "watched" : "polled");
+    return nr_screen_fds;
+}
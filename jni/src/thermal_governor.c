@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+typedef struct {
+    int fd;
+    int avg_mc;
+    char type[32];
+} ThermalZone;
+
+static ThermalZone zones[MAX_THERMAL_ZONES];
+static int nr_zones = 0;
+static bool governor_ready = false;
+static ThermalCtl ctl;
+static int applied_cap[MAX_CLUSTERS];
+
+// Zones that follow SoC heat, anything else (battery, pa, charger) lags too much
+static const char* const zone_filter[] = {"cpu", "soc", "tsens", "gpu", "skin", "ap_ntc", NULL};
+
+/***********************************************************************************
+ * Function Name      : thermal_zone_relevant
+ * Inputs             : type (const char *) - thermal zone type
+ * Returns            : bool - true if the zone follows SoC heat
+ * Description        : Matches the zone type against zone_filter.
+ ***********************************************************************************/
+bool thermal_zone_relevant(const char* type) {
+    char lower[32] = {0};
+    for (size_t i = 0; type[i] && i < sizeof(lower) - 1; i++)
+        lower[i] = tolower((unsigned char)type[i]);
+
+    for (int i = 0; zone_filter[i]; i++) {
+        if (strstr(lower, zone_filter[i]))
+            return true;
+    }
+    return false;
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_ctl_reset
+ * Inputs             : c (ThermalCtl *) - controller state
+ * Returns            : None
+ * Description        : Drops all throttle steps and hold-off counters.
+ ***********************************************************************************/
+void thermal_ctl_reset(ThermalCtl* c) {
+    c->level = 0;
+    c->hold = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_ctl_update
+ * Inputs             : c (ThermalCtl *) - controller state
+ *                      hottest_mc (int) - averaged temperature of hottest zone
+ * Returns            : int - current throttle level
+ * Description        : Pure step controller. Raises the throttle level one step
+ *                      at a time while above the trip point and releases it one
+ *                      step at a time once below trip minus hysteresis. Each move
+ *                      is followed by a hold-off so caps don't oscillate.
+ * Note               : Has no side effects, feed it recorded traces to test.
+ ***********************************************************************************/
+int thermal_ctl_update(ThermalCtl* c, int hottest_mc) {
+    if (c->hold > 0) {
+        c->hold--;
+        return c->level;
+    }
+
+    if (hottest_mc >= c->trip_mc && c->level < THERMAL_MAX_LEVEL) {
+        c->level++;
+        c->hold = THERMAL_STEP_HOLD;
+    } else if (hottest_mc <= c->trip_mc - THERMAL_HYST_MC && c->level > 0) {
+        c->level--;
+        c->hold = THERMAL_RELEASE_HOLD;
+    }
+
+    return c->level;
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_ctl_cap
+ * Inputs             : c (const CpuCluster *) - target cluster
+ *                      level (int) - throttle level
+ * Returns            : int - max frequency cap in kHz for this cluster
+ * Description        : Each level removes THERMAL_STEP_PCT of the cluster max,
+ *                      snapped down to an available frequency.
+ ***********************************************************************************/
+int thermal_ctl_cap(const CpuCluster* c, int level) {
+    if (level <= 0)
+        return c->cpuinfo_max;
+
+    long target = (long)c->cpuinfo_max * (100 - level * THERMAL_STEP_PCT) / 100;
+    return cluster_floor_freq(c, (int)target);
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_governor_init
+ * Inputs             : None
+ * Returns            : bool - true if at least one usable thermal zone was found
+ * Description        : Opens persistent fds for SoC related thermal zones.
+ ***********************************************************************************/
+bool thermal_governor_init(void) {
+    DIR* dir = opendir(THERMAL_PATH);
+    if (!dir) {
+        log_zenith(LOG_WARN, "Thermal governor: %s not available", THERMAL_PATH);
+        return false;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && nr_zones < MAX_THERMAL_ZONES) {
+        if (strncmp(entry->d_name, "thermal_zone", 12) != 0)
+            continue;
+
+        char path[MAX_PATH_LENGTH];
+        char type[32] = {0};
+        snprintf(path, sizeof(path), "%s/%s/type", THERMAL_PATH, entry->d_name);
+        FILE* fp = fopen(path, "r");
+        if (!fp)
+            continue;
+        if (!fgets(type, sizeof(type), fp)) {
+            fclose(fp);
+            continue;
+        }
+        fclose(fp);
+        trim_newline(type);
+
+        if (!thermal_zone_relevant(type))
+            continue;
+
+        snprintf(path, sizeof(path), "%s/%s/temp", THERMAL_PATH, entry->d_name);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            continue;
+
+        zones[nr_zones].fd = fd;
+        zones[nr_zones].avg_mc = INT32_MIN;
+        strncpy(zones[nr_zones].type, type, sizeof(zones[nr_zones].type) - 1);
+        nr_zones++;
+    }
+    closedir(dir);
+
+    if (nr_zones == 0 || nr_clusters == 0) {
+        log_zenith(LOG_WARN, "Thermal governor: no usable thermal zones or clusters");
+        return false;
+    }
+
+    char trip[PROP_VALUE_MAX] = {0};
+    __system_property_get("persist.sys.azenithconf.thermaltrip", trip);
+    ctl.trip_mc = atoi(trip) > 0 ? atoi(trip) * 1000 : THERMAL_TRIP_MC;
+    thermal_ctl_reset(&ctl);
+
+    governor_ready = true;
+    log_zenith(LOG_INFO, "Thermal governor watching %d zones, trip at %d mC", nr_zones, ctl.trip_mc);
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_sample_hottest
+ * Inputs             : None
+ * Returns            : int - hottest moving average across zones in mC
+ * Description        : Samples every zone with pread and updates its moving
+ *                      average (1/4 weight for the new sample).
+ ***********************************************************************************/
+static int thermal_sample_hottest(void) {
+    int hottest = INT32_MIN;
+
+    for (int i = 0; i < nr_zones; i++) {
+        char buf[24];
+        ssize_t len = pread(zones[i].fd, buf, sizeof(buf) - 1, 0);
+        if (len <= 0)
+            continue;
+        buf[len] = '\0';
+
+        int temp = atoi(buf);
+        // A few vendor drivers report whole degrees
+        if (temp > 0 && temp < 200)
+            temp *= 1000;
+
+        if (zones[i].avg_mc == INT32_MIN)
+            zones[i].avg_mc = temp;
+        else
+            zones[i].avg_mc += (temp - zones[i].avg_mc) / 4;
+
+        if (zones[i].avg_mc > hottest)
+            hottest = zones[i].avg_mc;
+    }
+
+    return hottest;
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_write_cap
+ * Inputs             : i (int) - cluster index
+ *                      cap (int) - max frequency in kHz
+ *                      use_ppm (bool) - write through PPM instead of cpufreq
+ * Returns            : None
+ * Description        : Writes one cluster cap and remembers it.
+ ***********************************************************************************/
+static void thermal_write_cap(int i, int cap, bool use_ppm) {
+    if (use_ppm) {
+        write2file(PPM_MAX_FREQ, false, false, "%d %d", i, cap);
+    } else {
+        char path[MAX_PATH_LENGTH];
+        snprintf(path, sizeof(path), "%s/policy%d/scaling_max_freq", CPUFREQ_PATH, clusters[i].policy);
+        write2file(path, false, false, "%d", cap);
+    }
+    applied_cap[i] = cap;
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_apply_caps
+ * Inputs             : level (int) - throttle level
+ * Returns            : None
+ * Description        : Writes per-cluster caps through PPM when available,
+ *                      otherwise through scaling_max_freq. The little cluster is
+ *                      left alone on multi-cluster SoCs, it barely adds heat.
+ ***********************************************************************************/
+static void thermal_apply_caps(int level) {
+    bool use_ppm = access(PPM_MAX_FREQ, F_OK) == 0;
+
+    for (int i = 0; i < nr_clusters; i++) {
+        if (nr_clusters > 1 && i == 0)
+            continue;
+
+        int cap = thermal_ctl_cap(&clusters[i], level);
+        if (cap != applied_cap[i])
+            thermal_write_cap(i, cap, use_ppm);
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_governor_tick
+ * Inputs             : None
+ * Returns            : None
+ * Description        : One controller iteration, only meaningful while the
+ *                      performance profile is active.
+ ***********************************************************************************/
+void thermal_governor_tick(void) {
+    if (!governor_ready)
+        return;
+
+    int hottest = thermal_sample_hottest();
+    if (hottest == INT32_MIN)
+        return;
+
+    int prev = ctl.level;
+    int level = thermal_ctl_update(&ctl, hottest);
+    if (level == prev)
+        return;
+
+    thermal_apply_caps(level);
+    log_zenith(LOG_INFO, "Thermal governor level %d -> %d at %d mC", prev, level, hottest);
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_governor_reset
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Forgets applied caps after a profile switch, the profile
+ *                      itself rewrites max frequencies.
+ ***********************************************************************************/
+void thermal_governor_reset(void) {
+    thermal_ctl_reset(&ctl);
+    for (int i = 0; i < nr_clusters; i++)
+        applied_cap[i] = clusters[i].cpuinfo_max;
+}
+
+/***********************************************************************************
+ * Function Name      : thermal_governor_restore
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Lifts every cap still applied when the daemon exits,
+ *                      no profile switch follows that would rewrite them.
+ ***********************************************************************************/
+void thermal_governor_restore(void) {
+    if (!governor_ready)
+        return;
+
+    bool use_ppm = access(PPM_MAX_FREQ, F_OK) == 0;
+    for (int i = 0; i < nr_clusters; i++) {
+        if (applied_cap[i] > 0 && applied_cap[i] != clusters[i].cpuinfo_max)
+            thermal_write_cap(i, clusters[i].cpuinfo_max, use_ppm);
+    }
+    thermal_ctl_reset(&ctl);
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+#include <sys/timerfd.h>
+
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+// Level n slots are 64^n ticks wide: 6.4s, 7min, 7h and 19 days at 100ms ticks
+static Timer* wheel[TIMER_LEVELS][WHEEL_SLOTS];
+static uint64_t pending[TIMER_LEVELS]; // occupied slots
+static uint64_t clk = 0; // next tick to expire
+static int timer_fd = -1;
+static bool screen_on = true;
+static bool dispatching = false;
+
+static uint64_t ms_to_tick(int64_t ms) {
+    return (uint64_t)((ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS);
+}
+
+static void enqueue(Timer* t) {
+    if (t->expires < clk)
+        t->expires = clk;
+
+    uint64_t delta = t->expires - clk;
+    int level = 0;
+    while (level < TIMER_LEVELS - 1 && delta >> (WHEEL_BITS * (level + 1)))
+        level++;
+
+    t->level = (uint8_t)level;
+    t->slot = (uint8_t)((t->expires >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    t->next = wheel[level][t->slot];
+    wheel[level][t->slot] = t;
+    pending[level] |= 1ULL << t->slot;
+}
+
+static void dequeue(Timer* t) {
+    Timer** p = &wheel[t->level][t->slot];
+    while (*p && *p != t)
+        p = &(*p)->next;
+    if (*p)
+        *p = t->next;
+    if (!wheel[t->level][t->slot])
+        pending[t->level] &= ~(1ULL << t->slot);
+    t->next = NULL;
+}
+
+// Timers of the slot clk just entered move down to the levels that now fit them
+static void cascade(int level) {
+    int slot = (int)((clk >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    Timer* t = wheel[level][slot];
+    wheel[level][slot] = NULL;
+    pending[level] &= ~(1ULL << slot);
+
+    while (t) {
+        Timer* next = t->next;
+        enqueue(t);
+        t = next;
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : collect_due
+ * Inputs             : now (int64_t) - CLOCK_MONOTONIC ms
+ * Returns            : Timer* - list of timers to run, linked through batch
+ * Description        : Advances the wheel to now and takes every timer whose
+ *                      hard deadline passed. Timers already inside their slack
+ *                      window come along, they would need a wakeup of their
+ *                      own a little later otherwise. Taken timers are off the
+ *                      wheel and marked in flight.
+ ***********************************************************************************/
+static Timer* collect_due(int64_t now) {
+    Timer* due = NULL;
+    uint64_t now_tick = (uint64_t)now / TIMER_TICK_MS;
+
+    while (clk <= now_tick) {
+        for (int level = TIMER_LEVELS - 1; level > 0; level--) {
+            if ((clk & ((1ULL << (WHEEL_BITS * level)) - 1)) == 0)
+                cascade(level);
+        }
+
+        int slot = (int)(clk & WHEEL_MASK);
+        Timer* t = wheel[0][slot];
+        wheel[0][slot] = NULL;
+        pending[0] &= ~(1ULL << slot);
+        while (t) {
+            Timer* next = t->next;
+            t->next = NULL;
+            t->in_flight = true;
+            t->batch = due;
+            due = t;
+            t = next;
+        }
+        clk++;
+    }
+
+    for (int level = 0; level < TIMER_LEVELS; level++) {
+        for (uint64_t bits = pending[level]; bits; bits &= bits - 1) {
+            Timer** p = &wheel[level][__builtin_ctzll(bits)];
+            while (*p) {
+                Timer* t = *p;
+                if (t->soft_ms > now) {
+                    p = &t->next;
+                    continue;
+                }
+                *p = t->next;
+                t->next = NULL;
+                t->in_flight = true;
+                t->batch = due;
+                due = t;
+            }
+            if (!wheel[level][__builtin_ctzll(bits)])
+                pending[level] &= ~(1ULL << __builtin_ctzll(bits));
+        }
+    }
+    return due;
+}
+
+// Arms the timerfd for the earliest hard deadline, or disarms it
+static void program(void) {
+    uint64_t next = UINT64_MAX;
+    for (int level = 0; level < TIMER_LEVELS; level++) {
+        for (uint64_t bits = pending[level]; bits; bits &= bits - 1) {
+            for (Timer* t = wheel[level][__builtin_ctzll(bits)]; t; t = t->next) {
+                if (t->expires < next)
+                    next = t->expires;
+            }
+        }
+    }
+
+    struct itimerspec its = {0};
+    if (next != UINT64_MAX) {
+        int64_t ms = (int64_t)next * TIMER_TICK_MS;
+        its.it_value.tv_sec = ms / 1000;
+        its.it_value.tv_nsec = (long)(ms % 1000) * 1000000;
+        // A zero it_value disarms, an expired deadline still has to fire
+        if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+            its.it_value.tv_nsec = 1;
+    }
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void timer_handler(int fd) {
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;
+
+    dispatching = true;
+    Timer* due = collect_due(now_ms());
+    while (due) {
+        Timer* t = due;
+        due = t->batch;
+        t->batch = NULL;
+
+        // An earlier callback stopped or restarted it
+        if (!t->in_flight || !t->active)
+            continue;
+        t->in_flight = false;
+        t->active = false;
+
+        // Periodic timers rearm first, the callback may still stop or restart them
+        if (t->period_ms > 0)
+            timer_start(t, t->period_ms);
+        stats.timer_fires++;
+        t->fn();
+    }
+    dispatching = false;
+    program();
+}
+
+/***********************************************************************************
+ * Function Name      : timer_wheel_init
+ * Inputs             : None
+ * Returns            : bool - true if the timerfd is registered
+ * Description        : Creates the CLOCK_MONOTONIC timerfd that drives every
+ *                      timer and hands it to the event loop. Suspend stops the
+ *                      clock, nothing fires late because the device slept.
+ ***********************************************************************************/
+bool timer_wheel_init(void) {
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+        return false;
+
+    if (event_loop_add(timer_fd, timer_handler) != 0) {
+        close(timer_fd);
+        timer_fd = -1;
+        return false;
+    }
+
+    clk = (uint64_t)now_ms() / TIMER_TICK_MS;
+    return true;
+}
+
+/***********************************************************************************
+ * Function Name      : timer_start
+ * Inputs             : t (Timer *) - timer to (re)arm
+ *                      delay_ms (int) - earliest time it may run from now
+ * Returns            : None
+ * Description        : Arms a timer to run between delay_ms and delay_ms plus its
+ *                      slack, whenever another timer wakes the loop in that
+ *                      window or at the end of it. Stretched timers wait
+ *                      TIMER_SCREEN_OFF_MULT times longer while the screen is
+ *                      off. An armed timer is moved, one waiting in the
+ *                      current dispatch no longer runs there.
+ ***********************************************************************************/
+void timer_start(Timer* t, int delay_ms) {
+    // In flight timers are off the wheel, the dispatch skips them once cleared
+    if (t->in_flight)
+        t->in_flight = false;
+    else if (t->active)
+        dequeue(t);
+
+    int mult = t->stretch && !screen_on ? TIMER_SCREEN_OFF_MULT : 1;
+    t->soft_ms = now_ms() + (int64_t)delay_ms * mult;
+    t->expires = ms_to_tick(t->soft_ms + (int64_t)t->slack_ms * mult);
+    t->active = true;
+    enqueue(t);
+
+    if (!dispatching && timer_fd != -1)
+        program();
+}
+
+/***********************************************************************************
+ * Function Name      : timer_stop
+ * Inputs             : t (Timer *) - timer to disarm
+ * Returns            : None
+ * Description        : Disarms a timer. Stopping an idle timer does nothing, one
+ *                      waiting in the current dispatch does not run.
+ ***********************************************************************************/
+void timer_stop(Timer* t) {
+    if (!t->active)
+        return;
+
+    if (t->in_flight)
+        t->in_flight = false;
+    else
+        dequeue(t);
+    t->active = false;
+    if (!dispatching && timer_fd != -1)
+        program();
+}
+
+/***********************************************************************************
+ * Function Name      : timer_wheel_set_screen
+ * Inputs             : on (bool) - current screen state
+ * Returns            : None
+ * Description        : Stretched timers rearm with longer periods while the
+ *                      screen is off. When it comes back on, any of them
+ *                      waiting longer than one normal period is pulled in.
+ ***********************************************************************************/
+void timer_wheel_set_screen(bool on) {
+    if (on == screen_on)
+        return;
+    screen_on = on;
+    if (!on)
+        return;
+
+    int64_t now = now_ms();
+    Timer* pull = NULL;
+    for (int level = 0; level < TIMER_LEVELS; level++) {
+        for (uint64_t bits = pending[level]; bits; bits &= bits - 1) {
+            for (Timer* t = wheel[level][__builtin_ctzll(bits)]; t; t = t->next) {
+                if (t->stretch && t->period_ms > 0 && t->soft_ms > now + t->period_ms) {
+                    t->pull = pull;
+                    pull = t;
+                }
+            }
+        }
+    }
+
+    // Rearming moves timers between slots, so only after the walk
+    for (; pull; pull = pull->pull)
+        timer_start(pull, pull->period_ms);
+}
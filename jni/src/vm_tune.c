@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <AZenith.h>
+
+typedef struct {
+    const char* path; // relative to the filesystem root
+    const char* perf;
+    const char* eco; // NULL keeps the value
+} VmKnob;
+
+typedef struct {
+    const char* name;
+    const char* perf;
+} LmkProp;
+
+typedef struct {
+    char path[MAX_PATH_LENGTH * 2];
+    char value[32];
+} SavedVmKnob;
+
+// vfs_cache_pressure is switched per profile by profilesettings already
+static const VmKnob vm_knobs[] = {
+    {"/proc/sys/vm/swappiness", "60", "100"},
+    {"/proc/sys/vm/watermark_scale_factor", "30", "10"},
+};
+
+// Keep zram from writing back to storage while a game loads assets
+static const VmKnob zram_knobs[] = {
+    {"/sys/block/zram0/writeback_limit_enable", "1", NULL},
+    {"/sys/block/zram0/writeback_limit", "0", NULL},
+};
+
+// Let lmkd react earlier to stalls and free memory before the game stalls on reclaim
+static const LmkProp lmk_props[] = {
+    {"ro.lmk.psi_partial_stall_ms", "50"},
+    {"ro.lmk.swap_free_low_percentage", "20"},
+};
+
+static char root_dir[MAX_PATH_LENGTH] = "";
+static SavedVmKnob saved[MAX_VM_SAVED];
+static int nr_saved = 0;
+static char saved_lmk[sizeof(lmk_props) / sizeof(lmk_props[0])][PROP_VALUE_MAX];
+static bool lmk_changed = false;
+static bool zram_writeback = false;
+static bool has_psi = false;
+static int psi_fd = -1;
+static VmCtl ctl;
+static int base_wmark = 0;
+static bool session = false;
+static uint64_t last_some_us = 0;
+static uint64_t last_full_us = 0;
+static int64_t session_start = 0;
+
+static bool read_line(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return false;
+
+    bool ok = fgets(buf, (int)size, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        trim_newline(buf);
+    return ok;
+}
+
+static bool write_str(const char* path, const char* value) {
+    int fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1)
+        return false;
+
+    bool ok = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+    return ok;
+}
+
+static void save_and_write(const char* knob, const char* value) {
+    char path[MAX_PATH_LENGTH * 2];
+    char old[32] = {0};
+    snprintf(path, sizeof(path), "%s%s", root_dir, knob);
+    if (!read_line(path, old, sizeof(old)))
+        return;
+
+    bool known = false;
+    for (int i = 0; i < nr_saved; i++)
+        known |= strcmp(saved[i].path, path) == 0;
+
+    if (!known && nr_saved < MAX_VM_SAVED) {
+        snprintf(saved[nr_saved].path, sizeof(saved[nr_saved].path), "%s", path);
+        snprintf(saved[nr_saved].value, sizeof(saved[nr_saved].value), "%s", old);
+        nr_saved++;
+    }
+
+    if (!write_str(path, value))
+        log_zenith(LOG_DEBUG, "VM tune: unable to write %s", path);
+}
+
+/***********************************************************************************
+ * Function Name      : psi_read
+ * Inputs             : some_us (uint64_t *) - total "some" stall time
+ *                      full_us (uint64_t *) - total "full" stall time
+ * Returns            : int - "some" avg10 in hundredths of a percent, -1 on failure
+ * Description        : Parses /proc/pressure/memory through a persistent fd.
+ ***********************************************************************************/
+static int psi_read(uint64_t* some_us, uint64_t* full_us) {
+    char buf[256] = {0};
+    if (psi_fd == -1 || pread(psi_fd, buf, sizeof(buf) - 1, 0) <= 0)
+        return -1;
+
+    // some avg10=1.23 avg60=0.50 avg300=0.10 total=123456
+    // full avg10=0.00 avg60=0.00 avg300=0.00 total=4567
+    unsigned int whole = 0;
+    unsigned int frac = 0;
+    unsigned long long some = 0;
+    unsigned long long full = 0;
+    char* full_line = strstr(buf, "full");
+    char* some_total = strstr(buf, "total=");
+    if (sscanf(buf, "some avg10=%u.%u", &whole, &frac) != 2 || !some_total)
+        return -1;
+    some = strtoull(some_total + 6, NULL, 10);
+    if (full_line && (full_line = strstr(full_line, "total=")))
+        full = strtoull(full_line + 6, NULL, 10);
+
+    *some_us = some;
+    *full_us = full;
+    return (int)(whole * 100 + frac);
+}
+
+/***********************************************************************************
+ * Function Name      : vm_ctl_reset
+ * Inputs             : c (VmCtl *) - controller state
+ * Returns            : None
+ * Description        : Watermark back at the profile value, hold-off cleared.
+ ***********************************************************************************/
+void vm_ctl_reset(VmCtl* c) {
+    c->level = 0;
+    c->hold = 0;
+}
+
+/***********************************************************************************
+ * Function Name      : vm_ctl_update
+ * Inputs             : c (VmCtl *) - controller state
+ *                      some_avg10 (int) - memory "some" pressure, 1/100 percent
+ * Returns            : int - number of watermark steps above the profile value
+ * Description        : Raises watermark_scale_factor one step while memory
+ *                      pressure stays above VM_PSI_HIGH, so kswapd starts earlier
+ *                      and the game thread stops doing direct reclaim. Drops it
+ *                      one step at a time once pressure is back under VM_PSI_LOW.
+ * Note               : Has no side effects, feed it recorded PSI traces to test.
+ ***********************************************************************************/
+int vm_ctl_update(VmCtl* c, int some_avg10) {
+    if (c->hold > 0) {
+        c->hold--;
+        return c->level;
+    }
+
+    if (some_avg10 >= VM_PSI_HIGH && c->level < VM_MAX_LEVEL) {
+        c->level++;
+        c->hold = VM_STEP_HOLD;
+    } else if (some_avg10 <= VM_PSI_LOW && c->level > 0) {
+        c->level--;
+        c->hold = VM_RELEASE_HOLD;
+    }
+
+    return c->level;
+}
+
+/***********************************************************************************
+ * Function Name      : vm_tune_init
+ * Inputs             : root (const char *) - filesystem root, NULL for /
+ * Returns            : bool - true if PSI is available for the adaptive part
+ * Description        : Checks for zram writeback and memory PSI.
+ ***********************************************************************************/
+bool vm_tune_init(const char* root) {
+    snprintf(root_dir, sizeof(root_dir), "%s", root ? root : "");
+
+    char path[MAX_PATH_LENGTH * 2];
+    char buf[MAX_LINE] = {0};
+    snprintf(path, sizeof(path), "%s/sys/block/zram0/backing_dev", root_dir);
+    zram_writeback = read_line(path, buf, sizeof(buf)) && buf[0] && strcmp(buf, "none") != 0;
+
+    // The compressor can't change while zram is an active swap device, only report it
+    snprintf(path, sizeof(path), "%s/sys/block/zram0/comp_algorithm", root_dir);
+    if (read_line(path, buf, sizeof(buf)))
+        log_zenith(LOG_DEBUG, "VM tune: zram compressors %s, writeback %s", buf, zram_writeback ? "on" : "off");
+
+    snprintf(path, sizeof(path), "%s/proc/pressure/memory", root_dir);
+    psi_fd = open(path, O_RDONLY | O_CLOEXEC);
+    has_psi = psi_fd != -1;
+    if (!has_psi)
+        log_zenith(LOG_INFO, "VM tune: no memory PSI, watermark stays static");
+    return has_psi;
+}
+
+static void lmk_apply(bool perf) {
+    size_t count = sizeof(lmk_props) / sizeof(lmk_props[0]);
+    if (perf == lmk_changed)
+        return;
+
+    for (size_t i = 0; i < count; i++) {
+        if (perf) {
+            saved_lmk[i][0] = '\0';
+            __system_property_get(lmk_props[i].name, saved_lmk[i]);
+            systemv("resetprop -n %s %s", lmk_props[i].name, lmk_props[i].perf);
+        } else if (saved_lmk[i][0]) {
+            systemv("resetprop -n %s %s", lmk_props[i].name, saved_lmk[i]);
+        } else {
+            systemv("resetprop --delete %s", lmk_props[i].name);
+        }
+    }
+
+    // lmkd only reads ro.lmk.* at start or on reinit
+    __system_property_set("lmkd.reinit", "1");
+    lmk_changed = perf;
+}
+
+static void session_end(void) {
+    if (!session)
+        return;
+
+    session = false;
+    log_zenith(LOG_INFO, "VM tune: memory stall during session %llums some, %llums full over %llds",
+               (unsigned long long)(stats.session_stall_some_us / 1000),
+               (unsigned long long)(stats.session_stall_full_us / 1000),
+               (long long)((now_ms() - session_start) / 1000));
+}
+
+/***********************************************************************************
+ * Function Name      : vm_tune_restore
+ * Inputs             : None
+ * Returns            : None
+ * Description        : Ends the stall accounting and writes every saved knob and
+ *                      lmkd property back.
+ ***********************************************************************************/
+void vm_tune_restore(void) {
+    session_end();
+
+    for (int i = nr_saved - 1; i >= 0; i--)
+        write_str(saved[i].path, saved[i].value);
+    nr_saved = 0;
+
+    if (lmk_changed)
+        lmk_apply(false);
+}
+
+/***********************************************************************************
+ * Function Name      : vm_tune_apply
+ * Inputs             : mode (ProfileMode) - profile being applied
+ * Returns            : None
+ * Description        : Restores the previous profile's changes, then writes the
+ *                      table of the new one. Performance also starts a stall
+ *                      accounting session, balanced keeps the system values.
+ ***********************************************************************************/
+void vm_tune_apply(ProfileMode mode) {
+    vm_tune_restore();
+
+    if (mode == PERFORMANCE_PROFILE) {
+        for (size_t i = 0; i < sizeof(vm_knobs) / sizeof(vm_knobs[0]); i++)
+            save_and_write(vm_knobs[i].path, vm_knobs[i].perf);
+        if (zram_writeback) {
+            for (size_t i = 0; i < sizeof(zram_knobs) / sizeof(zram_knobs[0]); i++)
+                save_and_write(zram_knobs[i].path, zram_knobs[i].perf);
+        }
+        lmk_apply(true);
+
+        base_wmark = atoi(vm_knobs[1].perf);
+        vm_ctl_reset(&ctl);
+        session = psi_read(&last_some_us, &last_full_us) >= 0;
+        stats.session_stall_some_us = 0;
+        stats.session_stall_full_us = 0;
+        session_start = now_ms();
+    } else if (mode == ECO_MODE) {
+        for (size_t i = 0; i < sizeof(vm_knobs) / sizeof(vm_knobs[0]); i++) {
+            if (vm_knobs[i].eco)
+                save_and_write(vm_knobs[i].path, vm_knobs[i].eco);
+        }
+    }
+}
+
+/***********************************************************************************
+ * Function Name      : vm_tune_tick
+ * Inputs             : None
+ * Returns            : None
+ * Description        : One PSI sample of the performance session. Adds the stall
+ *                      time since the last sample to the stats and moves the
+ *                      watermark within VM_MAX_LEVEL steps of the profile value.
+ ***********************************************************************************/
+void vm_tune_tick(void) {
+    if (!session)
+        return;
+
+    uint64_t some_us;
+    uint64_t full_us;
+    int avg10 = psi_read(&some_us, &full_us);
+    if (avg10 < 0)
+        return;
+
+    if (some_us >= last_some_us && full_us >= last_full_us) {
+        stats.session_stall_some_us += some_us - last_some_us;
+        stats.session_stall_full_us += full_us - last_full_us;
+        stats.mem_stall_some_us += some_us - last_some_us;
+        stats.mem_stall_full_us += full_us - last_full_us;
+    }
+    last_some_us = some_us;
+    last_full_us = full_us;
+
+    int prev = ctl.level;
+    int level = vm_ctl_update(&ctl, avg10);
+    if (level == prev)
+        return;
+
+    char path[MAX_PATH_LENGTH * 2];
+    char value[16];
+    snprintf(path, sizeof(path), "%s%s", root_dir, vm_knobs[1].path);
+    snprintf(value, sizeof(value), "%d", base_wmark + level * VM_WMARK_STEP);
+    write_str(path, value);
+    stats.vm_adjustments++;
+    log_zenith(LOG_DEBUG, "VM tune: memory pressure %d.%02d%%, watermark_scale_factor %s", avg10 / 100, avg10 % 100,
+               value);
+}
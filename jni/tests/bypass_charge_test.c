@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/bypass_charge.c
+
+#include "test_util.h"
+
+#define BYPASS_NODE "/sys/devices/platform/charger/bypass_charger"
+
+static const char* const state_names[] = {"idle", "verifying", "engaged", "failed"};
+
+static void replay(const char* root, const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        exit(2);
+    }
+
+    char line[MAX_DATA_LENGTH];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lineno++;
+        trim_newline(line);
+        if (line[0] == '\0' || line[0] == '#')
+            continue;
+
+        if (strcmp(line, "!tick") == 0) {
+            bypass_charge_tick();
+        } else if (strncmp(line, "!expect ", 8) == 0) {
+            char want_node[8] = {0};
+            char want_state[16] = {0};
+            char node[32];
+            sscanf(line + 8, "%7s %15s", want_node, want_state);
+            test_read(root, BYPASS_NODE, node, sizeof(node));
+
+            const char* got_state = state_names[bypass_charge_state()];
+            if (strcmp(node, want_node) != 0 || strcmp(got_state, want_state) != 0) {
+                fprintf(stderr, "%s:%d: expected node %s state %s, got node %s state %s\n", path, lineno, want_node,
+                        want_state, node, got_state);
+                test_failures++;
+            }
+        } else {
+            // Recorded with '|' for the NUL separators of the netlink message
+            size_t len = strlen(line);
+            for (size_t i = 0; i < len; i++) {
+                if (line[i] == '|')
+                    line[i] = '\0';
+            }
+            bypass_handle_uevent(line, len + 1);
+        }
+    }
+    fclose(fp);
+}
+
+// Each trace gets a fresh process, the controller keeps its state in statics
+static void run_trace(const char* trace, bool with_chargers) {
+    char* root = test_mktree();
+    pid_t pid = fork();
+    if (pid == 0) {
+        test_write(root, BYPASS_NODE, "0");
+        test_write(root, PROFILE_MODE, "1");
+        test_write(root, "/sys/class/power_supply/battery/status", "Discharging");
+        test_write(root, "/sys/class/power_supply/battery/current_now", "-420000");
+        if (with_chargers) {
+            test_write(root, "/sys/class/power_supply/usb/online", "0");
+            test_write(root, "/sys/class/power_supply/ac/online", "0");
+        }
+
+        CHECK(bypass_charge_init(root));
+        replay(root, trace);
+        _exit(test_failures ? 1 : 0);
+    }
+
+    int status = -1;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s: replay failed\n", trace);
+        test_failures++;
+    }
+}
+
+int main(void) {
+    test_setprop("persist.sys.azenithconf.bypasspath", "MTK_BYPASS_CHARGER");
+    test_setprop("persist.sys.azenithconf.bypasschg", "1");
+
+    run_trace(TEST_DATA "/bypass_session.uevents", true);
+    // No usb/ac nodes, plug state only comes from the battery status
+    run_trace(TEST_DATA "/bypass_battery_only.uevents", false);
+    return test_done("bypass_charge");
+}
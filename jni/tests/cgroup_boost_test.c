@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/cgroup_boost.c
+
+#include "test_util.h"
+
+#define GAME_PID 1234
+
+static const char* const groups[] = {"top-app", "foreground", CGROUP_BOOST_GROUP};
+
+// A real cgroupfs creates the attribute files with the group, the mock needs them up front
+static void mock_group(const char* root, const char* base, const char* group, bool v2) {
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s/cpu.uclamp.min", base, group);
+    test_write(root, path, "0");
+    snprintf(path, sizeof(path), "%s/%s/cpu.uclamp.latency_sensitive", base, group);
+    test_write(root, path, "0");
+    snprintf(path, sizeof(path), "%s/%s/%s", base, group, v2 ? "cpu.weight" : "cpu.shares");
+    test_write(root, path, v2 ? "100" : "1024");
+    snprintf(path, sizeof(path), "%s/%s/%s", base, group, v2 ? "cgroup.procs" : "tasks");
+    test_write(root, path, "");
+}
+
+static void mock_game(const char* root, const char* cgroup_line) {
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "/proc/%d/cgroup", GAME_PID);
+    test_write(root, path, cgroup_line);
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", GAME_PID, GAME_PID + 1);
+    test_write(root, path, "");
+}
+
+static void check_attr(const char* root, const char* base, const char* group, const char* attr, const char* want) {
+    char path[MAX_PATH_LENGTH];
+    char buf[32];
+    snprintf(path, sizeof(path), "%s/%s/%s", base, group, attr);
+    test_read(root, path, buf, sizeof(buf));
+    if (strcmp(buf, want) != 0) {
+        fprintf(stderr, "%s: expected %s, got %s\n", path, want, buf);
+        test_failures++;
+    }
+}
+
+static void check_untouched(const char* root, const char* base, bool v2) {
+    for (size_t i = 0; i < sizeof(groups) / sizeof(groups[0]); i++) {
+        check_attr(root, base, groups[i], "cpu.uclamp.min", "0");
+        check_attr(root, base, groups[i], "cpu.uclamp.latency_sensitive", "0");
+        check_attr(root, base, groups[i], v2 ? "cpu.weight" : "cpu.shares", v2 ? "100" : "1024");
+    }
+}
+
+static void test_v1(void) {
+    char* root = test_mktree();
+    const char* base = "/dev/cpuctl";
+    mock_group(root, base, "top-app", false);
+    mock_group(root, base, "foreground", false);
+    mock_game(root, "4:cpuset:/top-app\n3:cpu:/top-app");
+
+    CHECK(cgroup_boost_init(root));
+    mock_group(root, base, CGROUP_BOOST_GROUP, false);
+
+    cgroup_boost_apply(PERFORMANCE_PROFILE, GAME_PID);
+    check_attr(root, base, "top-app", "cpu.uclamp.min", "30");
+    check_attr(root, base, "top-app", "cpu.shares", "2048");
+    check_attr(root, base, CGROUP_BOOST_GROUP, "cpu.uclamp.min", "50");
+    check_attr(root, base, CGROUP_BOOST_GROUP, "cpu.uclamp.latency_sensitive", "1");
+    check_attr(root, base, CGROUP_BOOST_GROUP, "cpu.shares", "4096");
+    check_attr(root, base, CGROUP_BOOST_GROUP, "tasks", "1235");
+
+    // Switching profiles restores first, eco must not be saved as the original
+    cgroup_boost_apply(ECO_MODE, 0);
+    check_attr(root, base, "foreground", "cpu.uclamp.min", "0");
+    check_attr(root, base, CGROUP_BOOST_GROUP, "cpu.uclamp.min", "0");
+    check_attr(root, base, "top-app", "tasks", "1235");
+
+    cgroup_boost_apply(PERFORMANCE_PROFILE, GAME_PID);
+    cgroup_boost_restore();
+    check_untouched(root, base, false);
+
+    // Balanced keeps the system values
+    cgroup_boost_apply(BALANCED_PROFILE, 0);
+    check_untouched(root, base, false);
+}
+
+static void test_v2(void) {
+    char* root = test_mktree();
+    const char* base = "/sys/fs/cgroup";
+    test_write(root, "/sys/fs/cgroup/cgroup.controllers", "cpuset cpu io memory pids");
+    mock_group(root, base, "top-app", true);
+    mock_group(root, base, "foreground", true);
+    mock_game(root, "0::/top-app");
+
+    CHECK(cgroup_boost_init(root));
+    mock_group(root, base, CGROUP_BOOST_GROUP, true);
+
+    cgroup_boost_apply(PERFORMANCE_PROFILE, GAME_PID);
+    check_attr(root, base, "top-app", "cpu.weight", "200");
+    check_attr(root, base, CGROUP_BOOST_GROUP, "cpu.weight", "400");
+    check_attr(root, base, CGROUP_BOOST_GROUP, "cgroup.procs", "1234");
+
+    cgroup_boost_restore();
+    check_untouched(root, base, true);
+    check_attr(root, base, "top-app", "cgroup.procs", "1234");
+}
+
+int main(void) {
+    test_v1();
+    test_v2();
+    return test_done("cgroup_boost");
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/cmd_utils.c
+
+#include "test_util.h"
+
+#define DEADLINE_MS 300
+
+// Each stub leaves a background child in its process group and records its
+// pid in <name>.pid next to it, the hanger ignores SIGTERM
+static const char sleeper[] =
+    "#!/bin/sh\n"
+    "/bin/sleep 30 &\n"
+    "echo $! > \"$0.pid\"\n"
+    "wait";
+
+static const char hanger[] =
+    "#!/bin/sh\n"
+    "trap '' TERM\n"
+    "/bin/sleep 30 &\n"
+    "echo $! > \"$0.pid\"\n"
+    "wait";
+
+static void install(const char* root, const char* name, const char* script, char* path, size_t size) {
+    char rel[MAX_PATH_LENGTH];
+    snprintf(rel, sizeof(rel), "/%s", name);
+    test_write(root, rel, script);
+    snprintf(path, size, "%s%s", root, rel);
+    chmod(path, 0755);
+}
+
+// The background child has to go with the group, not outlive the command
+static bool group_gone(const char* root, const char* pid_file) {
+    char buf[16];
+    pid_t pid = atoi(test_read(root, pid_file, buf, sizeof(buf)));
+    if (pid <= 0)
+        return false;
+
+    for (int i = 0; i < 100; i++) {
+        char stat[MAX_PATH_LENGTH];
+        char state = 0;
+        snprintf(stat, sizeof(stat), "/proc/%d/stat", pid);
+        FILE* fp = fopen(stat, "r");
+        if (!fp)
+            return true;
+        // Reparented and killed, a zombie until its new parent reaps it
+        bool zombie = fscanf(fp, "%*d %*s %c", &state) == 1 && state == 'Z';
+        fclose(fp);
+        if (zombie)
+            return true;
+        usleep(10 * 1000);
+    }
+    return false;
+}
+
+int main(void) {
+    char* root = test_mktree();
+    char exit3[MAX_PATH_LENGTH * 2];
+    char sleep_stub[MAX_PATH_LENGTH * 2];
+    char hang_stub[MAX_PATH_LENGTH * 2];
+    install(root, "exit3", "#!/bin/sh\necho ok\nexit 3", exit3, sizeof(exit3));
+    install(root, "sleeper", sleeper, sleep_stub, sizeof(sleep_stub));
+    install(root, "hanger", hanger, hang_stub, sizeof(hang_stub));
+
+    // Exit status and output come through, nothing counted as a timeout
+    CHECK_EQ(systemv_deadline(DEADLINE_MS, "%s >/dev/null", exit3), 3);
+    FILE* fp = popen_deadline(DEADLINE_MS, "%s", exit3);
+    char line[MAX_LINE] = {0};
+    CHECK(fp && fgets(line, sizeof(line), fp) && strcmp(line, "ok\n") == 0);
+    if (fp)
+        fclose(fp);
+    CHECK_EQ(stats.cmd_runs, 2);
+    CHECK_EQ(stats.cmd_timeouts, 0);
+
+    // Past the deadline SIGTERM takes down the whole group
+    int64_t start = now_ms();
+    CHECK_EQ(systemv_deadline(DEADLINE_MS, "%s", sleep_stub), -1);
+    int64_t took = now_ms() - start;
+    CHECK(took >= DEADLINE_MS && took < DEADLINE_MS + CMD_KILL_GRACE_MS);
+    CHECK_EQ(stats.cmd_timeouts, 1);
+    CHECK_EQ(stats.cmd_hangs, 0);
+    CHECK(group_gone(root, "/sleeper.pid"));
+
+    // The shell goes on SIGTERM, what it started ignores it and still goes
+    start = now_ms();
+    CHECK_EQ(systemv_deadline(DEADLINE_MS, "%s", hang_stub), -1);
+    took = now_ms() - start;
+    CHECK(took < DEADLINE_MS + CMD_KILL_GRACE_MS);
+    CHECK_EQ(stats.cmd_timeouts, 2);
+    CHECK_EQ(stats.cmd_hangs, 0);
+    CHECK(group_gone(root, "/hanger.pid"));
+
+    // A child that ignores SIGTERM itself gets SIGKILL after the grace period
+    start = now_ms();
+    CHECK_EQ(systemv_deadline(DEADLINE_MS, "exec %s", hang_stub), -1);
+    took = now_ms() - start;
+    CHECK(took >= DEADLINE_MS + CMD_KILL_GRACE_MS && took < DEADLINE_MS + CMD_KILL_GRACE_MS + 1000);
+    CHECK_EQ(stats.cmd_timeouts, 3);
+    CHECK_EQ(stats.cmd_hangs, 1);
+    CHECK(group_gone(root, "/hanger.pid"));
+    CHECK_EQ(stats.cmd_runs, 5);
+
+    return test_done("cmd_utils");
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/display_control.c
+
+#include "test_util.h"
+
+// Stand-in for the helper shell: cmd only records its arguments, get-displays
+// answers 90Hz, followed by a dump larger than the reply buffer while the big
+// marker exists. A command received while the crash marker exists is the last.
+static const char stub_helper[] =
+    "#!/bin/sh\n"
+    "dir=\"${0%/*}\"\n"
+    "cmd() {\n"
+    "    echo \"cmd $*\" >> \"$dir/commands.log\"\n"
+    "    if [ \"$1 $2\" = \"display get-displays\" ]; then\n"
+    "        echo 'mode={id=1, fps=120.0} renderFrameRate 90.00001 vsyncRate 90.0'\n"
+    "        i=0\n"
+    "        while [ -e \"$dir/big\" ] && [ $i -lt 400 ]; do\n"
+    "            echo \"  layer $i {bounds=[0,0][1080,2400]}\"\n"
+    "            i=$((i + 1))\n"
+    "        done\n"
+    "    fi\n"
+    "    return 0\n"
+    "}\n"
+    "while read -r line; do\n"
+    "    [ -e \"$dir/crash\" ] && { eval \"$line\"; exit 0; }\n"
+    "    eval \"$line\"\n"
+    "done";
+
+static char log_path[MAX_PATH_LENGTH * 2];
+
+static int log_lines(char* last, size_t size) {
+    FILE* fp = fopen(log_path, "r");
+    if (!fp)
+        return 0;
+
+    int n = 0;
+    char line[MAX_LINE];
+    while (fgets(line, sizeof(line), fp)) {
+        n++;
+        snprintf(last, size, "%s", trim_newline(line));
+    }
+    fclose(fp);
+    return n;
+}
+
+int main(void) {
+    char* root = test_mktree();
+    char helper[MAX_PATH_LENGTH * 2];
+    char crash[MAX_PATH_LENGTH * 2];
+    char big[MAX_PATH_LENGTH * 2];
+    char last[MAX_LINE] = {0};
+    snprintf(helper, sizeof(helper), "%s/helper", root);
+    snprintf(crash, sizeof(crash), "%s/crash", root);
+    snprintf(big, sizeof(big), "%s/big", root);
+    snprintf(log_path, sizeof(log_path), "%s/commands.log", root);
+
+    test_write(root, "/helper", stub_helper);
+    chmod(helper, 0755);
+    CHECK(display_helper_start(helper));
+    CHECK_EQ(stats.forks, 1);
+
+    // One round trip each, the get answer is parsed and cached. Output past the
+    // reply buffer is dropped, not taken for a hung helper
+    test_write(root, "/big", "");
+    CHECK_EQ(display_get_refresh_rate(), 90);
+    unlink(big);
+    CHECK_EQ(log_lines(last, sizeof(last)), 1);
+    CHECK(strcmp(last, "cmd display get-displays") == 0);
+    CHECK_EQ(display_get_refresh_rate(), 90);
+    CHECK_EQ(log_lines(last, sizeof(last)), 1);
+
+    CHECK(display_set_refresh_rate(120));
+    CHECK_EQ(log_lines(last, sizeof(last)), 3);
+    CHECK(strcmp(last, "cmd settings put system min_refresh_rate 120.0") == 0);
+    CHECK_EQ(display_get_refresh_rate(), 120);
+    CHECK_EQ(stats.forks, 1);
+
+    // A helper that dies is respawned, without SIGPIPE taking the daemon down
+    test_write(root, "/crash", "");
+    CHECK(display_set_refresh_rate(60));
+    usleep(200 * 1000);
+    CHECK(display_set_refresh_rate(144));
+    CHECK_EQ(log_lines(last, sizeof(last)), 7);
+    CHECK(strcmp(last, "cmd settings put system min_refresh_rate 144.0") == 0);
+    CHECK_EQ(stats.forks, 2);
+    unlink(crash);
+
+    // The session rate comes back once the game is gone
+    display_save_refresh_rate();
+    CHECK(display_set_refresh_rate(60));
+    display_restore_refresh_rate();
+    CHECK_EQ(log_lines(last, sizeof(last)), 11);
+    CHECK(strcmp(last, "cmd settings put system min_refresh_rate 144.0") == 0);
+
+    display_helper_stop();
+    return test_done("display_control");
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/footprint.c src/cpuset.c src/cpu_topology.c
+
+#include "test_util.h"
+#include <sched.h>
+
+#define GROUP_FILE(base, file) base "/" FOOTPRINT_GROUP "/" file
+
+static char pid_str[16];
+
+// The kernel creates the group files on mkdir, the mock has them up front
+static char* mock_tree(void) {
+    char* root = test_mktree();
+    test_write(root, "/sys/devices/system/cpu/online", "0-7");
+    cpuset_init(root);
+    return root;
+}
+
+static void check_file(const char* root, const char* path, const char* want) {
+    char buf[MAX_LINE];
+    test_read(root, path, buf, sizeof(buf));
+    if (strcmp(buf, want) != 0) {
+        fprintf(stderr, "%s: expected \"%s\", got \"%s\"\n", path, want, buf);
+        test_failures++;
+    }
+}
+
+static void test_v1_noprefix(void) {
+    char* root = mock_tree();
+    test_write(root, "/dev/cpuset/cpus", "0-7");
+    test_write(root, "/dev/cpuset/mems", "0");
+    test_write(root, GROUP_FILE("/dev/cpuset", "cpus"), "");
+    test_write(root, GROUP_FILE("/dev/cpuset", "mems"), "");
+    test_write(root, GROUP_FILE("/dev/cpuset", "cgroup.procs"), "");
+
+    struct rlimit before;
+    getrlimit(RLIMIT_DATA, &before);
+
+    CHECK(footprint_init(root));
+    check_file(root, GROUP_FILE("/dev/cpuset", "cpus"), "0-3");
+    check_file(root, GROUP_FILE("/dev/cpuset", "mems"), "0");
+    check_file(root, GROUP_FILE("/dev/cpuset", "cgroup.procs"), pid_str);
+
+    // Capped for the daemon only
+    struct rlimit now;
+    getrlimit(RLIMIT_DATA, &now);
+    if (before.rlim_max == RLIM_INFINITY || before.rlim_max > ((rlim_t)FOOTPRINT_DATA_MB << 20))
+        CHECK(now.rlim_cur == (rlim_t)FOOTPRINT_DATA_MB << 20);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        footprint_child_reset();
+        footprint_idle_child();
+
+        int bad = 0;
+        struct rlimit child;
+        getrlimit(RLIMIT_DATA, &child);
+        if (child.rlim_cur != before.rlim_cur)
+            bad |= 1;
+        if (sched_getscheduler(0) != SCHED_IDLE)
+            bad |= 2;
+        if (syscall(SYS_ioprio_get, 1, 0) != 3 << 13)
+            bad |= 4;
+        _exit(bad);
+    }
+    int status = -1;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status));
+    CHECK_EQ(WEXITSTATUS(status), 0);
+
+    test_write(root, "/proc/self/statm", "51200 1000 300 10 0 2000 0");
+    footprint_sample();
+    CHECK_EQ(stats.self_rss_kb, 1000 * sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void test_v1_prefixed(void) {
+    char* root = mock_tree();
+    test_write(root, "/dev/cpuset/cpuset.cpus", "0-7");
+    test_write(root, "/dev/cpuset/cpuset.mems", "0");
+    test_write(root, GROUP_FILE("/dev/cpuset", "cpuset.cpus"), "");
+    test_write(root, GROUP_FILE("/dev/cpuset", "cpuset.mems"), "");
+    test_write(root, GROUP_FILE("/dev/cpuset", "cgroup.procs"), "");
+
+    CHECK(footprint_init(root));
+    check_file(root, GROUP_FILE("/dev/cpuset", "cpuset.cpus"), "0-3");
+    check_file(root, GROUP_FILE("/dev/cpuset", "cpuset.mems"), "0");
+    check_file(root, GROUP_FILE("/dev/cpuset", "cgroup.procs"), pid_str);
+}
+
+static void test_v2(void) {
+    char* root = mock_tree();
+    test_write(root, "/sys/fs/cgroup/cgroup.controllers", "cpuset cpu io memory pids");
+    test_write(root, "/sys/fs/cgroup/cgroup.subtree_control", "");
+    test_write(root, "/sys/fs/cgroup/cpuset.mems", "0");
+    test_write(root, GROUP_FILE("/sys/fs/cgroup", "cpuset.cpus"), "");
+    test_write(root, GROUP_FILE("/sys/fs/cgroup", "cpuset.mems"), "");
+    test_write(root, GROUP_FILE("/sys/fs/cgroup", "cgroup.procs"), "");
+
+    CHECK(footprint_init(root));
+    check_file(root, "/sys/fs/cgroup/cgroup.subtree_control", "+cpuset");
+    check_file(root, GROUP_FILE("/sys/fs/cgroup", "cpuset.cpus"), "0-3");
+    check_file(root, GROUP_FILE("/sys/fs/cgroup", "cgroup.procs"), pid_str);
+}
+
+static void test_unrestricted(void) {
+    // Without a cpuset controller the daemon stays where it is
+    char* root = mock_tree();
+    test_write(root, "/sys/fs/cgroup/cgroup.controllers", "cpu io memory");
+    CHECK(!footprint_init(root));
+
+    // Nor on a single cluster, there is nothing to stay off
+    nr_clusters = 1;
+    root = mock_tree();
+    test_write(root, "/dev/cpuset/cpus", "0-7");
+    CHECK(!footprint_init(root));
+    nr_clusters = 2;
+}
+
+int main(void) {
+    snprintf(pid_str, sizeof(pid_str), "%d", getpid());
+    nr_clusters = 2;
+    clusters[0].cpu_mask = 0x0f;
+    clusters[1].cpu_mask = 0xf0;
+
+    test_v1_noprefix();
+    test_v1_prefixed();
+    test_v2();
+    test_unrestricted();
+    return test_done("footprint");
+}
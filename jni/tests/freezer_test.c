@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/freezer.c
+
+#include "test_util.h"
+
+static void add_proc(const char* root, int uid, pid_t pid, int adj, const char* cmdline) {
+    char path[MAX_PATH_LENGTH];
+    char value[MAX_LINE];
+
+    snprintf(path, sizeof(path), "/proc/%d/oom_score_adj", pid);
+    snprintf(value, sizeof(value), "%d", adj);
+    test_write(root, path, value);
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    snprintf(value, sizeof(value), "Name:\tapp\nUid:\t%d\t%d\t%d\t%d", uid, uid, uid, uid);
+    test_write(root, path, value);
+    snprintf(path, sizeof(path), "/proc/%d/cmdline", pid);
+    test_write(root, path, cmdline);
+    snprintf(path, sizeof(path), "/sys/fs/cgroup/uid_%d/pid_%d/cgroup.freeze", uid, pid);
+    test_write(root, path, "0");
+    snprintf(path, sizeof(path), "/sys/fs/cgroup/uid_%d/cgroup.freeze", uid);
+    test_write(root, path, "0");
+}
+
+static bool frozen(const char* root, const char* path) {
+    char buf[8];
+    return strcmp(test_read(root, path, buf, sizeof(buf)), "1") == 0;
+}
+
+int main(void) {
+    char* root = test_mktree();
+    test_write(root, "/sys/fs/cgroup/uid_1000/cgroup.freeze", "0");
+
+    add_proc(root, 10100, 200, 900, "com.cached.app");
+    add_proc(root, 10100, 201, 905, "com.cached.app:sync");
+    // Visible process next to a cached one, the uid group has to stay thawed
+    add_proc(root, 10200, 300, 900, "com.mixed.app:bg");
+    add_proc(root, 10200, 301, 0, "com.mixed.app");
+    add_proc(root, 10300, 400, 900, "com.whatsapp");
+    add_proc(root, 10400, 500, 900, "com.game.x");
+
+    CHECK(freezer_init(root));
+    CHECK_EQ(freezer_freeze(500), 2);
+    CHECK(frozen(root, "/sys/fs/cgroup/uid_10100/cgroup.freeze"));
+    CHECK(!frozen(root, "/sys/fs/cgroup/uid_10200/cgroup.freeze"));
+    CHECK(!frozen(root, "/sys/fs/cgroup/uid_10300/cgroup.freeze"));
+    CHECK(!frozen(root, "/sys/fs/cgroup/uid_10400/cgroup.freeze"));
+
+    // The per-process files belong to the framework's freezer
+    CHECK(!frozen(root, "/sys/fs/cgroup/uid_10100/pid_200/cgroup.freeze"));
+    CHECK(!frozen(root, "/sys/fs/cgroup/uid_10100/pid_201/cgroup.freeze"));
+
+    // A rescan does not freeze the same app twice
+    CHECK_EQ(freezer_freeze(500), 0);
+
+    // The framework freezes one of them meanwhile, thaw must not undo that
+    test_write(root, "/sys/fs/cgroup/uid_10100/pid_201/cgroup.freeze", "1");
+    freezer_thaw_all();
+    CHECK(!frozen(root, "/sys/fs/cgroup/uid_10100/cgroup.freeze"));
+    CHECK(frozen(root, "/sys/fs/cgroup/uid_10100/pid_201/cgroup.freeze"));
+
+    return test_done("freezer");
+}
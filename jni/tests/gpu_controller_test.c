@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/gpu_controller.c
+
+#include "test_util.h"
+
+#define GPU_DEV "/class/devfreq/3d00000.qcom,kgsl-3d0"
+#define GPU_BUSY "/class/kgsl/kgsl-3d0/gpu_busy_percentage"
+
+static const char* root;
+
+// One scripted sample: utilization and current frequency, then a tick
+static void sample(int util, const char* cur) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", util);
+    test_write(root, GPU_BUSY, buf);
+    test_write(root, GPU_DEV "/cur_freq", cur);
+    gpu_controller_tick();
+}
+
+static bool min_is(const char* want) {
+    char buf[32];
+    test_read(root, GPU_DEV "/min_freq", buf, sizeof(buf));
+    if (strcmp(buf, want) != 0) {
+        fprintf(stderr, "min_freq %s, expected %s\n", buf, want);
+        return false;
+    }
+    return true;
+}
+
+int main(void) {
+    root = test_mktree();
+    // Bus scaling node that also matches "gpu", never the one to drive
+    test_write(root, "/class/devfreq/soc:qcom,gpubw/min_freq", "0");
+    // Unsorted like some vendor kernels, every OPP the same width
+    test_write(root, GPU_DEV "/available_frequencies", "900000000 700000000 585000000 450000000 350000000 220000000");
+    test_write(root, GPU_DEV "/min_freq", "350000000");
+    test_write(root, GPU_DEV "/cur_freq", "350000000");
+    test_write(root, GPU_BUSY, "0");
+
+    CHECK(gpu_controller_init(root));
+
+    // First tick saves min_freq and drops the floor to the lowest OPP
+    sample(30, "350000000");
+    CHECK(min_is("220000000"));
+    CHECK_EQ(stats.gpu_floor_changes, 1);
+
+    // 95% at 450 MHz wants 610 MHz, the next OPP up is 700 MHz after GPU_UP_HOLD samples
+    for (int i = 1; i < GPU_UP_HOLD; i++)
+        sample(95, "450000000");
+    CHECK(min_is("220000000"));
+    sample(95, "450000000");
+    CHECK(min_is("700000000"));
+    CHECK_EQ(stats.gpu_floor_changes, 2);
+
+    // Between the thresholds the floor stays
+    for (int i = 0; i < 10; i++)
+        sample(60, "700000000");
+    CHECK(min_is("700000000"));
+
+    // Quiet samples walk it down one OPP per GPU_DOWN_HOLD
+    for (int i = 1; i < GPU_DOWN_HOLD; i++)
+        sample(20, "700000000");
+    CHECK(min_is("700000000"));
+    sample(20, "700000000");
+    CHECK(min_is("585000000"));
+    CHECK_EQ(stats.gpu_floor_changes, 3);
+
+    // Leaving performance gives the saved min_freq back, once
+    gpu_controller_stop();
+    CHECK(min_is("350000000"));
+    test_write(root, GPU_DEV "/min_freq", "450000000");
+    gpu_controller_stop();
+    CHECK(min_is("450000000"));
+
+    // The next session saves again and starts from the bottom
+    sample(50, "450000000");
+    CHECK(min_is("220000000"));
+    gpu_controller_stop();
+    CHECK(min_is("450000000"));
+
+    return test_done("gpu_controller");
+}
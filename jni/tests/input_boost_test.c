@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/input_boost.c src/cpu_topology.c
+
+#include "test_util.h"
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+#define MIN_FREQ "/sys/devices/system/cpu/cpufreq/policy7/scaling_min_freq"
+#define UCLAMP_MIN "/dev/cpuctl/top-app/cpu.uclamp.min"
+
+// Same width as every step, the module pwrites without truncating
+static const int prime_freqs[] = {1000000, 1400000, 1800000, 2100000, 2500000, 3000000};
+
+static int64_t fake_now = 100000;
+static int handler_fds[4];
+static EventHandler handlers[4];
+static int nr_handlers = 0;
+
+int64_t now_ms(void) {
+    return fake_now;
+}
+
+int event_loop_add(int fd, EventHandler handler) {
+    handler_fds[nr_handlers] = fd;
+    handlers[nr_handlers++] = handler;
+    return 0;
+}
+
+void event_loop_remove(int fd) {
+    for (int i = 0; i < nr_handlers; i++) {
+        if (handler_fds[i] == fd) {
+            handler_fds[i] = handler_fds[--nr_handlers];
+            handlers[i] = handlers[nr_handlers];
+            return;
+        }
+    }
+}
+
+// Waits for the registered fd to become readable and runs its handler
+static bool dispatch(int nth, int timeout_ms) {
+    if (nth >= nr_handlers)
+        return false;
+
+    struct pollfd pfd = {.fd = handler_fds[nth], .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) <= 0)
+        return false;
+    handlers[nth](handler_fds[nth]);
+    return true;
+}
+
+static void emit(int fd, int type, int code, int value) {
+    struct input_event ev = {.type = type, .code = code, .value = value};
+    CHECK(write(fd, &ev, sizeof(ev)) == sizeof(ev));
+}
+
+// Virtual touchscreen with BTN_TOUCH, its event node is returned in node
+static int uinput_open(char* node, size_t size) {
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    ioctl(fd, UI_SET_KEYBIT, BTN_TOUCH);
+    ioctl(fd, UI_SET_EVBIT, EV_ABS);
+    ioctl(fd, UI_SET_ABSBIT, ABS_MT_POSITION_X);
+    ioctl(fd, UI_SET_ABSBIT, ABS_MT_POSITION_Y);
+    ioctl(fd, UI_SET_ABSBIT, ABS_MT_TRACKING_ID);
+
+    struct uinput_user_dev dev = {0};
+    snprintf(dev.name, sizeof(dev.name), "azenith-test-touch");
+    dev.id.bustype = BUS_VIRTUAL;
+    dev.absmax[ABS_MT_POSITION_X] = 1079;
+    dev.absmax[ABS_MT_POSITION_Y] = 2399;
+    dev.absmax[ABS_MT_TRACKING_ID] = 65535;
+
+    char sysname[64] = {0};
+    char path[MAX_PATH_LENGTH];
+    if (write(fd, &dev, sizeof(dev)) != sizeof(dev) || ioctl(fd, UI_DEV_CREATE) < 0 ||
+        ioctl(fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "/sys/devices/virtual/input/%s", sysname);
+    DIR* dir = opendir(path);
+    struct dirent* entry;
+    node[0] = '\0';
+    while (dir && (entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "event", 5) == 0)
+            snprintf(node, size, "/dev/input/%s", entry->d_name);
+    }
+    if (dir)
+        closedir(dir);
+
+    // udev needs a moment to create the node
+    for (int i = 0; i < 50 && node[0] && access(node, R_OK) != 0; i++)
+        usleep(20 * 1000);
+    if (!node[0] || access(node, R_OK) != 0) {
+        ioctl(fd, UI_DEV_DESTROY);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void touch(int fd, bool btn_touch, bool down) {
+    static int tracking_id = 100;
+    emit(fd, EV_ABS, ABS_MT_TRACKING_ID, down ? tracking_id++ : -1);
+    if (down) {
+        emit(fd, EV_ABS, ABS_MT_POSITION_X, 540);
+        emit(fd, EV_ABS, ABS_MT_POSITION_Y, 1200);
+    }
+    if (btn_touch)
+        emit(fd, EV_KEY, BTN_TOUCH, down);
+    emit(fd, EV_SYN, SYN_REPORT, 0);
+}
+
+static bool node_is(const char* root, const char* path, const char* want) {
+    char buf[32];
+    test_read(root, path, buf, sizeof(buf));
+    if (strcmp(buf, want) != 0) {
+        fprintf(stderr, "%s: %s, expected %s\n", path, buf, want);
+        return false;
+    }
+    return true;
+}
+
+int main(void) {
+    char* root = test_mktree();
+    test_write(root, MIN_FREQ, "1000000");
+    test_write(root, UCLAMP_MIN, "10");
+
+    nr_clusters = 1;
+    clusters[0].policy = 7;
+    clusters[0].cpuinfo_min = 1000000;
+    clusters[0].cpuinfo_max = 3000000;
+    clusters[0].nr_freqs = (int)(sizeof(prime_freqs) / sizeof(prime_freqs[0]));
+    memcpy(clusters[0].freqs, prime_freqs, sizeof(prime_freqs));
+
+    // A real uinput touchscreen where the host allows it, otherwise a FIFO of
+    // raw events, which has no capabilities and takes the tracking id path
+    char node[MAX_PATH_LENGTH];
+    bool btn_touch = true;
+    int feed = uinput_open(node, sizeof(node));
+    if (feed == -1) {
+        btn_touch = false;
+        snprintf(node, sizeof(node), "%s/touch", root);
+        CHECK_EQ(mkfifo(node, 0600), 0);
+    }
+
+    CHECK(input_boost_init(root, node));
+    if (!btn_touch)
+        feed = open(node, O_WRONLY | O_CLOEXEC);
+    CHECK(feed != -1);
+    CHECK_EQ(nr_handlers, 1);
+
+    // Touches before enabling are dropped, not replayed later
+    touch(feed, btn_touch, true);
+    touch(feed, btn_touch, false);
+    input_boost_set_enabled(true);
+    CHECK_EQ(nr_handlers, 2);
+    CHECK(!dispatch(1, 50));
+    CHECK(!input_boost_active());
+
+    // Touch-down: 70% of the prime max snapped to 2100000, uclamp to the boost
+    touch(feed, btn_touch, true);
+    CHECK(dispatch(1, 1000));
+    CHECK(input_boost_active());
+    CHECK_EQ(stats.input_boosts, 1);
+    CHECK(node_is(root, MIN_FREQ, "2100000"));
+    CHECK(node_is(root, UCLAMP_MIN, "40"));
+
+    // Lifting the finger leaves the boost to decay, a new touch within the
+    // rate limit is suppressed
+    touch(feed, btn_touch, false);
+    CHECK(dispatch(1, 1000));
+    fake_now += 50;
+    touch(feed, btn_touch, true);
+    CHECK(dispatch(1, 1000));
+    CHECK_EQ(stats.input_boosts, 1);
+    CHECK_EQ(stats.input_boost_suppressed, 1);
+    touch(feed, btn_touch, false);
+    CHECK(dispatch(1, 1000));
+
+    // Decays one step per timer expiry, the last one restores the saved values
+    CHECK(dispatch(0, 1000));
+    CHECK(node_is(root, MIN_FREQ, "1800000"));
+    CHECK(node_is(root, UCLAMP_MIN, "32"));
+    CHECK(dispatch(0, 1000));
+    CHECK(node_is(root, MIN_FREQ, "1400000"));
+    CHECK(node_is(root, UCLAMP_MIN, "25"));
+    CHECK(dispatch(0, 1000));
+    CHECK(input_boost_active());
+    CHECK(dispatch(0, 1000));
+    CHECK(!input_boost_active());
+    CHECK(node_is(root, MIN_FREQ, "1000000"));
+    CHECK(node_is(root, UCLAMP_MIN, "10"));
+
+    // Disabling releases a running boost at once and stops polling the device
+    fake_now += 1000;
+    touch(feed, btn_touch, true);
+    CHECK(dispatch(1, 1000));
+    CHECK(input_boost_active());
+    CHECK_EQ(stats.input_boosts, 2);
+    input_boost_set_enabled(false);
+    CHECK(!input_boost_active());
+    CHECK(node_is(root, MIN_FREQ, "1000000"));
+    CHECK(node_is(root, UCLAMP_MIN, "10"));
+    CHECK_EQ(nr_handlers, 1);
+
+    if (btn_touch)
+        ioctl(feed, UI_DEV_DESTROY);
+    close(feed);
+    return test_done("input_boost");
+}
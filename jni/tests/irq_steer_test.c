@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/irq_steer.c src/cpuset.c src/cpu_topology.c
+
+#include "test_util.h"
+
+#define GAME_PID 1234
+
+// Trimmed /proc/interrupts of an 8 cpu SoC, counters shortened
+static const char interrupts[] =
+    "           CPU0       CPU1       CPU2       CPU3       CPU4       CPU5       CPU6       CPU7\n"
+    " 11:        120          0          0          0          0          0          0          0     GICv3  27 Level     arch_timer\n"
+    " 45:       8812          0          0          0          0          0          0          0     GICv3 168 Level     fts_ts\n"
+    "210:      99120         12          0          0          0          0          0          0     GICv3 332 Level     kgsl_3d0_irq\n"
+    "211:       4410          0          0          0          0          0          0          0     GICv3 297 Level     ufshcd\n"
+    "230:         17          0          0          0          0          0          0          0  msmgpio  59 Edge      goodix_ts\n"
+    "IPI0:      1200       1100        900        800        700        600        500        400       Rescheduling interrupts\n"
+    "Err:          0\n";
+
+static void add_irq(const char* root, int irq) {
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "/proc/irq/%d/smp_affinity_list", irq);
+    test_write(root, path, "0-7");
+}
+
+// stat line whose processor field (39) holds cpu, comm may contain spaces
+static void add_thread(const char* root, int tid, const char* comm, const char* stat_comm, int cpu) {
+    char path[MAX_PATH_LENGTH];
+    char stat[MAX_DATA_LENGTH];
+    int len = snprintf(stat, sizeof(stat), "%d (%s) S", tid, stat_comm);
+    for (int field = 4; field < 39; field++)
+        len += snprintf(stat + len, sizeof(stat) - len, " %d", field);
+    snprintf(stat + len, sizeof(stat) - len, " %d 0 0 0", cpu);
+
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/comm", GAME_PID, tid);
+    test_write(root, path, comm);
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", GAME_PID, tid);
+    test_write(root, path, stat);
+}
+
+static bool affinity_is(const char* root, int irq, const char* want) {
+    char path[MAX_PATH_LENGTH];
+    char buf[64];
+    snprintf(path, sizeof(path), "/proc/irq/%d/smp_affinity_list", irq);
+    test_read(root, path, buf, sizeof(buf));
+    if (strcmp(buf, want) != 0) {
+        fprintf(stderr, "irq %d: affinity %s, expected %s\n", irq, buf, want);
+        return false;
+    }
+    return true;
+}
+
+static void test_classify(void) {
+    CHECK_EQ(irq_classify("GICv3 168 Level     fts_ts"), IRQ_TOUCH);
+    CHECK_EQ(irq_classify("msmgpio  59 Edge      Goodix-TS"), IRQ_TOUCH);
+    CHECK_EQ(irq_classify("GICv3 332 Level     kgsl_3d0_irq"), IRQ_GPU);
+    CHECK_EQ(irq_classify("GIC 219 Level     13040000.mali"), IRQ_GPU);
+    CHECK_EQ(irq_classify("GICv3 297 Level     ufshcd"), IRQ_STORAGE);
+    CHECK_EQ(irq_classify("GICv3  27 Level     arch_timer"), IRQ_OTHER);
+}
+
+int main(void) {
+    test_classify();
+
+    char* root = test_mktree();
+    test_write(root, "/proc/interrupts", interrupts);
+    add_irq(root, 11);
+    add_irq(root, 45);
+    add_irq(root, 210);
+    add_irq(root, 211);
+    // 230 has no affinity file, like a managed interrupt, and is left out
+
+    // 4 little, 3 mid, 1 prime
+    nr_clusters = 3;
+    clusters[0].cpu_mask = 0x0f;
+    clusters[1].cpu_mask = 0x70;
+    clusters[2].cpu_mask = 0x80;
+
+    CHECK_EQ(irq_steer_init(root), 3);
+
+    add_thread(root, GAME_PID, "com.game.x", "com.game.x", 0);
+    add_thread(root, 1240, "UnityMain", "UnityMain", 5);
+    add_thread(root, 1241, "UnityGfxDevice", "UnityGfx Device", 6);
+    add_thread(root, 1242, "Thread-7", "Thread-7", 7);
+    CHECK_EQ(irq_render_cpus(GAME_PID), (1ULL << 5) | (1ULL << 6));
+    CHECK_EQ(irq_render_cpus(4321), 0);
+
+    // Render threads on the mid cluster: touch next to them on a free cpu,
+    // storage and GPU on the little cluster
+    irq_steer_apply(PERFORMANCE_PROFILE, GAME_PID);
+    CHECK(affinity_is(root, 45, "4"));
+    CHECK(affinity_is(root, 210, "0-3"));
+    CHECK(affinity_is(root, 211, "0-3"));
+    CHECK(affinity_is(root, 11, "0-7"));
+
+    // No game pid, the render loop is assumed on the biggest cluster
+    irq_steer_apply(PERFORMANCE_PROFILE, 0);
+    CHECK(affinity_is(root, 45, "7"));
+    CHECK(affinity_is(root, 210, "0-3"));
+
+    // Any other profile puts the saved affinity back
+    irq_steer_apply(BALANCED_PROFILE, 0);
+    CHECK(affinity_is(root, 45, "0-7"));
+    CHECK(affinity_is(root, 210, "0-7"));
+    CHECK(affinity_is(root, 211, "0-7"));
+
+    // The exit path restores as well, a second restore writes nothing
+    irq_steer_apply(PERFORMANCE_PROFILE, GAME_PID);
+    irq_steer_restore();
+    CHECK(affinity_is(root, 45, "0-7"));
+    CHECK(affinity_is(root, 211, "0-7"));
+    test_write(root, "/proc/irq/45/smp_affinity_list", "3");
+    irq_steer_restore();
+    CHECK(affinity_is(root, 45, "3"));
+
+    return test_done("irq_steer");
+}
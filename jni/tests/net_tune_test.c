@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/net_tune.c src/irq_steer.c src/cpuset.c src/cpu_topology.c
+
+#include "test_util.h"
+
+#define BUSY_POLL "/proc/sys/net/core/busy_poll"
+
+static char commands[MAX_DATA_LENGTH * 4];
+
+// iptables, cmd wifi and iw only get recorded
+int systemv(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t len = strlen(commands);
+    vsnprintf(commands + len, sizeof(commands) - len, format, args);
+    va_end(args);
+    strncat(commands, "\n", sizeof(commands) - strlen(commands) - 1);
+    return 0;
+}
+
+static bool node_is(const char* root, const char* path, const char* want) {
+    char buf[32];
+    test_read(root, path, buf, sizeof(buf));
+    if (strcmp(buf, want) != 0) {
+        fprintf(stderr, "%s: %s, expected %s\n", path, buf, want);
+        return false;
+    }
+    return true;
+}
+
+static bool marker_exists(const char* root) {
+    char path[MAX_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s%s", root, NET_CHAIN_MARKER);
+    return access(path, F_OK) == 0;
+}
+
+int main(void) {
+    char* root = test_mktree();
+    test_write(root, "/proc/sys/net/ipv4/tcp_low_latency", "0");
+    test_write(root, "/proc/sys/net/ipv4/tcp_fastopen", "1");
+    test_write(root, "/proc/sys/net/ipv4/tcp_ecn", "2");
+    test_write(root, BUSY_POLL, "0");
+    test_write(root, "/proc/sys/net/core/busy_read", "0");
+    test_write(root, "/sys/class/net/wlan0/queues/rx-0/rps_cpus", "0");
+    test_write(root, "/sys/class/net/wlan0/queues/tx-0/xps_cpus", "0");
+    test_write(root, "/sys/class/net/rmnet_data0/queues/rx-0/rps_cpus", "0");
+    test_write(root, "/sys/class/net/lo/queues/rx-0/rps_cpus", "0");
+    test_write(root, "/sys/class/net/dummy0/queues/rx-0/rps_cpus", "0");
+
+    // A queue node backed by the same file as a sysctl, both only come back
+    // right when restore runs in reverse order
+    char link[MAX_PATH_LENGTH * 2];
+    char target[MAX_PATH_LENGTH * 2];
+    snprintf(link, sizeof(link), "%s/sys/class/net/wlan0/queues/rx-1", root);
+    mkdir(link, 0755);
+    strncat(link, "/rps_cpus", sizeof(link) - strlen(link) - 1);
+    snprintf(target, sizeof(target), "%s%s", root, BUSY_POLL);
+    CHECK_EQ(symlink(target, link), 0);
+
+    // Where NET_CHAIN_MARKER goes
+    snprintf(target, sizeof(target), "%s/dev", root);
+    mkdir(target, 0755);
+
+    // 4 little, 3 mid, 1 prime: packets go to the little cluster
+    nr_clusters = 3;
+    clusters[0].cpu_mask = 0x0f;
+    clusters[1].cpu_mask = 0x70;
+    clusters[2].cpu_mask = 0x80;
+
+    net_tune_init(root, false);
+    CHECK(commands[0] == '\0');
+
+    net_tune_apply(10123, 0);
+    CHECK(node_is(root, "/proc/sys/net/ipv4/tcp_low_latency", "1"));
+    CHECK(node_is(root, "/proc/sys/net/ipv4/tcp_fastopen", "3"));
+    CHECK(node_is(root, "/sys/class/net/wlan0/queues/rx-0/rps_cpus", "f"));
+    CHECK(node_is(root, "/sys/class/net/wlan0/queues/tx-0/xps_cpus", "f"));
+    CHECK(node_is(root, "/sys/class/net/rmnet_data0/queues/rx-0/rps_cpus", "f"));
+    CHECK(node_is(root, BUSY_POLL, "f"));
+    CHECK(node_is(root, "/sys/class/net/lo/queues/rx-0/rps_cpus", "0"));
+    CHECK(node_is(root, "/sys/class/net/dummy0/queues/rx-0/rps_cpus", "0"));
+    CHECK(strstr(commands, "--uid-owner 10123 -j DSCP") != NULL);
+    CHECK(strstr(commands, "cmd wifi force-low-latency-mode enabled") != NULL);
+    CHECK(marker_exists(root));
+
+    commands[0] = '\0';
+    net_tune_restore();
+    CHECK(node_is(root, "/proc/sys/net/ipv4/tcp_low_latency", "0"));
+    CHECK(node_is(root, "/proc/sys/net/ipv4/tcp_fastopen", "1"));
+    CHECK(node_is(root, "/proc/sys/net/ipv4/tcp_ecn", "2"));
+    CHECK(node_is(root, "/proc/sys/net/core/busy_read", "0"));
+    CHECK(node_is(root, "/sys/class/net/wlan0/queues/rx-0/rps_cpus", "0"));
+    CHECK(node_is(root, "/sys/class/net/wlan0/queues/tx-0/xps_cpus", "0"));
+    CHECK(node_is(root, "/sys/class/net/rmnet_data0/queues/rx-0/rps_cpus", "0"));
+    CHECK(node_is(root, BUSY_POLL, "0"));
+    CHECK(strstr(commands, "-X " NET_CHAIN) != NULL);
+    CHECK(strstr(commands, "cmd wifi force-low-latency-mode disabled") != NULL);
+    CHECK(!marker_exists(root));
+
+    // A chain a killed daemon left behind is dropped on the next start
+    test_write(root, NET_CHAIN_MARKER, "");
+    commands[0] = '\0';
+    net_tune_init(root, false);
+    CHECK(strstr(commands, "iptables -w -t mangle -X " NET_CHAIN) != NULL);
+    CHECK(strstr(commands, "ip6tables -w -t mangle -X " NET_CHAIN) != NULL);
+    CHECK(!marker_exists(root));
+
+    // The bench steers lo as well and never touches Wi-Fi
+    commands[0] = '\0';
+    net_tune_init(root, true);
+    net_tune_apply(2000, 0);
+    CHECK(node_is(root, "/sys/class/net/lo/queues/rx-0/rps_cpus", "f"));
+    net_tune_restore();
+    CHECK(node_is(root, "/sys/class/net/lo/queues/rx-0/rps_cpus", "0"));
+    CHECK(strstr(commands, "wifi") == NULL);
+    CHECK(strstr(commands, "iw ") == NULL);
+
+    return test_done("net_tune");
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/profile_sim.c src/profile_state.c src/game_procs.c
+
+#include "test_util.h"
+
+// The replay runs on its own env, the device env only has to link
+static bool never(void) {
+    return false;
+}
+
+bool (*get_screenstate)(void) = never;
+bool (*get_low_power_state)(void) = never;
+
+char* get_gamestart(GameOptions* options) {
+    (void)options;
+    return NULL;
+}
+
+pid_t pidof(const char* name) {
+    (void)name;
+    return 0;
+}
+
+LoadClass load_sampler_class(void) {
+    return LOAD_INTERACTIVE;
+}
+
+// Transition lines of a --simulate report, the summary after the blank line is left out
+static int read_transitions(const char* path, char lines[][MAX_LINE], int max) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+
+    int n = 0;
+    char line[MAX_LINE];
+    while (n < max && fgets(line, sizeof(line), fp)) {
+        size_t len = strlen(line);
+        while (len > 0 && isspace((unsigned char)line[len - 1]))
+            line[--len] = '\0';
+        if (len == 0)
+            break;
+        snprintf(lines[n++], MAX_LINE, "%s", line);
+    }
+    fclose(fp);
+    return n;
+}
+
+// Each trace gets a fresh process, the simulator keeps its state in statics
+static void check_trace(const char* root, const char* name) {
+    char trace[MAX_PATH_LENGTH * 2];
+    char expected[MAX_PATH_LENGTH * 2];
+    char output[MAX_PATH_LENGTH * 2];
+    snprintf(trace, sizeof(trace), "%s/%s.trace", TEST_DATA, name);
+    snprintf(expected, sizeof(expected), "%s/%s.expected", TEST_DATA, name);
+    snprintf(output, sizeof(output), "%s/%s.out", root, name);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!freopen(output, "w", stdout))
+            _exit(2);
+        char* argv[] = {"sys.azenith-service", "--simulate", trace, NULL};
+        int ret = handle_simulate(3, argv);
+        fflush(stdout);
+        _exit(ret);
+    }
+
+    int status = -1;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    static char want[64][MAX_LINE];
+    static char got[64][MAX_LINE];
+    int nr_want = read_transitions(expected, want, 64);
+    int nr_got = read_transitions(output, got, 64);
+    CHECK(nr_want > 0);
+    CHECK_EQ(nr_got, nr_want);
+
+    for (int i = 0; i < nr_want && i < nr_got; i++) {
+        if (strcmp(got[i], want[i]) != 0) {
+            fprintf(stderr, "%s:%d: expected \"%s\", got \"%s\"\n", expected, i + 1, want[i], got[i]);
+            test_failures++;
+        }
+    }
+}
+
+int main(void) {
+    char* root = test_mktree();
+    check_trace(root, "profile_game_session");
+    check_trace(root, "profile_game_background");
+    check_trace(root, "profile_power_load");
+    return test_done("profile_sim");
+}
@@ -0,0 +1,66 @@
+#!/usr/bin/env bash
+#
+# Copyright (C) 2024-2025 Zexshia
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Builds and runs the daemon host tests. Each tests/<name>_test.c is linked with
+# tests/test_stubs.c and the daemon sources named on its "// sources:" line.
+# Needs a C23 compiler on Linux (gcc 13+ or clang 18+), override with CC=.
+#
+# Usage: tests/run.sh [name ...]
+
+set -u
+
+TESTS_DIR="$(cd "$(dirname "$0")" && pwd)"
+JNI_DIR="$(dirname "$TESTS_DIR")"
+if [ -z "${BUILD_DIR:-}" ]; then
+    BUILD_DIR="$(mktemp -d)"
+    trap 'rm -rf "$BUILD_DIR"' EXIT
+fi
+CC="${CC:-cc}"
+CFLAGS="-std=gnu2x -D_GNU_SOURCE -O1 -g -Wall -Wextra -Wno-attributes -Wno-unknown-pragmas -Wno-format-truncation
+        -I$JNI_DIR/include -I$TESTS_DIR -I$TESTS_DIR/stubs
+        -include stdarg.h -include stdbool.h -include fcntl.h -include signal.h
+        -include sys/resource.h -include sys/time.h
+        -DTEST_DATA=\"$TESTS_DIR/data\" -DCMD_SHELL=\"/bin/sh\""
+
+if [ $# -gt 0 ]; then
+    tests=("$@")
+else
+    tests=()
+    for f in "$TESTS_DIR"/*_test.c; do
+        name="$(basename "$f" _test.c)"
+        tests+=("$name")
+    done
+fi
+
+failed=0
+for name in "${tests[@]}"; do
+    src="$TESTS_DIR/${name}_test.c"
+    sources="$(sed -n 's|^// sources:||p' "$src")"
+    objs=()
+    for s in $sources; do
+        objs+=("$JNI_DIR/$s")
+    done
+
+    # shellcheck disable=SC2086
+    if ! $CC $CFLAGS -o "$BUILD_DIR/$name" "$src" "$TESTS_DIR/test_stubs.c" "${objs[@]}" -lpthread; then
+        echo "FAIL $name: build failed"
+        failed=1
+        continue
+    fi
+    "$BUILD_DIR/$name" || failed=1
+done
+
+exit $failed
@@ -0,0 +1,16 @@
+// Host stand-in for the bionic property API, tests/test_stubs.c implements it
+#pragma once
+#include <stdint.h>
+
+#define PROP_VALUE_MAX 92
+#define PROP_NAME_MAX 32
+
+typedef struct prop_info prop_info;
+struct timespec;
+
+int __system_property_get(const char* name, char* value);
+int __system_property_set(const char* name, const char* value);
+const prop_info* __system_property_find(const char* name);
+uint32_t __system_property_serial(const prop_info* pi);
+_Bool __system_property_wait(const prop_info* pi, uint32_t old_serial, uint32_t* new_serial_ptr,
+                             const struct timespec* relative_timeout);
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_util.h"
+#include <ftw.h>
+
+// Weak, a test that links the real module gets the real one
+#define WEAK __attribute__((weak))
+
+#define MAX_TEST_PROPS 32
+#define MAX_TEST_TREES 8
+
+int test_failures = 0;
+
+static struct {
+    char name[PROP_NAME_MAX * 4];
+    char value[PROP_VALUE_MAX];
+} props[MAX_TEST_PROPS];
+static int nr_props = 0;
+
+static char trees[MAX_TEST_TREES][MAX_PATH_LENGTH];
+static int nr_trees = 0;
+
+WEAK DaemonStats stats;
+
+WEAK void log_zenith(LogLevel level, const char* message, ...) {
+    if (!getenv("TEST_VERBOSE"))
+        return;
+
+    va_list args;
+    va_start(args, message);
+    fprintf(stderr, "[%d] ", level);
+    vfprintf(stderr, message, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+WEAK char* trim_newline(char* string) {
+    if (string)
+        string[strcspn(string, "\n")] = '\0';
+    return string;
+}
+
+WEAK char* skip_space(char* p) {
+    while (*p && isspace((unsigned char)*p))
+        p++;
+    return p;
+}
+
+WEAK void notify(const char* title, const char* fmt, const char* chrono, int timeout_ms, ...) {
+    (void)title;
+    (void)fmt;
+    (void)chrono;
+    (void)timeout_ms;
+}
+
+WEAK void toast(const char* message) {
+    (void)message;
+}
+
+WEAK int systemv(const char* format, ...) {
+    (void)format;
+    return 0;
+}
+
+WEAK int systemv_deadline(int timeout_ms, const char* format, ...) {
+    (void)timeout_ms;
+    (void)format;
+    return 0;
+}
+
+WEAK int write2file(const char* filename, const bool append, const bool use_flock, const char* data, ...) {
+    (void)use_flock;
+    FILE* fp = fopen(filename, append ? "a" : "w");
+    if (!fp)
+        return -1;
+
+    va_list args;
+    va_start(args, data);
+    vfprintf(fp, data, args);
+    va_end(args);
+    fclose(fp);
+    return 0;
+}
+
+WEAK void footprint_child_reset(void) {}
+
+WEAK void footprint_idle_child(void) {}
+
+WEAK int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+WEAK int event_loop_add(int fd, EventHandler handler) {
+    (void)fd;
+    (void)handler;
+    return 0;
+}
+
+WEAK void event_loop_remove(int fd) {
+    (void)fd;
+}
+
+int __system_property_get(const char* name, char* value) {
+    for (int i = 0; i < nr_props; i++) {
+        if (strcmp(props[i].name, name) == 0) {
+            snprintf(value, PROP_VALUE_MAX, "%s", props[i].value);
+            return (int)strlen(value);
+        }
+    }
+    value[0] = '\0';
+    return 0;
+}
+
+int __system_property_set(const char* name, const char* value) {
+    test_setprop(name, value);
+    return 0;
+}
+
+const prop_info* __system_property_find(const char* name) {
+    (void)name;
+    return NULL;
+}
+
+uint32_t __system_property_serial(const prop_info* pi) {
+    (void)pi;
+    return 0;
+}
+
+_Bool __system_property_wait(const prop_info* pi, uint32_t old_serial, uint32_t* new_serial_ptr,
+                             const struct timespec* relative_timeout) {
+    (void)pi;
+    (void)relative_timeout;
+    if (new_serial_ptr)
+        *new_serial_ptr = old_serial;
+    return false;
+}
+
+/***********************************************************************************
+ * Function Name      : test_setprop
+ * Inputs             : name (const char *) - property name
+ *                      value (const char *) - property value
+ * Returns            : None
+ * Description        : Sets a property for __system_property_get.
+ ***********************************************************************************/
+void test_setprop(const char* name, const char* value) {
+    int i = 0;
+    while (i < nr_props && strcmp(props[i].name, name) != 0)
+        i++;
+    if (i == MAX_TEST_PROPS)
+        return;
+    if (i == nr_props)
+        nr_props++;
+
+    snprintf(props[i].name, sizeof(props[i].name), "%s", name);
+    snprintf(props[i].value, sizeof(props[i].value), "%s", value);
+}
+
+/***********************************************************************************
+ * Function Name      : test_mktree
+ * Inputs             : None
+ * Returns            : char * - new empty directory, the root of a mocked tree
+ * Description        : Creates a temporary directory under TMPDIR or /tmp,
+ *                      test_done() removes it again.
+ ***********************************************************************************/
+char* test_mktree(void) {
+    if (nr_trees == MAX_TEST_TREES) {
+        fprintf(stderr, "test_mktree: more than %d trees\n", MAX_TEST_TREES);
+        exit(2);
+    }
+
+    char* path = trees[nr_trees];
+    const char* tmp = getenv("TMPDIR");
+    snprintf(path, MAX_PATH_LENGTH, "%s/azenith-test-XXXXXX", tmp ? tmp : "/tmp");
+    if (!mkdtemp(path)) {
+        perror("mkdtemp");
+        exit(2);
+    }
+    nr_trees++;
+    return path;
+}
+
+static int remove_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    remove(path);
+    return 0;
+}
+
+/***********************************************************************************
+ * Function Name      : test_write
+ * Inputs             : root (const char *) - mocked tree
+ *                      path (const char *) - file below root, starting with /
+ *                      value (const char *) - content, a newline is appended
+ * Returns            : None
+ * Description        : Creates missing parent directories, then the file.
+ ***********************************************************************************/
+void test_write(const char* root, const char* path, const char* value) {
+    char full[MAX_PATH_LENGTH * 2];
+    snprintf(full, sizeof(full), "%s%s", root, path);
+
+    for (char* p = full + strlen(root) + 1; (p = strchr(p, '/')) != NULL; p++) {
+        *p = '\0';
+        mkdir(full, 0755);
+        *p = '/';
+    }
+
+    FILE* fp = fopen(full, "w");
+    if (!fp) {
+        perror(full);
+        exit(2);
+    }
+    fprintf(fp, "%s\n", value);
+    fclose(fp);
+}
+
+/***********************************************************************************
+ * Function Name      : test_read
+ * Inputs             : root (const char *) - mocked tree
+ *                      path (const char *) - file below root, starting with /
+ *                      buf (char *) - receives the first line
+ *                      size (size_t) - size of buf
+ * Returns            : char * - buf, empty if the file is missing
+ * Description        : Reads the first line of a mocked file without newline.
+ ***********************************************************************************/
+char* test_read(const char* root, const char* path, char* buf, size_t size) {
+    char full[MAX_PATH_LENGTH * 2];
+    snprintf(full, sizeof(full), "%s%s", root, path);
+
+    buf[0] = '\0';
+    FILE* fp = fopen(full, "r");
+    if (fp) {
+        if (!fgets(buf, (int)size, fp))
+            buf[0] = '\0';
+        fclose(fp);
+    }
+    buf[strcspn(buf, "\n")] = '\0';
+    return buf;
+}
+
+/***********************************************************************************
+ * Function Name      : test_done
+ * Inputs             : name (const char *) - test name
+ * Returns            : int - exit status for main
+ * Description        : Reports the result of a test executable and removes
+ *                      the trees it created.
+ ***********************************************************************************/
+int test_done(const char* name) {
+    for (int i = 0; i < nr_trees; i++)
+        nftw(trees[i], remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    nr_trees = 0;
+
+    if (test_failures) {
+        fprintf(stderr, "FAIL %s: %d checks failed\n", name, test_failures);
+        return 1;
+    }
+    printf("PASS %s\n", name);
+    return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <AZenith.h>
+
+// Host tests: each tests/<name>_test.c is one executable, see tests/run.sh
+
+extern int test_failures;
+
+#define CHECK(cond)                                                                      \
+    do {                                                                                 \
+        if (!(cond)) {                                                                   \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);     \
+            test_failures++;                                                             \
+        }                                                                                \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                   \
+    do {                                                                                 \
+        long long va_ = (long long)(a);                                                  \
+        long long vb_ = (long long)(b);                                                  \
+        if (va_ != vb_) {                                                                \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s = %lld, %s = %lld\n", __FILE__,  \
+                    __LINE__, #a, va_, #b, vb_);                                         \
+            test_failures++;                                                             \
+        }                                                                                \
+    } while (0)
+
+void test_setprop(const char* name, const char* value);
+char* test_mktree(void);
+void test_write(const char* root, const char* path, const char* value);
+char* test_read(const char* root, const char* path, char* buf, size_t size);
+int test_done(const char* name);
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/thermal_governor.c src/cpu_topology.c
+
+#include "test_util.h"
+
+#define MAX_TRACE 1024
+
+static const int big_freqs[] = {300000,  576000,  768000,  1017600, 1248000, 1497600,
+                                1708800, 1900800, 2112000, 2342400, 2515200, 2841600};
+
+static int load_trace(const char* path, int* temps) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        exit(2);
+    }
+
+    int n = 0;
+    char line[MAX_LINE];
+    while (n < MAX_TRACE && fgets(line, sizeof(line), fp)) {
+        if (line[0] != '#' && line[0] != '\n')
+            temps[n++] = atoi(line);
+    }
+    fclose(fp);
+    return n;
+}
+
+static void test_trace_replay(void) {
+    static int temps[MAX_TRACE];
+    int n = load_trace(TEST_DATA "/thermal_session.trace", temps);
+    CHECK_EQ(n, 120);
+
+    ThermalCtl c = {.trip_mc = THERMAL_TRIP_MC};
+    thermal_ctl_reset(&c);
+
+    int levels[MAX_TRACE];
+    int first_max = -1;
+    int back_to_zero = -1;
+    int last_move = -1;
+    bool last_up = false;
+    for (int i = 0; i < n; i++) {
+        int prev = i ? levels[i - 1] : 0;
+        levels[i] = thermal_ctl_update(&c, temps[i]);
+
+        // One step per move, never above the trip-less ceiling
+        CHECK(abs(levels[i] - prev) <= 1);
+        CHECK(levels[i] >= 0 && levels[i] <= THERMAL_MAX_LEVEL);
+        if (levels[i] > prev)
+            CHECK(temps[i] >= c.trip_mc);
+        if (levels[i] < prev)
+            CHECK(temps[i] <= c.trip_mc - THERMAL_HYST_MC);
+
+        // Moves are separated by the hold-off of the previous move
+        if (levels[i] != prev) {
+            if (last_move >= 0)
+                CHECK(i - last_move > (last_up ? THERMAL_STEP_HOLD : THERMAL_RELEASE_HOLD));
+            last_move = i;
+            last_up = levels[i] > prev;
+        }
+
+        if (levels[i] == THERMAL_MAX_LEVEL && first_max < 0)
+            first_max = i;
+        if (first_max >= 0 && levels[i] == 0 && back_to_zero < 0)
+            back_to_zero = i;
+    }
+
+    // 10 cool samples, then one step every STEP_HOLD + 1 ticks while hot
+    CHECK_EQ(levels[9], 0);
+    CHECK_EQ(levels[10], 1);
+    CHECK_EQ(first_max, 10 + (THERMAL_MAX_LEVEL - 1) * (THERMAL_STEP_HOLD + 1));
+    CHECK_EQ(levels[49], THERMAL_MAX_LEVEL);
+
+    // Released one step every RELEASE_HOLD + 1 ticks once below trip - hysteresis
+    CHECK_EQ(levels[50], THERMAL_MAX_LEVEL - 1);
+    CHECK_EQ(back_to_zero, 50 + (THERMAL_MAX_LEVEL - 1) * (THERMAL_RELEASE_HOLD + 1));
+
+    // The hysteresis band neither raises nor releases
+    for (int i = 110; i < n; i++)
+        CHECK_EQ(levels[i], 0);
+}
+
+static void test_caps(void) {
+    CpuCluster big = {.policy = 4, .cpuinfo_min = 300000, .cpuinfo_max = 2841600};
+    big.nr_freqs = (int)(sizeof(big_freqs) / sizeof(big_freqs[0]));
+    memcpy(big.freqs, big_freqs, sizeof(big_freqs));
+
+    CHECK_EQ(thermal_ctl_cap(&big, 0), big.cpuinfo_max);
+
+    int prev = big.cpuinfo_max;
+    for (int level = 1; level <= THERMAL_MAX_LEVEL; level++) {
+        int cap = thermal_ctl_cap(&big, level);
+        long target = (long)big.cpuinfo_max * (100 - level * THERMAL_STEP_PCT) / 100;
+
+        bool available = false;
+        for (int i = 0; i < big.nr_freqs; i++)
+            available |= big.freqs[i] == cap;
+        CHECK(available);
+        CHECK(cap <= target);
+        CHECK(cap <= prev);
+        prev = cap;
+    }
+
+    // 6% steps of 2841600: 2671104 -> 2515200 ... 36% -> 1818624 -> 1708800
+    CHECK_EQ(thermal_ctl_cap(&big, 1), 2515200);
+    CHECK_EQ(thermal_ctl_cap(&big, THERMAL_MAX_LEVEL), 1708800);
+}
+
+static void test_zone_filter(void) {
+    CHECK(thermal_zone_relevant("cpu-1-0-usr"));
+    CHECK(thermal_zone_relevant("SOC_THERM"));
+    CHECK(thermal_zone_relevant("mtktsAP_NTC"));
+    CHECK(!thermal_zone_relevant("battery"));
+    CHECK(!thermal_zone_relevant("pa_therm0"));
+}
+
+int main(void) {
+    test_trace_replay();
+    test_caps();
+    test_zone_filter();
+    return test_done("thermal_governor");
+}
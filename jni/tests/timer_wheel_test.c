@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024-2025 Zexshia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sources: src/timer_wheel.c
+
+#include "test_util.h"
+#include <sys/eventfd.h>
+
+enum { T_A, T_B, T_C, T_D, T_E, T_F, NR_T };
+
+static int64_t fake_now = 100000;
+static EventHandler wheel_handler = NULL;
+static int wake_fd = -1;
+static Timer timers[NR_T];
+static int fired[NR_T];
+
+int64_t now_ms(void) {
+    return fake_now;
+}
+
+int event_loop_add(int fd, EventHandler handler) {
+    (void)fd;
+    wheel_handler = handler;
+    return 0;
+}
+
+// Moves the fake clock and delivers one timerfd expiry
+static void advance_to(int64_t ms) {
+    fake_now = ms;
+    uint64_t one = 1;
+    CHECK(write(wake_fd, &one, sizeof(one)) == sizeof(one));
+    wheel_handler(wake_fd);
+}
+
+// A is first in its batch and stops B, restarts C, both due with it
+static void fn_a(void) {
+    fired[T_A]++;
+    if (fired[T_A] == 1) {
+        timer_stop(&timers[T_B]);
+        timer_start(&timers[T_C], 5000);
+    }
+}
+
+static void fn_b(void) {
+    fired[T_B]++;
+}
+
+static void fn_c(void) {
+    fired[T_C]++;
+}
+
+static void fn_d(void) {
+    fired[T_D]++;
+}
+
+// E stops itself after its first run, F restarts E from the same batch
+static void fn_e(void) {
+    fired[T_E]++;
+    timer_stop(&timers[T_E]);
+}
+
+static void fn_f(void) {
+    fired[T_F]++;
+}
+
+static const TimerFn fns[NR_T] = {fn_a, fn_b, fn_c, fn_d, fn_e, fn_f};
+
+int main(void) {
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    CHECK(timer_wheel_init());
+    CHECK(wheel_handler != NULL);
+
+    for (int i = 0; i < NR_T; i++) {
+        timers[i].fn = fns[i];
+        timers[i].period_ms = 1000;
+    }
+    // Insertion order is dispatch order within a slot
+    for (int i = T_A; i <= T_D; i++)
+        timer_start(&timers[i], 1000);
+
+    advance_to(101000);
+    CHECK_EQ(fired[T_A], 1);
+    CHECK_EQ(fired[T_B], 0);
+    CHECK_EQ(fired[T_C], 0);
+    CHECK_EQ(fired[T_D], 1);
+    CHECK(!timers[T_B].active);
+    CHECK(timers[T_C].active);
+    CHECK(timers[T_D].active);
+
+    // Everything after the stopped timer kept going
+    advance_to(102000);
+    CHECK_EQ(fired[T_A], 2);
+    CHECK_EQ(fired[T_B], 0);
+    CHECK_EQ(fired[T_C], 0);
+    CHECK_EQ(fired[T_D], 2);
+
+    // The restart holds, C runs 5s after A's first run
+    advance_to(106000);
+    CHECK_EQ(fired[T_C], 1);
+    CHECK_EQ(fired[T_D], 3); // once per wakeup, missed periods are not replayed
+
+    // A periodic timer that stops itself does not come back
+    timer_start(&timers[T_E], 1000);
+    timer_start(&timers[T_F], 1000);
+    advance_to(107000);
+    advance_to(108000);
+    advance_to(109000);
+    CHECK_EQ(fired[T_E], 1);
+    CHECK(!timers[T_E].active);
+    CHECK_EQ(fired[T_F], 3);
+
+    for (int i = 0; i < NR_T; i++)
+        CHECK(!timers[i].in_flight);
+    return test_done("timer_wheel");
+}
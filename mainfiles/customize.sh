@@ -214,6 +214,18 @@ persist.sys.azenithconf.dnd
 persist.sys.azenithconf.justintime
 persist.sys.azenithconf.disabletrace
 persist.sys.azenithconf.thermalcore
+persist.sys.azenithconf.thermalgov
+persist.sys.azenithconf.loadaware
+persist.sys.azenithconf.touchboost
+persist.sys.azenithconf.gpuctl
+persist.sys.azenithconf.cgroupboost
+persist.sys.azenithconf.cpuset
+persist.sys.azenithconf.irqsteer
+persist.sys.azenithconf.vmtune
+persist.sys.azenithconf.freezer
+persist.sys.azenithconf.blktune
+persist.sys.azenithconf.preloadguard
+persist.sys.azenithconf.netlatency
 "
 for prop in $props; do
 	curval=$(getprop "$prop")
@@ -229,6 +241,10 @@ if [ -z "$(getprop persist.sys.azenithconf.preloadbudget)" ]; then
     setprop persist.sys.azenithconf.preloadbudget 500M
 fi
 
+if [ -z "$(getprop persist.sys.azenithconf.preloadlock)" ]; then
+    setprop persist.sys.azenithconf.preloadlock 0
+fi
+
 if [ -z "$(getprop persist.sys.azenithconf.AIenabled)" ]; then
     ui_print "- Enabling Auto Mode"
     setprop persist.sys.azenithconf.AIenabled 1
@@ -16,16 +16,11 @@
 # limitations under the License.
 #
 
-# Wait for boot to Complete
-while [ "$(getprop sys.boot_completed)" != "1" ]; do
-	sleep 40
-done
-
 # Refresh daemon state
 if [ -z "$(getprop persist.sys.azenith.state)" ] || { [ "$(getprop persist.sys.azenith.state)" = "running" ] && [ -z "$(/system/bin/toybox pidof sys.azenith-service)" ]; }; then
     setprop persist.sys.azenith.state stopped
     setprop persist.sys.azenith.service ""
 fi
 
-# Run Daemon
+# Run Daemon, it waits for sys.boot_completed by itself
 sys.azenith-service --run
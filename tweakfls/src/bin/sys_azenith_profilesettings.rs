@@ -4,6 +4,10 @@ use std::os::unix::fs::PermissionsExt;
 use std::process::Command;
 use std::path::Path;
 use std::collections::HashSet;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Mutex, OnceLock};
+use std::thread;
+use std::time::{Duration, Instant};
 
 fn getprop(prop_name: &str) -> String {
     if let Ok(output) = Command::new("getprop").arg(prop_name).output() {
@@ -18,8 +22,14 @@ fn setprop(prop_name: &str, value: &str) {
     let _ = Command::new("setprop").arg(prop_name).arg(value).output();
 }
 
+// Read once per run, a getprop per write would serialize the init stages on fork
+fn debugmode() -> bool {
+    static DEBUG: OnceLock<bool> = OnceLock::new();
+    *DEBUG.get_or_init(|| getprop("persist.sys.azenith.debugmode") == "true")
+}
+
 fn az_log(message: &str) {
-    if getprop("persist.sys.azenith.debugmode") == "true" {
+    if debugmode() {
         let _ = Command::new("sys.azenith-service")
             .arg("--verboselog")
             .arg("AZLog")
@@ -665,656 +675,501 @@ fn get_biggest_cluster() -> String {
     target
 }
 
-fn mediatek_balance() {
-    if Path::new("/proc/ppm").exists() && Path::new("/proc/ppm/policy_status").exists() {
-        if let Ok(content) = fs::read_to_string("/proc/ppm/policy_status") {
-            for line in content.lines() {
-                if line.contains("FORCE_LIMIT") || line.contains("PWR_THRO") || line.contains("THERMAL") || line.contains("USER_LIMIT") {
-                    if let Some(start) = line.find('[') {
-                        if let Some(end) = line[start..].find(']') {
-                            let idx = &line[start + 1..start + end];
-                            zeshia(&format!("{} 1", idx), "/proc/ppm/policy_status", true);
-                        }
-                    }
-                }
-                if line.contains("SYS_BOOST") {
-                    if let Some(start) = line.find('[') {
-                        if let Some(end) = line[start..].find(']') {
-                            let idx = &line[start + 1..start + end];
-                            zeshia(&format!("{} 0", idx), "/proc/ppm/policy_status", true);
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    zeshia("0", "/proc/cpufreq/cpufreq_cci_mode", true);
-    zeshia("1", "/proc/cpufreq/cpufreq_power_mode", true);
-
-    if Path::new("/proc/gpufreq").exists() {
-        zeshia("0", "/proc/gpufreq/gpufreq_opp_freq", true);
-    } else if Path::new("/proc/gpufreqv2").exists() {
-        zeshia("-1", "/proc/gpufreqv2/fix_target_opp_index", true);
-    }
-
-    zeshia("1", "/sys/devices/system/cpu/eas/enable", true);
-
-    if Path::new("/proc/gpufreq/gpufreq_power_limited").exists() {
-        for setting in ["ignore_batt_oc", "ignore_batt_percent", "ignore_low_batt", "ignore_thermal_protect", "ignore_pbm_limited"].iter() {
-            zeshia(&format!("{} 0", setting), "/proc/gpufreq/gpufreq_power_limited", true);
-        }
-    }
-
-    zeshia("0", "/proc/perfmgr/syslimiter/syslimiter_force_disable", true);
-    zeshia("stop 0", "/proc/mtk_batoc_throttling/battery_oc_protect_stop", true);
-    zeshia("stop 0", "/proc/pbm/pbm_stop", true);
-    zeshia("1", "/sys/kernel/eara_thermal/enable", true);
-
-    zeshia("-1", "/sys/devices/platform/10012000.dvfsrc/helio-dvfsrc/dvfsrc_req_ddr_opp", true);
-    zeshia("-1", "/sys/kernel/helio-dvfsrc/dvfsrc_force_vcore_dvfs_opp", true);
-    zeshia("userspace", "/sys/class/devfreq/mtk-dvfsrc-devfreq/governor", true);
-    zeshia("userspace", "/sys/devices/platform/soc/1c00f000.dvfsrc/mtk-dvfsrc-devfreq/devfreq/mtk-dvfsrc-devfreq/governor", true);
-
-    if let Ok(mut entries) = glob::glob("/sys/devices/platform/*.mali") {
-        if let Some(Ok(mali_sysfs)) = entries.next() {
-            zeshia("coarse_demand", &format!("{}/power_policy", mali_sysfs.to_string_lossy()), true);
-        }
-    }
+// Frequency values are read from a table relative to the matched base
+#[derive(Clone, Copy)]
+enum Val {
+    Lit(&'static str),
+    Max(&'static str),
+    Min(&'static str),
+    Mid(&'static str),
+    // Second lowest step, the lowest one on tables with fewer
+    Low(&'static str),
 }
 
-fn mediatek_performance() {
-    if Path::new("/proc/ppm").exists() && Path::new("/proc/ppm/policy_status").exists() {
-        if let Ok(content) = fs::read_to_string("/proc/ppm/policy_status") {
-            for line in content.lines() {
-                if line.contains("FORCE_LIMIT") || line.contains("PWR_THRO") || line.contains("THERMAL") || line.contains("USER_LIMIT") {
-                    if let Some(start) = line.find('[') {
-                        if let Some(end) = line[start..].find(']') {
-                            let idx = &line[start + 1..start + end];
-                            zeshia(&format!("{} 0", idx), "/proc/ppm/policy_status", true);
-                        }
-                    }
-                }
-                if line.contains("SYS_BOOST") {
-                    if let Some(start) = line.find('[') {
-                        if let Some(end) = line[start..].find(']') {
-                            let idx = &line[start + 1..start + end];
-                            zeshia(&format!("{} 1", idx), "/proc/ppm/policy_status", true);
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    zeshia("1", "/proc/cpufreq/cpufreq_cci_mode", true);
-    zeshia("3", "/proc/cpufreq/cpufreq_power_mode", true);
-
-    if Path::new("/proc/gpufreq").exists() {
-        if let Ok(content) = fs::read_to_string("/proc/gpufreq/gpufreq_opp_dump") {
-            let mut freqs = Vec::new();
-            for line in content.lines() {
-                if let Some(pos) = line.find("freq = ") {
-                    let val_str: String = line[pos+7..].chars().take_while(|c| c.is_digit(10)).collect();
-                    if let Ok(val) = val_str.parse::<i64>() {
-                        freqs.push(val);
-                    }
-                }
-            }
-            if let Some(max) = freqs.iter().max() {
-                zeshia(&max.to_string(), "/proc/gpufreq/gpufreq_opp_freq", true);
-            }
-        }
-    } else if Path::new("/proc/gpufreqv2").exists() {
-        zeshia("0", "/proc/gpufreqv2/fix_target_opp_index", true);
-    }
-
-    zeshia("0", "/sys/devices/system/cpu/eas/enable", true);
+#[derive(Clone, Copy)]
+enum Level {
+    Unlock,
+    Max,
+    Mid,
+    Min,
+}
 
-    if Path::new("/proc/gpufreq/gpufreq_power_limited").exists() {
-        for setting in ["ignore_batt_oc", "ignore_batt_percent", "ignore_low_batt", "ignore_thermal_protect", "ignore_pbm_limited"].iter() {
-            zeshia(&format!("{} 1", setting), "/proc/gpufreq/gpufreq_power_limited", true);
-        }
-    }
+enum Op {
+    // Writes `val` to `file` under each match of `base`, only the first one when `first`
+    Set { base: &'static str, first: bool, file: &'static str, val: Val },
+    Devfreq { base: &'static str, first: bool, level: Level },
+    // MediaTek PPM: value for the limiter policies and for SYS_BOOST
+    Ppm { limits: &'static str, boost: &'static str },
+    GpufreqOppMax,
+    IfExists(&'static str, &'static [Op], &'static [Op]),
+    // Branches on an azenithconf toggle being "1"
+    IfProp(&'static str, &'static [Op], &'static [Op]),
+}
 
-    zeshia("0", "/proc/perfmgr/syslimiter/syslimiter_force_disable", true);
-    zeshia("stop 1", "/proc/mtk_batoc_throttling/battery_oc_protect_stop", true);
-    zeshia("0", "/sys/kernel/eara_thermal/enable", true);
+const fn w(path: &'static str, val: &'static str) -> Op {
+    Op::Set { base: path, first: false, file: "", val: Val::Lit(val) }
+}
 
-    zeshia("0", "/sys/devices/platform/10012000.dvfsrc/helio-dvfsrc/dvfsrc_req_ddr_opp", true);
-    zeshia("0", "/sys/kernel/helio-dvfsrc/dvfsrc_force_vcore_dvfs_opp", true);
-    zeshia("performance", "/sys/class/devfreq/mtk-dvfsrc-devfreq/governor", true);
-    zeshia("performance", "/sys/devices/platform/soc/1c00f000.dvfsrc/mtk-dvfsrc-devfreq/devfreq/mtk-dvfsrc-devfreq/governor", true);
+const fn each(base: &'static str, file: &'static str, val: Val) -> Op {
+    Op::Set { base, first: false, file, val }
+}
 
-    if let Ok(mut entries) = glob::glob("/sys/devices/platform/*.mali") {
-        if let Some(Ok(mali_sysfs)) = entries.next() {
-            zeshia("always_on", &format!("{}/power_policy", mali_sysfs.to_string_lossy()), true);
-        }
-    }
+const fn first(base: &'static str, file: &'static str, val: Val) -> Op {
+    Op::Set { base, first: true, file, val }
 }
 
-fn mediatek_powersave() {
-    if Path::new("/proc/ppm").exists() && Path::new("/proc/ppm/policy_status").exists() {
-        if let Ok(content) = fs::read_to_string("/proc/ppm/policy_status") {
-            for line in content.lines() {
-                if line.contains("FORCE_LIMIT") || line.contains("PWR_THRO") || line.contains("THERMAL") || line.contains("USER_LIMIT") {
-                    if let Some(start) = line.find('[') {
-                        if let Some(end) = line[start..].find(']') {
-                            let idx = &line[start + 1..start + end];
-                            zeshia(&format!("{} 1", idx), "/proc/ppm/policy_status", true);
-                        }
-                    }
-                }
-                if line.contains("SYS_BOOST") {
-                    if let Some(start) = line.find('[') {
-                        if let Some(end) = line[start..].find(']') {
-                            let idx = &line[start + 1..start + end];
-                            zeshia(&format!("{} 0", idx), "/proc/ppm/policy_status", true);
-                        }
-                    }
-                }
-            }
-        }
-    }
+#[derive(Clone, Copy)]
+enum SocMode {
+    Balance,
+    Performance,
+    Powersave,
+}
 
-    zeshia("0", "/sys/devices/platform/10012000.dvfsrc/helio-dvfsrc/dvfsrc_req_ddr_opp", true);
-    zeshia("0", "/sys/kernel/helio-dvfsrc/dvfsrc_force_vcore_dvfs_opp", true);
-    zeshia("powersave", "/sys/class/devfreq/mtk-dvfsrc-devfreq/governor", true);
-    zeshia("powersave", "/sys/devices/platform/soc/1c00f000.dvfsrc/mtk-dvfsrc-devfreq/devfreq/mtk-dvfsrc-devfreq/governor", true);
+struct SocProfile {
+    soc: &'static str,
+    name: &'static str,
+    balance: &'static [Op],
+    performance: &'static [Op],
+    powersave: &'static [Op],
+}
 
-    if Path::new("/proc/gpufreq/gpufreq_power_limited").exists() {
-        for setting in ["ignore_batt_oc", "ignore_batt_percent", "ignore_low_batt", "ignore_thermal_protect", "ignore_pbm_limited"].iter() {
-            zeshia(&format!("{} 1", setting), "/proc/gpufreq/gpufreq_power_limited", true);
+impl SocProfile {
+    fn ops(&self, mode: SocMode) -> &'static [Op] {
+        match mode {
+            SocMode::Balance => self.balance,
+            SocMode::Performance => self.performance,
+            SocMode::Powersave => self.powersave,
         }
     }
+}
 
-    zeshia("0", "/proc/perfmgr/syslimiter/syslimiter_force_disable", true);
-    zeshia("stop 0", "/proc/mtk_batoc_throttling/battery_oc_protect_stop", true);
-    zeshia("stop 0", "/proc/pbm/pbm_stop", true);
-    zeshia("1", "/sys/kernel/eara_thermal/enable", true);
-
-    if let Ok(mut entries) = glob::glob("/sys/devices/platform/*.mali") {
-        if let Some(Ok(mali_sysfs)) = entries.next() {
-            zeshia("coarse_demand", &format!("{}/power_policy", mali_sysfs.to_string_lossy()), true);
-        }
-    }
+const MTK_POWER_LIMITED: &str = "/proc/gpufreq/gpufreq_power_limited";
+const MTK_DVFSRC_GOV: &str = "/sys/devices/platform/soc/1c00f000.dvfsrc/mtk-dvfsrc-devfreq/devfreq/mtk-dvfsrc-devfreq/governor";
+const MALI: &str = "/sys/devices/platform/*.mali";
+const KGSL: &str = "/sys/class/kgsl/kgsl-3d0/devfreq";
+const EXYNOS_GPU: &str = "/sys/kernel/gpu";
+const MIF: &str = "/sys/class/devfreq/*devfreq_mif*";
+const UNISOC_GPU: &str = "/sys/class/devfreq/*.gpu";
+const LITEMODE: &str = "persist.sys.azenithconf.litemode";
+const MITIGATION: &str = "persist.sys.azenithconf.devicemitigation";
+const GPUCTL: &str = "persist.sys.azenithconf.gpuctl";
+
+const MTK_BALANCE: &[Op] = &[
+    Op::Ppm { limits: "1", boost: "0" },
+    w("/proc/cpufreq/cpufreq_cci_mode", "0"),
+    w("/proc/cpufreq/cpufreq_power_mode", "1"),
+    Op::IfExists("/proc/gpufreq", &[w("/proc/gpufreq/gpufreq_opp_freq", "0")], &[w("/proc/gpufreqv2/fix_target_opp_index", "-1")]),
+    w("/sys/devices/system/cpu/eas/enable", "1"),
+    w(MTK_POWER_LIMITED, "ignore_batt_oc 0"),
+    w(MTK_POWER_LIMITED, "ignore_batt_percent 0"),
+    w(MTK_POWER_LIMITED, "ignore_low_batt 0"),
+    w(MTK_POWER_LIMITED, "ignore_thermal_protect 0"),
+    w(MTK_POWER_LIMITED, "ignore_pbm_limited 0"),
+    w("/proc/perfmgr/syslimiter/syslimiter_force_disable", "0"),
+    w("/proc/mtk_batoc_throttling/battery_oc_protect_stop", "stop 0"),
+    w("/proc/pbm/pbm_stop", "stop 0"),
+    w("/sys/kernel/eara_thermal/enable", "1"),
+    w("/sys/devices/platform/10012000.dvfsrc/helio-dvfsrc/dvfsrc_req_ddr_opp", "-1"),
+    w("/sys/kernel/helio-dvfsrc/dvfsrc_force_vcore_dvfs_opp", "-1"),
+    w("/sys/class/devfreq/mtk-dvfsrc-devfreq/governor", "userspace"),
+    w(MTK_DVFSRC_GOV, "userspace"),
+    first(MALI, "power_policy", Val::Lit("coarse_demand")),
+];
+
+const MTK_PERFORMANCE: &[Op] = &[
+    Op::Ppm { limits: "0", boost: "1" },
+    w("/proc/cpufreq/cpufreq_cci_mode", "1"),
+    w("/proc/cpufreq/cpufreq_power_mode", "3"),
+    Op::IfExists("/proc/gpufreq", &[Op::GpufreqOppMax], &[w("/proc/gpufreqv2/fix_target_opp_index", "0")]),
+    w("/sys/devices/system/cpu/eas/enable", "0"),
+    w(MTK_POWER_LIMITED, "ignore_batt_oc 1"),
+    w(MTK_POWER_LIMITED, "ignore_batt_percent 1"),
+    w(MTK_POWER_LIMITED, "ignore_low_batt 1"),
+    w(MTK_POWER_LIMITED, "ignore_thermal_protect 1"),
+    w(MTK_POWER_LIMITED, "ignore_pbm_limited 1"),
+    w("/proc/perfmgr/syslimiter/syslimiter_force_disable", "0"),
+    w("/proc/mtk_batoc_throttling/battery_oc_protect_stop", "stop 1"),
+    w("/sys/kernel/eara_thermal/enable", "0"),
+    w("/sys/devices/platform/10012000.dvfsrc/helio-dvfsrc/dvfsrc_req_ddr_opp", "0"),
+    w("/sys/kernel/helio-dvfsrc/dvfsrc_force_vcore_dvfs_opp", "0"),
+    w("/sys/class/devfreq/mtk-dvfsrc-devfreq/governor", "performance"),
+    w(MTK_DVFSRC_GOV, "performance"),
+    first(MALI, "power_policy", Val::Lit("always_on")),
+];
+
+const MTK_POWERSAVE: &[Op] = &[
+    Op::Ppm { limits: "1", boost: "0" },
+    w("/sys/devices/platform/10012000.dvfsrc/helio-dvfsrc/dvfsrc_req_ddr_opp", "0"),
+    w("/sys/kernel/helio-dvfsrc/dvfsrc_force_vcore_dvfs_opp", "0"),
+    w("/sys/class/devfreq/mtk-dvfsrc-devfreq/governor", "powersave"),
+    w(MTK_DVFSRC_GOV, "powersave"),
+    w(MTK_POWER_LIMITED, "ignore_batt_oc 1"),
+    w(MTK_POWER_LIMITED, "ignore_batt_percent 1"),
+    w(MTK_POWER_LIMITED, "ignore_low_batt 1"),
+    w(MTK_POWER_LIMITED, "ignore_thermal_protect 1"),
+    w(MTK_POWER_LIMITED, "ignore_pbm_limited 1"),
+    w("/proc/perfmgr/syslimiter/syslimiter_force_disable", "0"),
+    w("/proc/mtk_batoc_throttling/battery_oc_protect_stop", "stop 0"),
+    w("/proc/pbm/pbm_stop", "stop 0"),
+    w("/sys/kernel/eara_thermal/enable", "1"),
+    first(MALI, "power_policy", Val::Lit("coarse_demand")),
+];
+
+const QCOM_BALANCE: &[Op] = &[
+    each("/sys/class/devfreq/*cpu-ddr-latfloor*", "governor", Val::Lit("compute")),
+    each("/sys/class/devfreq/*cpu*-lat", "governor", Val::Lit("mem_latency")),
+    each("/sys/class/devfreq/*cpu-cpu-ddr-bw", "governor", Val::Lit("bw_hwmon")),
+    each("/sys/class/devfreq/*cpu-cpu-llcc-bw", "governor", Val::Lit("bw_hwmon")),
+    each("/sys/devices/system/cpu/bus_dcvs/LLCC", "*/max_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/LLCC", "*/min_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/L3", "*/max_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/L3", "*/min_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDR", "*/max_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDR", "*/min_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDRQOS", "*/max_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDRQOS", "*/min_freq", Val::Min("available_frequencies")),
+    each(KGSL, "min_freq", Val::Low("available_frequencies")),
+    each(KGSL, "max_freq", Val::Max("available_frequencies")),
+    each("/sys/class/devfreq/*gpubw*", "governor", Val::Lit("bw_vbif")),
+    w("/sys/class/kgsl/kgsl-3d0/devfreq/adrenoboost", "1"),
+];
+
+const QCOM_PERFORMANCE: &[Op] = &[
+    each("/sys/class/devfreq/*cpu-ddr-latfloor*", "governor", Val::Lit("performance")),
+    each("/sys/class/devfreq/*cpu*-lat", "governor", Val::Lit("performance")),
+    each("/sys/class/devfreq/*cpu-cpu-ddr-bw", "governor", Val::Lit("performance")),
+    each("/sys/class/devfreq/*cpu-cpu-llcc-bw", "governor", Val::Lit("performance")),
+    each("/sys/devices/system/cpu/bus_dcvs/LLCC", "*/max_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/LLCC", "*/min_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/L3", "*/max_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/L3", "*/min_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDR", "*/max_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDR", "*/min_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDRQOS", "*/max_freq", Val::Max("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDRQOS", "*/min_freq", Val::Max("available_frequencies")),
+    // The daemon GPU controller owns min_freq when enabled
+    Op::IfProp(GPUCTL, &[], &[each(KGSL, "min_freq", Val::Max("available_frequencies"))]),
+    each(KGSL, "max_freq", Val::Max("available_frequencies")),
+    each("/sys/class/devfreq/*gpubw*", "governor", Val::Lit("performance")),
+    w("/sys/class/kgsl/kgsl-3d0/devfreq/adrenoboost", "3"),
+];
+
+const QCOM_POWERSAVE: &[Op] = &[
+    each("/sys/class/devfreq/*cpu-ddr-latfloor*", "governor", Val::Lit("powersave")),
+    each("/sys/class/devfreq/*cpu*-lat", "governor", Val::Lit("powersave")),
+    each("/sys/class/devfreq/*cpu-cpu-ddr-bw", "governor", Val::Lit("powersave")),
+    each("/sys/class/devfreq/*cpu-cpu-llcc-bw", "governor", Val::Lit("powersave")),
+    each("/sys/devices/system/cpu/bus_dcvs/LLCC", "*/max_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/LLCC", "*/min_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/L3", "*/max_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/L3", "*/min_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDR", "*/max_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDR", "*/min_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDRQOS", "*/max_freq", Val::Min("available_frequencies")),
+    each("/sys/devices/system/cpu/bus_dcvs/DDRQOS", "*/min_freq", Val::Min("available_frequencies")),
+    each(KGSL, "min_freq", Val::Low("available_frequencies")),
+    each(KGSL, "max_freq", Val::Low("available_frequencies")),
+    each("/sys/class/devfreq/*gpubw*", "governor", Val::Lit("powersave")),
+    w("/sys/class/kgsl/kgsl-3d0/devfreq/adrenoboost", "0"),
+];
+
+const EXYNOS_BALANCE: &[Op] = &[
+    each(EXYNOS_GPU, "gpu_max_clock", Val::Max("gpu_available_frequencies")),
+    each(EXYNOS_GPU, "gpu_min_clock", Val::Min("gpu_available_frequencies")),
+    first(MALI, "power_policy", Val::Lit("coarse_demand")),
+    Op::IfProp(MITIGATION, &[], &[Op::Devfreq { base: MIF, first: false, level: Level::Unlock }]),
+];
+
+const EXYNOS_PERFORMANCE: &[Op] = &[
+    each(EXYNOS_GPU, "gpu_max_clock", Val::Max("gpu_available_frequencies")),
+    Op::IfProp(
+        LITEMODE,
+        &[each(EXYNOS_GPU, "gpu_min_clock", Val::Mid("gpu_available_frequencies"))],
+        &[each(EXYNOS_GPU, "gpu_min_clock", Val::Max("gpu_available_frequencies"))],
+    ),
+    first(MALI, "power_policy", Val::Lit("always_on")),
+    Op::IfProp(
+        MITIGATION,
+        &[],
+        &[Op::IfProp(
+            LITEMODE,
+            &[Op::Devfreq { base: MIF, first: false, level: Level::Mid }],
+            &[Op::Devfreq { base: MIF, first: false, level: Level::Max }],
+        )],
+    ),
+];
+
+const EXYNOS_POWERSAVE: &[Op] = &[
+    each(EXYNOS_GPU, "gpu_min_clock", Val::Min("gpu_available_frequencies")),
+    each(EXYNOS_GPU, "gpu_max_clock", Val::Min("gpu_available_frequencies")),
+];
+
+const UNISOC_BALANCE: &[Op] = &[Op::Devfreq { base: UNISOC_GPU, first: true, level: Level::Unlock }];
+
+const UNISOC_PERFORMANCE: &[Op] = &[Op::IfProp(
+    LITEMODE,
+    &[Op::Devfreq { base: UNISOC_GPU, first: true, level: Level::Mid }],
+    &[Op::Devfreq { base: UNISOC_GPU, first: true, level: Level::Max }],
+)];
+
+const UNISOC_POWERSAVE: &[Op] = &[Op::Devfreq { base: UNISOC_GPU, first: true, level: Level::Min }];
+
+const TENSOR_BALANCE: &[Op] = &[
+    first(MALI, "scaling_max_freq", Val::Max("available_frequencies")),
+    first(MALI, "scaling_min_freq", Val::Min("available_frequencies")),
+    Op::IfProp(MITIGATION, &[], &[Op::Devfreq { base: MIF, first: false, level: Level::Unlock }]),
+];
+
+const TENSOR_PERFORMANCE: &[Op] = &[
+    first(MALI, "scaling_max_freq", Val::Max("available_frequencies")),
+    Op::IfProp(
+        LITEMODE,
+        &[first(MALI, "scaling_min_freq", Val::Mid("available_frequencies"))],
+        &[first(MALI, "scaling_min_freq", Val::Max("available_frequencies"))],
+    ),
+    Op::IfProp(
+        MITIGATION,
+        &[],
+        &[Op::IfProp(
+            LITEMODE,
+            &[Op::Devfreq { base: MIF, first: false, level: Level::Mid }],
+            &[Op::Devfreq { base: MIF, first: false, level: Level::Max }],
+        )],
+    ),
+];
+
+const TENSOR_POWERSAVE: &[Op] = &[
+    first(MALI, "scaling_min_freq", Val::Min("available_frequencies")),
+    first(MALI, "scaling_max_freq", Val::Min("available_frequencies")),
+];
+
+// Keyed by persist.sys.azenithdebug.soctype, which customize.sh sets from the chipset
+static SOC_PROFILES: &[SocProfile] = &[
+    SocProfile { soc: "1", name: "mediatek", balance: MTK_BALANCE, performance: MTK_PERFORMANCE, powersave: MTK_POWERSAVE },
+    SocProfile { soc: "2", name: "snapdragon", balance: QCOM_BALANCE, performance: QCOM_PERFORMANCE, powersave: QCOM_POWERSAVE },
+    SocProfile { soc: "3", name: "exynos", balance: EXYNOS_BALANCE, performance: EXYNOS_PERFORMANCE, powersave: EXYNOS_POWERSAVE },
+    SocProfile { soc: "4", name: "unisoc", balance: UNISOC_BALANCE, performance: UNISOC_PERFORMANCE, powersave: UNISOC_POWERSAVE },
+    SocProfile { soc: "5", name: "tensor", balance: TENSOR_BALANCE, performance: TENSOR_PERFORMANCE, powersave: TENSOR_POWERSAVE },
+];
+
+fn is_pattern(path: &str) -> bool {
+    path.contains(['*', '?', '['])
 }
 
-fn snapdragon_balance() {
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-ddr-latfloor*") {
-        for entry in entries.flatten() {
-            zeshia("compute", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu*-lat") {
-        for entry in entries.flatten() {
-            zeshia("mem_latency", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
+fn expand(pattern: &str, first: bool) -> Vec<String> {
+    if !is_pattern(pattern) {
+        return vec![pattern.to_string()];
     }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-cpu-ddr-bw") {
+    let mut out = Vec::new();
+    if let Ok(entries) = glob::glob(pattern) {
         for entry in entries.flatten() {
-            zeshia("bw_hwmon", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-cpu-llcc-bw") {
-        for entry in entries.flatten() {
-            zeshia("bw_hwmon", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/LLCC").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/LLCC/available_frequencies";
-        let max_freq = which_maxfreq(avail);
-        let min_freq = which_minfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/LLCC/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&max_freq, &entry.to_string_lossy(), true);
+            out.push(entry.to_string_lossy().into_owned());
+            if first {
+                break;
             }
         }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/LLCC/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&min_freq, &entry.to_string_lossy(), true);
-            }
-        }
-    }
-
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/L3").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/L3/available_frequencies";
-        let max_freq = which_maxfreq(avail);
-        let min_freq = which_minfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/L3/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&max_freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/L3/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&min_freq, &entry.to_string_lossy(), true);
-            }
-        }
-    }
-
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/DDR").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/DDR/available_frequencies";
-        let max_freq = which_maxfreq(avail);
-        let min_freq = which_minfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDR/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&max_freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDR/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&min_freq, &entry.to_string_lossy(), true);
-            }
-        }
-    }
-
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/DDRQOS").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/DDRQOS/available_frequencies";
-        let max_freq = which_maxfreq(avail);
-        let min_freq = which_minfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDRQOS/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&max_freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDRQOS/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&min_freq, &entry.to_string_lossy(), true);
-            }
-        }
-    }
-
-    let gpu_path = "/sys/class/kgsl/kgsl-3d0/devfreq";
-    if Path::new(gpu_path).exists() {
-        let avail = format!("{}/available_frequencies", gpu_path);
-        let max_freq = which_maxfreq(&avail);
-        let freqs = get_freqs(&avail);
-        let min_freq = if freqs.len() >= 2 { freqs[1].to_string() } else { which_minfreq(&avail) };
-        zeshia(&min_freq, &format!("{}/min_freq", gpu_path), true);
-        zeshia(&max_freq, &format!("{}/max_freq", gpu_path), true);
-    }
-
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*gpubw*") {
-        for entry in entries.flatten() {
-            zeshia("bw_vbif", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
     }
+    out
+}
 
-    zeshia("1", "/sys/class/kgsl/kgsl-3d0/devfreq/adrenoboost", true);
+fn join(base: &str, file: &str) -> String {
+    if file.is_empty() { base.to_string() } else { format!("{}/{}", base, file) }
 }
 
-fn snapdragon_performance() {
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-ddr-latfloor*") {
-        for entry in entries.flatten() {
-            zeshia("performance", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu*-lat") {
-        for entry in entries.flatten() {
-            zeshia("performance", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-cpu-ddr-bw") {
-        for entry in entries.flatten() {
-            zeshia("performance", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-cpu-llcc-bw") {
-        for entry in entries.flatten() {
-            zeshia("performance", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/LLCC").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/LLCC/available_frequencies";
-        let freq = which_maxfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/LLCC/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/LLCC/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
+fn resolve(val: Val, base: &str) -> String {
+    match val {
+        Val::Lit(v) => v.to_string(),
+        Val::Max(t) => which_maxfreq(&join(base, t)),
+        Val::Min(t) => which_minfreq(&join(base, t)),
+        Val::Mid(t) => which_midfreq(&join(base, t)),
+        Val::Low(t) => {
+            let freqs = get_freqs(&join(base, t));
+            if freqs.len() >= 2 { freqs[1].to_string() } else { which_minfreq(&join(base, t)) }
         }
     }
+}
 
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/L3").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/L3/available_frequencies";
-        let freq = which_maxfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/L3/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/L3/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
+fn ppm_policy(limits: &str, boost: &str) {
+    let Ok(content) = fs::read_to_string("/proc/ppm/policy_status") else { return };
+    for line in content.lines() {
+        let value = if ["FORCE_LIMIT", "PWR_THRO", "THERMAL", "USER_LIMIT"].iter().any(|p| line.contains(p)) {
+            limits
+        } else if line.contains("SYS_BOOST") {
+            boost
+        } else {
+            continue;
+        };
+        if let Some(start) = line.find('[') {
+            if let Some(end) = line[start..].find(']') {
+                zeshia(&format!("{} {}", &line[start + 1..start + end], value), "/proc/ppm/policy_status", true);
             }
         }
     }
+}
 
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/DDR").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/DDR/available_frequencies";
-        let freq = which_maxfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDR/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDR/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
+fn gpufreq_opp_max() {
+    let Ok(content) = fs::read_to_string("/proc/gpufreq/gpufreq_opp_dump") else { return };
+    let max = content
+        .lines()
+        .filter_map(|line| line.find("freq = ").map(|pos| &line[pos + 7..]))
+        .filter_map(|rest| rest.chars().take_while(|c| c.is_ascii_digit()).collect::<String>().parse::<i64>().ok())
+        .max();
+    if let Some(max) = max {
+        zeshia(&max.to_string(), "/proc/gpufreq/gpufreq_opp_freq", true);
     }
+}
 
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/DDRQOS").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/DDRQOS/available_frequencies";
-        let freq = which_maxfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDRQOS/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
+fn run_ops(ops: &[Op]) {
+    for op in ops {
+        match *op {
+            Op::Set { base, first, file, val } => {
+                for b in expand(base, first) {
+                    let value = resolve(val, &b);
+                    for path in expand(&join(&b, file), false) {
+                        zeshia(&value, &path, true);
+                    }
+                }
             }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDRQOS/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
+            Op::Devfreq { base, first, level } => {
+                for b in expand(base, first) {
+                    match level {
+                        Level::Unlock => devfreq_unlock(&b),
+                        Level::Max => devfreq_max_perf(&b),
+                        Level::Mid => devfreq_mid_perf(&b),
+                        Level::Min => devfreq_min_perf(&b),
+                    }
+                }
             }
+            Op::Ppm { limits, boost } => ppm_policy(limits, boost),
+            Op::GpufreqOppMax => gpufreq_opp_max(),
+            Op::IfExists(path, then, other) => run_ops(if Path::new(path).exists() { then } else { other }),
+            Op::IfProp(prop, then, other) => run_ops(if getprop(prop) == "1" { then } else { other }),
         }
     }
-
-    let gpu_path = "/sys/class/kgsl/kgsl-3d0/devfreq";
-    if Path::new(gpu_path).exists() {
-        let avail = format!("{}/available_frequencies", gpu_path);
-        let freq = which_maxfreq(&avail);
-        zeshia(&freq, &format!("{}/min_freq", gpu_path), true);
-        zeshia(&freq, &format!("{}/max_freq", gpu_path), true);
-    }
-
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*gpubw*") {
-        for entry in entries.flatten() {
-            zeshia("performance", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-
-    zeshia("3", "/sys/class/kgsl/kgsl-3d0/devfreq/adrenoboost", true);
 }
 
-fn snapdragon_powersave() {
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-ddr-latfloor*") {
-        for entry in entries.flatten() {
-            zeshia("powersave", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu*-lat") {
-        for entry in entries.flatten() {
-            zeshia("powersave", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-cpu-ddr-bw") {
-        for entry in entries.flatten() {
-            zeshia("powersave", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*cpu-cpu-llcc-bw") {
-        for entry in entries.flatten() {
-            zeshia("powersave", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/LLCC").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/LLCC/available_frequencies";
-        let freq = which_minfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/LLCC/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/LLCC/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
-    }
+fn soc_profile() -> Option<&'static SocProfile> {
+    static PROFILE: OnceLock<Option<&'static SocProfile>> = OnceLock::new();
+    *PROFILE.get_or_init(|| {
+        let soc = getprop("persist.sys.azenithdebug.soctype");
+        SOC_PROFILES.iter().find(|p| p.soc == soc)
+    })
+}
 
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/L3").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/L3/available_frequencies";
-        let freq = which_minfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/L3/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/L3/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
+fn apply_soc_profile(mode: SocMode) {
+    if let Some(profile) = soc_profile() {
+        run_ops(profile.ops(mode));
     }
+}
 
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/DDR").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/DDR/available_frequencies";
-        let freq = which_minfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDR/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
-            }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDR/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
+// Every path pattern an op list can touch, branches included
+fn collect_paths(ops: &[Op], out: &mut Vec<String>) {
+    for op in ops {
+        match *op {
+            Op::Set { base, file, val, .. } => {
+                out.push(join(base, file));
+                if let Val::Max(t) | Val::Min(t) | Val::Mid(t) | Val::Low(t) = val {
+                    out.push(join(base, t));
+                }
             }
-        }
-    }
-
-    if Path::new("/sys/devices/system/cpu/bus_dcvs/DDRQOS").exists() {
-        let avail = "/sys/devices/system/cpu/bus_dcvs/DDRQOS/available_frequencies";
-        let freq = which_minfreq(avail);
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDRQOS/*/max_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
+            Op::Devfreq { base, .. } => {
+                for file in ["available_frequencies", "max_freq", "min_freq"] {
+                    out.push(join(base, file));
+                }
             }
-        }
-        if let Ok(entries) = glob::glob("/sys/devices/system/cpu/bus_dcvs/DDRQOS/*/min_freq") {
-            for entry in entries.flatten() {
-                zeshia(&freq, &entry.to_string_lossy(), true);
+            Op::Ppm { .. } => out.push("/proc/ppm/policy_status".to_string()),
+            Op::GpufreqOppMax => {
+                out.push("/proc/gpufreq/gpufreq_opp_dump".to_string());
+                out.push("/proc/gpufreq/gpufreq_opp_freq".to_string());
             }
-        }
-    }
-
-    let gpu_path = "/sys/class/kgsl/kgsl-3d0/devfreq";
-    if Path::new(gpu_path).exists() {
-        let avail = format!("{}/available_frequencies", gpu_path);
-        let freqs = get_freqs(&avail);
-        let freq = if freqs.len() >= 2 { freqs[1].to_string() } else { which_minfreq(&avail) };
-        zeshia(&freq, &format!("{}/min_freq", gpu_path), true);
-        zeshia(&freq, &format!("{}/max_freq", gpu_path), true);
-    }
-
-    if let Ok(entries) = glob::glob("/sys/class/devfreq/*gpubw*") {
-        for entry in entries.flatten() {
-            zeshia("powersave", &format!("{}/governor", entry.to_string_lossy()), true);
-        }
-    }
-
-    zeshia("0", "/sys/class/kgsl/kgsl-3d0/devfreq/adrenoboost", true);
-}
-
-fn exynos_balance() {
-    let gpu_path = "/sys/kernel/gpu";
-    if Path::new(gpu_path).exists() {
-        let avail = format!("{}/gpu_available_frequencies", gpu_path);
-        let max_freq = which_maxfreq(&avail);
-        let min_freq = which_minfreq(&avail);
-        zeshia(&max_freq, &format!("{}/gpu_max_clock", gpu_path), true);
-        zeshia(&min_freq, &format!("{}/gpu_min_clock", gpu_path), true);
-    }
-
-    if let Ok(mut entries) = glob::glob("/sys/devices/platform/*.mali") {
-        if let Some(Ok(mali_sysfs)) = entries.next() {
-            zeshia("coarse_demand", &format!("{}/power_policy", mali_sysfs.to_string_lossy()), true);
-        }
-    }
-
-    let device_mitigation = getprop("persist.sys.azenithconf.devicemitigation").parse::<i64>().unwrap_or(0);
-    if device_mitigation == 0 {
-        if let Ok(entries) = glob::glob("/sys/class/devfreq/*devfreq_mif*") {
-            for entry in entries.flatten() {
-                devfreq_unlock(&entry.to_string_lossy());
+            Op::IfExists(path, then, other) => {
+                out.push(path.to_string());
+                collect_paths(then, out);
+                collect_paths(other, out);
             }
-        }
-    }
-}
-
-fn exynos_performance() {
-    let gpu_path = "/sys/kernel/gpu";
-    let lite_mode = getprop("persist.sys.azenithconf.litemode").parse::<i64>().unwrap_or(0);
-
-    if Path::new(gpu_path).exists() {
-        let avail = format!("{}/gpu_available_frequencies", gpu_path);
-        let max_freq = which_maxfreq(&avail);
-        zeshia(&max_freq, &format!("{}/gpu_max_clock", gpu_path), true);
-
-        if lite_mode == 1 {
-            let mid_freq = which_midfreq(&avail);
-            zeshia(&mid_freq, &format!("{}/gpu_min_clock", gpu_path), true);
-        } else {
-            zeshia(&max_freq, &format!("{}/gpu_min_clock", gpu_path), true);
-        }
-    }
-
-    if let Ok(mut entries) = glob::glob("/sys/devices/platform/*.mali") {
-        if let Some(Ok(mali_sysfs)) = entries.next() {
-            zeshia("always_on", &format!("{}/power_policy", mali_sysfs.to_string_lossy()), true);
-        }
-    }
-
-    let device_mitigation = getprop("persist.sys.azenithconf.devicemitigation").parse::<i64>().unwrap_or(0);
-    if device_mitigation == 0 {
-        if let Ok(entries) = glob::glob("/sys/class/devfreq/*devfreq_mif*") {
-            for entry in entries.flatten() {
-                if lite_mode == 1 {
-                    devfreq_mid_perf(&entry.to_string_lossy());
-                } else {
-                    devfreq_max_perf(&entry.to_string_lossy());
-                }
+            Op::IfProp(_, then, other) => {
+                collect_paths(then, out);
+                collect_paths(other, out);
             }
         }
     }
 }
 
-fn exynos_powersave() {
-    let gpu_path = "/sys/kernel/gpu";
-    if Path::new(gpu_path).exists() {
-        let avail = format!("{}/gpu_available_frequencies", gpu_path);
-        let min_freq = which_minfreq(&avail);
-        zeshia(&min_freq, &format!("{}/gpu_min_clock", gpu_path), true);
-        zeshia(&min_freq, &format!("{}/gpu_max_clock", gpu_path), true);
-    }
-}
+// Checks the table paths against a sysfs manifest captured on a device, one path per
+// line (e.g. find -L /proc/ppm /proc/gpufreq /sys/class/devfreq ... > manifest)
+fn validate(manifest: Option<&str>, soc: Option<&str>) {
+    let Some(manifest) = manifest else {
+        eprintln!("usage: sys.azenith-profilesettings validate <manifest> [soctype]");
+        std::process::exit(2);
+    };
+    let Ok(content) = fs::read_to_string(manifest) else {
+        eprintln!("cannot read {}", manifest);
+        std::process::exit(2);
+    };
+    let present: Vec<&str> = content.lines().map(|l| l.trim_end_matches('/')).filter(|l| !l.is_empty()).collect();
+    let options = glob::MatchOptions { case_sensitive: true, require_literal_separator: true, require_literal_leading_dot: false };
 
-fn unisoc_balance() {
-    if let Ok(mut entries) = glob::glob("/sys/class/devfreq/*.gpu") {
-        if let Some(Ok(gpu_path)) = entries.next() {
-            devfreq_unlock(&gpu_path.to_string_lossy());
+    let mut missing_total = 0;
+    for profile in SOC_PROFILES.iter().filter(|p| soc.map_or(true, |s| s == p.soc || s == p.name)) {
+        let mut paths = Vec::new();
+        for mode in [SocMode::Balance, SocMode::Performance, SocMode::Powersave] {
+            collect_paths(profile.ops(mode), &mut paths);
         }
-    }
-}
+        let mut seen = HashSet::new();
+        paths.retain(|p| seen.insert(p.clone()));
 
-fn unisoc_performance() {
-    if let Ok(mut entries) = glob::glob("/sys/class/devfreq/*.gpu") {
-        if let Some(Ok(gpu_path)) = entries.next() {
-            let path_str = gpu_path.to_string_lossy();
-            let lite_mode = getprop("persist.sys.azenithconf.litemode").parse::<i64>().unwrap_or(0);
-            if lite_mode == 0 {
-                devfreq_max_perf(&path_str);
-            } else {
-                devfreq_mid_perf(&path_str);
+        let mut missing = 0;
+        for path in paths.iter() {
+            let found = match glob::Pattern::new(path) {
+                Ok(pattern) => present.iter().any(|p| pattern.matches_with(p, options)),
+                Err(_) => false,
+            };
+            if !found {
+                missing += 1;
+                println!("  {}: {}", profile.name, path);
             }
         }
+        println!("{} ({}): {} paths, {} missing", profile.name, profile.soc, paths.len(), missing);
+        missing_total += missing;
     }
-}
-
-fn unisoc_powersave() {
-    if let Ok(mut entries) = glob::glob("/sys/class/devfreq/*.gpu") {
-        if let Some(Ok(gpu_path)) = entries.next() {
-            devfreq_min_perf(&gpu_path.to_string_lossy());
-        }
+    if missing_total > 0 {
+        std::process::exit(1);
     }
 }
 
-fn tensor_balance() {
-    if let Ok(mut entries) = glob::glob("/sys/devices/platform/*.mali") {
-        if let Some(Ok(gpu_path)) = entries.next() {
-            let path_str = gpu_path.to_string_lossy();
-            let avail = format!("{}/available_frequencies", path_str);
-            let max_freq = which_maxfreq(&avail);
-            let min_freq = which_minfreq(&avail);
-            zeshia(&max_freq, &format!("{}/scaling_max_freq", path_str), true);
-            zeshia(&min_freq, &format!("{}/scaling_min_freq", path_str), true);
-        }
-    }
-
-    let device_mitigation = getprop("persist.sys.azenithconf.devicemitigation").parse::<i64>().unwrap_or(0);
-    if device_mitigation == 0 {
-        if let Ok(entries) = glob::glob("/sys/class/devfreq/*devfreq_mif*") {
-            for entry in entries.flatten() {
-                devfreq_unlock(&entry.to_string_lossy());
-            }
-        }
-    }
+struct InitStage {
+    name: &'static str,
+    run: Box<dyn Fn() + Sync>,
 }
 
-fn tensor_performance() {
-    if let Ok(mut entries) = glob::glob("/sys/devices/platform/*.mali") {
-        if let Some(Ok(gpu_path)) = entries.next() {
-            let path_str = gpu_path.to_string_lossy();
-            let avail = format!("{}/available_frequencies", path_str);
-            let max_freq = which_maxfreq(&avail);
-            zeshia(&max_freq, &format!("{}/scaling_max_freq", path_str), true);
-
-            let lite_mode = getprop("persist.sys.azenithconf.litemode").parse::<i64>().unwrap_or(0);
-            if lite_mode == 1 {
-                let mid_freq = which_midfreq(&avail);
-                zeshia(&mid_freq, &format!("{}/scaling_min_freq", path_str), true);
-            } else {
-                zeshia(&max_freq, &format!("{}/scaling_min_freq", path_str), true);
-            }
-        }
-    }
-
-    let device_mitigation = getprop("persist.sys.azenithconf.devicemitigation").parse::<i64>().unwrap_or(0);
-    if device_mitigation == 0 {
-        let lite_mode = getprop("persist.sys.azenithconf.litemode").parse::<i64>().unwrap_or(0);
-        if let Ok(entries) = glob::glob("/sys/class/devfreq/*devfreq_mif*") {
-            for entry in entries.flatten() {
-                if lite_mode == 1 {
-                    devfreq_mid_perf(&entry.to_string_lossy());
-                } else {
-                    devfreq_max_perf(&entry.to_string_lossy());
+// Runs the stages on up to `workers` threads, each stage stays on one thread so its writes keep their order
+fn run_stages(stages: &[InitStage], workers: usize) -> Vec<Duration> {
+    let next = AtomicUsize::new(0);
+    let times = Mutex::new(vec![Duration::ZERO; stages.len()]);
+    thread::scope(|s| {
+        for _ in 0..workers.clamp(1, stages.len().max(1)) {
+            s.spawn(|| loop {
+                let i = next.fetch_add(1, Ordering::Relaxed);
+                if i >= stages.len() {
+                    break;
                 }
-            }
+                let start = Instant::now();
+                (stages[i].run)();
+                times.lock().unwrap()[i] = start.elapsed();
+            });
         }
-    }
+    });
+    times.into_inner().unwrap()
 }
 
-fn tensor_powersave() {
-    if let Ok(mut entries) = glob::glob("/sys/devices/platform/*.mali") {
-        if let Some(Ok(gpu_path)) = entries.next() {
-            let path_str = gpu_path.to_string_lossy();
-            let avail = format!("{}/available_frequencies", path_str);
-            let freq = which_minfreq(&avail);
-            zeshia(&freq, &format!("{}/scaling_min_freq", path_str), true);
-            zeshia(&freq, &format!("{}/scaling_max_freq", path_str), true);
-        }
+fn init_workers() -> usize {
+    if getprop("persist.sys.azenithconf.serialinit") == "1" {
+        return 1;
     }
+    thread::available_parallelism().map(|n| n.get()).unwrap_or(1).min(4)
 }
 
-fn initialize() {
+fn init_sched() {
     let params = ["hung_task_timeout_secs", "panic_on_oom", "panic_on_oops", "panic", "softlockup_panic"];
     for param in params.iter() {
         zeshia("0", &format!("/proc/sys/kernel/{}", param), true);
@@ -1323,11 +1178,16 @@ fn initialize() {
     zeshia("750000", "/proc/sys/kernel/sched_migration_cost_ns", true);
     zeshia("1000000", "/proc/sys/kernel/sched_min_granularity_ns", true);
     zeshia("600000", "/proc/sys/kernel/sched_wakeup_granularity_ns", true);
+    zeshia("255", "/proc/sys/kernel/sched_lib_mask_force", true);
+}
+
+fn init_vm() {
     zeshia("0", "/proc/sys/vm/page-cluster", true);
     zeshia("20", "/proc/sys/vm/stat_interval", true);
     zeshia("0", "/proc/sys/vm/compaction_proactiveness", true);
-    zeshia("255", "/proc/sys/kernel/sched_lib_mask_force", true);
+}
 
+fn init_devfreq() {
     let _mali_supported = false;
     let mut default_maligov = String::new();
     if let Ok(mut entries) = glob::glob("/sys/devices/platform/soc/*.mali/devfreq/*.mali/governor") {
@@ -1361,6 +1221,11 @@ fn initialize() {
         setprop("sys.azenith.maligovsupport", "0");
     }
 
+    apply_malisched();
+    apply_fpsged();
+}
+
+fn init_cpufreq() {
     let cpu0_gov_path = "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor";
     let mut default_cpu_gov = fs::read_to_string(cpu0_gov_path).unwrap_or_default().trim().to_string();
     setprop("persist.sys.azenith.default_cpu_gov", &default_cpu_gov);
@@ -1393,6 +1258,12 @@ fn initialize() {
     }
     dlog("Parsing CPU Governor complete");
 
+    // Tunables only exist once the governor above is active
+    apply_schedtunes();
+    apply_walttunes();
+}
+
+fn init_io() {
     let mut valid_io = String::new();
     let devs = ["mmcblk0", "mmcblk1", "sda", "sdb", "sdc"];
     for dev in devs.iter() {
@@ -1433,10 +1304,18 @@ fn initialize() {
             dlog("Parsing IO Scheduler complete");
         }
     }
+}
 
+fn init_display() {
     parse_resolution();
-    apply_init_logic();
 
+    apply_sfl();
+
+    let vsync_value = getprop("persist.sys.azenithconf.vsync");
+    let _ = Command::new("sys.azenith-utilityconf").arg("disablevsync").arg(&vsync_value).output();
+}
+
+fn init_services() {
     if getprop("persist.sys.azenithconf.disabletrace") == "1" {
         dlog("Applying disable trace");
         let traces = ["/sys/kernel/tracing/instances/mmstat/trace", "/sys/kernel/tracing/trace"];
@@ -1460,14 +1339,37 @@ fn initialize() {
         }
     }
 
-    let vsync_value = getprop("persist.sys.azenithconf.vsync");
-    let _ = Command::new("sys.azenith-utilityconf").arg("disablevsync").arg(&vsync_value).output();
-
     let _ = Command::new("sys.azenith-utilityconf").arg("checkBypass").output();
+}
+
+// Slowest first, they are picked up in this order
+fn init_stages() -> Vec<InitStage> {
+    vec![
+        InitStage { name: "display", run: Box::new(init_display) },
+        InitStage { name: "thermal", run: Box::new(apply_dthermal) },
+        InitStage { name: "services", run: Box::new(init_services) },
+        InitStage { name: "cpufreq", run: Box::new(init_cpufreq) },
+        InitStage { name: "devfreq", run: Box::new(init_devfreq) },
+        InitStage { name: "io", run: Box::new(init_io) },
+        InitStage { name: "sched", run: Box::new(init_sched) },
+        InitStage { name: "vm", run: Box::new(init_vm) },
+    ]
+}
+
+fn initialize() {
+    let stages = init_stages();
+    let workers = init_workers();
+    let start = Instant::now();
+    let times = run_stages(&stages, workers);
+    for (stage, time) in stages.iter().zip(times.iter()) {
+        az_log(&format!("Init stage {} took {} ms", stage.name, time.as_millis()));
+    }
+
     let _ = Command::new("sync").output();
 
-    az_log("Initializing Complete");
-    dlog("Initializing Complete");
+    let summary = format!("Initializing Complete in {} ms on {} threads", start.elapsed().as_millis(), workers);
+    az_log(&summary);
+    dlog(&summary);
 }
 
 fn performance_profile() {
@@ -1524,10 +1426,6 @@ fn performance_profile() {
         }
     }
 
-    if getprop("persist.sys.azenithconf.bypasschg") == "1" {
-        let _ = Command::new("sys.azenith-utilityconf").arg("enableBypass").output();
-    }
-
     if Path::new("/proc/ppm").exists() {
         setgamefreqppm();
     } else {
@@ -1575,14 +1473,7 @@ fn performance_profile() {
     }
 
     if litemode == 0 {
-        match getprop("persist.sys.azenithdebug.soctype").as_str() {
-            "1" => mediatek_performance(),
-            "2" => snapdragon_performance(),
-            "3" => exynos_performance(),
-            "4" => unisoc_performance(),
-            "5" => tensor_performance(),
-            _ => {}
-        }
+        apply_soc_profile(SocMode::Performance);
     }
     az_log("Performance Profile Applied Successfully!");
 }
@@ -1624,10 +1515,6 @@ fn balanced_profile() {
         dlog(&format!("Applying GPU Mali Governor to : {}", default_maligov));
     }
 
-    if getprop("persist.sys.azenithconf.bypasschg") == "1" {
-        let _ = Command::new("sys.azenith-utilityconf").arg("disableBypass").output();
-    }
-
     if Path::new("/proc/ppm").exists() {
         setfreqppm();
     } else {
@@ -1668,14 +1555,7 @@ fn balanced_profile() {
     zeshia("1", "/proc/sys/kernel/split_lock_mitigate", true);
     apply_sched_features(&["NEXT_BUDDY", "TTWU_QUEUE"]);
 
-    match getprop("persist.sys.azenithdebug.soctype").as_str() {
-        "1" => mediatek_balance(),
-        "2" => snapdragon_balance(),
-        "3" => exynos_balance(),
-        "4" => unisoc_balance(),
-        "5" => tensor_balance(),
-        _ => {}
-    }
+    apply_soc_profile(SocMode::Balance);
 
     az_log("Balanced Profile applied successfully!");
 }
@@ -1712,10 +1592,6 @@ fn eco_mode() {
     }
     dlog("Set CPU freq to low Frequencies");
 
-    if getprop("persist.sys.azenithconf.bypasschg") == "1" {
-        let _ = Command::new("sys.azenith-utilityconf").arg("disableBypass").output();
-    }
-
     for pl in glob::glob("/sys/devices/system/cpu/perf/*").unwrap().flatten() {
         let p = pl.to_string_lossy();
         if p.ends_with("gpu_pmu_enable") || p.ends_with("fuel_gauge_enable") || p.ends_with("enable") {
@@ -1744,14 +1620,7 @@ fn eco_mode() {
     zeshia("1", "/proc/sys/kernel/split_lock_mitigate", true);
     apply_sched_features(&["NO_NEXT_BUDDY", "NO_TTWU_QUEUE"]);
 
-    match getprop("persist.sys.azenithdebug.soctype").as_str() {
-        "1" => mediatek_powersave(),
-        "2" => snapdragon_powersave(),
-        "3" => exynos_powersave(),
-        "4" => unisoc_powersave(),
-        "5" => tensor_powersave(),
-        _ => {}
-    }
+    apply_soc_profile(SocMode::Powersave);
 
     az_log("ECO Mode applied successfully!");
 }
@@ -1765,13 +1634,74 @@ fn main() {
             "1" => performance_profile(),
             "2" => balanced_profile(),
             "3" => eco_mode(),
+            "maintenance" => maintenance(),
+            "validate" => validate(args.get(2).map(|s| s.as_str()), args.get(3).map(|s| s.as_str())),
+            "bench-init" => bench_init(args.get(2).map(|s| s.as_str())),
             _ => {
                 // Ignore other args
             }
         }
     }
 }
-fn apply_init_logic() {
+
+// Mock sysfs stages shaped like the real ones: node writes plus one blocking subprocess each
+fn bench_stages(root: &str) -> Vec<InitStage> {
+    let shapes: [(&'static str, usize, &'static str); 8] = [
+        ("display", 4, "0.15"),
+        ("thermal", 16, "0.1"),
+        ("services", 8, "0.1"),
+        ("cpufreq", 64, "0.02"),
+        ("devfreq", 24, "0.02"),
+        ("io", 30, "0"),
+        ("sched", 9, "0"),
+        ("vm", 3, "0"),
+    ];
+    shapes
+        .iter()
+        .map(|&(name, nodes, sleep)| {
+            let dir = format!("{}/{}", root, name);
+            let _ = fs::create_dir_all(&dir);
+            let paths: Vec<String> = (0..nodes).map(|i| format!("{}/node{}", dir, i)).collect();
+            for path in paths.iter() {
+                let _ = fs::write(path, "0");
+            }
+            InitStage {
+                name,
+                run: Box::new(move || {
+                    for (i, path) in paths.iter().enumerate() {
+                        zeshia(&i.to_string(), path, false);
+                    }
+                    let _ = Command::new("sleep").arg(sleep).output();
+                }),
+            }
+        })
+        .collect()
+}
+
+fn bench_init(root: Option<&str>) {
+    let root = root.unwrap_or("/data/local/tmp/azenith-bench");
+    let stages = bench_stages(root);
+    // Same cap as init, the stages mostly wait on the kernel or a child so cores don't bound it
+    let workers = 4;
+
+    let start = Instant::now();
+    let serial_times = run_stages(&stages, 1);
+    let serial = start.elapsed();
+
+    let start = Instant::now();
+    let pooled_times = run_stages(&stages, workers);
+    let pooled = start.elapsed();
+
+    for (i, stage) in stages.iter().enumerate() {
+        println!("{:<10} {:>6} ms {:>6} ms", stage.name, serial_times[i].as_millis(), pooled_times[i].as_millis());
+    }
+    println!("serial {} ms, {} threads {} ms, speedup {:.2}x", serial.as_millis(), workers, pooled.as_millis(),
+        serial.as_secs_f64() / pooled.as_secs_f64().max(f64::EPSILON));
+    let _ = fs::remove_dir_all(root);
+}
+
+// Deferred by the daemon until its first profile is applied, runs in the background
+fn maintenance() {
     let justintime_state = getprop("persist.sys.azenithconf.justintime").parse::<i64>().unwrap_or(0);
     if justintime_state == 1 {
         dlog("Applying JIT Compiler");
@@ -1780,13 +1710,16 @@ fn apply_init_logic() {
             for line in s.lines() {
                 if let Some(pos) = line.find(':') {
                     let pkg = &line[pos + 1..];
-                    let _ = Command::new("cmd").args(&["package", "compile", "-m", "speed-profile", pkg]).spawn();
+                    // One compile at a time, spawning them all at once starves the foreground app
+                    let _ = Command::new("cmd").args(&["package", "compile", "-m", "speed-profile", pkg]).output();
                     az_log(&format!("{} | Success", pkg));
                 }
             }
         }
     }
+}
 
+fn apply_schedtunes() {
     let schedtunes_state = getprop("persist.sys.azenithconf.schedtunes").parse::<i64>().unwrap_or(0);
     if schedtunes_state == 1 {
         dlog("Applying Schedtunes for Schedutil and Schedhorizon");
@@ -1837,7 +1770,9 @@ fn apply_init_logic() {
             }
         }
     }
+}
 
+fn apply_walttunes() {
     let walt_state = getprop("persist.sys.azenithconf.walttunes").parse::<i64>().unwrap_or(0);
     if walt_state == 1 {
         dlog("Applying WALT governor tuning");
@@ -1884,7 +1819,9 @@ fn apply_init_logic() {
             }
         }
     }
+}
 
+fn apply_fpsged() {
     let fpsged_state = getprop("persist.sys.azenithconf.fpsged").parse::<i64>().unwrap_or(0);
     if fpsged_state == 1 {
         dlog("Applying FPSGO Parameters");
@@ -1917,7 +1854,9 @@ fn apply_init_logic() {
         zeshia("1", "/sys/pnpmgr/install", true);
         zeshia("100", "/sys/kernel/ged/hal/gpu_boost_level", true);
     }
+}
 
+fn apply_malisched() {
     let malisched_state = getprop("persist.sys.azenithconf.malisched").parse::<i64>().unwrap_or(0);
     if malisched_state == 1 {
         dlog("Applying GPU Mali Sched");
@@ -1932,7 +1871,9 @@ fn apply_init_logic() {
             }
         }
     }
+}
 
+fn apply_sfl() {
     let sfl_state = getprop("persist.sys.azenithconf.SFL").parse::<i64>().unwrap_or(0);
     if sfl_state == 1 {
         dlog("Applying SurfaceFlinger Latency");
@@ -2106,7 +2047,9 @@ fn apply_init_logic() {
         let _ = Command::new("resetprop").args(&["-n", "debug.hwui.skip_eglmanager_telemetry", "true"]).output();
         let _ = Command::new("resetprop").args(&["-n", "debug.hwui.level", "0"]).output();
     }
+}
 
+fn apply_dthermal() {
     let dthermal_state = getprop("persist.sys.azenithconf.DThermal").parse::<i64>().unwrap_or(0);
     if dthermal_state == 1 {
         let _ = Command::new("pkill").arg("-f").arg("thermald").output();
@@ -3,6 +3,7 @@ use std::io::Write;
 use std::os::unix::fs::PermissionsExt;
 use std::process::Command;
 use std::path::Path;
+use std::time::{Duration, Instant};
 
 fn getprop(prop_name: &str) -> String {
     if let Ok(output) = Command::new("getprop").arg(prop_name).output() {
@@ -273,6 +274,28 @@ fn read_current_ma() -> i32 {
     9999
 }
 
+// Streams current samples until `samples` consecutive readings are at or
+// below `limit_ma`, or the timeout passes. Returns the verdict and last sample.
+fn wait_current_below(limit_ma: i32, samples: u32, timeout: Duration) -> (bool, i32) {
+    let deadline = Instant::now() + timeout;
+    let mut good = 0;
+    loop {
+        let cur_ma = read_current_ma();
+        if cur_ma <= limit_ma {
+            good += 1;
+            if good >= samples {
+                return (true, cur_ma);
+            }
+        } else {
+            good = 0;
+        }
+        if Instant::now() >= deadline {
+            return (false, cur_ma);
+        }
+        std::thread::sleep(Duration::from_millis(100));
+    }
+}
+
 fn ischarging() -> bool {
     if let Ok(content) = fs::read_to_string("/sys/class/power_supply/battery/status") {
         let status = content.trim();
@@ -320,25 +343,23 @@ fn enable_bypass() -> bool {
         return false;
     }
 
-    let max_try = 5;
+    let max_try = 3;
     let mut current_try = 0;
 
     while current_try < max_try {
         current_try += 1;
 
         zeshia(&onval, &path, true);
-        std::thread::sleep(std::time::Duration::from_secs(1));
 
         let cur_val = fs::read_to_string(&path).unwrap_or_default().trim().to_string();
-        let cur_ma = read_current_ma();
+        let (active, cur_ma) = wait_current_below(10, 3, Duration::from_millis(1500));
 
         az_log(&format!("Bypass check [{}]: path={} current={}mA", current_try, cur_val, cur_ma));
 
-        if cur_val == onval && cur_ma <= 10 {
+        if cur_val == onval && active {
             dlog(&format!("Bypass active, current {}mA", cur_ma));
             return true;
         }
-        std::thread::sleep(std::time::Duration::from_secs(1));
     }
 
     let cur_ma = read_current_ma();
@@ -389,15 +410,11 @@ fn check_bypass() -> bool {
         dlog(&format!("Testing bypass charging path: {}", name));
 
         zeshia(&on_val, path, true);
-        std::thread::sleep(std::time::Duration::from_secs(1));
-
-        let cur_ma = read_current_ma();
+        let (active, cur_ma) = wait_current_below(9, 3, Duration::from_millis(1500));
         dlog(&format!("Charging current: {}mA", cur_ma));
-
         zeshia(&off_val, path, true);
-        std::thread::sleep(std::time::Duration::from_secs(1));
 
-        if cur_ma < 10 {
+        if active {
             dlog(&format!("Bypass Charging SUPPORTED via {}", name));
             setprop("persist.sys.azenithconf.bypasspath", name);
             return true;
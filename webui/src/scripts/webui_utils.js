@@ -46,6 +46,7 @@ const PERAPP_SETTINGS = {
   game_preload: "default",
   refresh_rate: "default",
   renderer: "default",
+  net_latency: "default",
 };
 
 const PERAPP_SCHEMA = [
@@ -53,6 +54,7 @@ const PERAPP_SCHEMA = [
   { key: "dnd_on_gaming", label: "Do Not Disturb", type: "tri" },
   { key: "app_priority", label: "App Priority", type: "tri" },
   { key: "game_preload", label: "Game Preload", type: "tri" },
+  { key: "net_latency", label: "Low Latency Network", type: "tri" },
   {
     key: "renderer",
     label: "Renderer",